@@ -1,10 +1,28 @@
 #ifndef CG_CGAZ_H
 #define CG_CGAZ_H
 
+typedef struct
+{
+  float d_min;
+  float d_opt;
+  float d_max_cos;
+  float d_max;
+} cgazZones_t;
+
 void init_cgaz(void);
 
 void update_cgaz(void);
 
 void draw_cgaz(void);
 
+// Angles between velocity and wishdir bounding the zones when accelerating from a horizontal speed of
+// sqrt(v_squared) to sqrt(vf_squared) with an acceleration of a (ups per frame).
+void update_cgaz_zones(
+  cgazZones_t* z,
+  float        v_squared,
+  float        vf_squared,
+  float        wishspeed,
+  float        a,
+  float        slickGravity);
+
 #endif // CG_CGAZ_H
@@ -1,12 +1,59 @@
 #ifndef CG_ENTITY_H
 #define CG_ENTITY_H
 
+#include "cg_public.h"
+
 #include <stdint.h>
 
+typedef struct
+{
+  int32_t              count;
+  entityState_t const* entities[MAX_ENTITIES_IN_SNAPSHOT];
+} entityList_t;
+
+// Identifies one lifetime of an entity number, a respawned entity gets a new handle.
+typedef int32_t entityHandle_t;
+
+#define ENTITY_HANDLE_NUMBER(handle)     ((handle) & (MAX_GENTITIES - 1))
+#define ENTITY_HANDLE_GENERATION(handle) ((handle) >> GENTITYNUM_BITS)
+
+typedef enum
+{
+  ENTITY_SPAWNED, // entered the snapshot
+  ENTITY_CHANGED, // still in the snapshot, but its state differs from the previous one
+  ENTITY_REMOVED  // left the snapshot, state is the last one seen
+} entityEventType_t;
+
+typedef struct
+{
+  entityEventType_t    type;
+  entityHandle_t       handle;
+  entityState_t const* state;
+  int32_t              serverTime; // of the snapshot which caused the event
+} entityEvent_t;
+
+typedef void (*entityListener_t)(entityEvent_t const* event);
+
 void init_entityStates(void);
 
+// Unsubscribes all listeners.
+void del_entityStates(void);
+
 void update_entityStates(void);
 
+// The entity index is rebuilt once per new snapshot, all returned pointers stay valid until then.
+entityState_t const* entity_by_number(int32_t number); // NULL when not in the current snapshot
+entityHandle_t       entity_handle(int32_t number);    // handle of the current (or last) lifetime
+
+entityList_t const* own_grenades(void);
+entityList_t const* own_rockets(void);
+entityList_t const* all_missiles(void);
+
+// Listeners are called while the index is rebuilt, i.e. once for each entity that spawned, changed or got removed
+// between two consecutive snapshots. Subscribing the same listener twice has no effect.
+void subscribe_entityEvents(entityListener_t listener);
+
+// Uses the owners seen up to the last update_entityStates.
 int8_t should_filter_sound(int entity_num, int8_t is_loop);
 
 #endif // CG_ENTITY_H
@@ -1,10 +1,39 @@
 #ifndef CG_SNAP_H
 #define CG_SNAP_H
 
+#define MAX_SNAPHUD_ZONES_Q1                                                                                           \
+  101 // Max nb of snapzones in 1 quadrant
+      // => round(2.56 * 15 * 1.3) * 2 + 1 = 101
+      //                 ^^   ^^^
+      //                CPM   HASTE
+
+typedef struct
+{
+  unsigned char maxAccel; // Max accel defined as
+                          // => maxAccel = round(sAT)
+  // edges in radians, zone i + 1 spans from zones[i] to zones[i + 1]
+  float         zones[MAX_SNAPHUD_ZONES_Q1];
+  unsigned char xAccel[MAX_SNAPHUD_ZONES_Q1];
+  unsigned char yAccel[MAX_SNAPHUD_ZONES_Q1];
+  float         absAccel[MAX_SNAPHUD_ZONES_Q1];
+  float         minAbsAccel;
+  float         maxAbsAccel;
+} snapZones_t;
+
 void init_snap(void);
 
 void update_snap(void);
 
 void draw_snap(void);
 
+// Snapzones of the first quadrant for an acceleration of a (ups per frame), 0 < a <= 50. The edges are computed in
+// floating point, SIMD_WIDTH at a time (see simd.h).
+void update_snap_zones(snapZones_t* z, float a);
+
+// Nb of accelerations whose zones are kept, the hud switches between a few (ground, air, CPM, haste, walking).
+#define SNAP_ZONES_CACHED 16
+
+// update_snap_zones memoized per a, once the cache is full the oldest zones are replaced.
+snapZones_t const* snap_zones(float a);
+
 #endif // CG_SNAP_H
@@ -2,11 +2,38 @@
 #define CG_SYSCALL_H
 
 #include "ExportImport.h"
+#include "q_shared.h"
 
+#include <stdarg.h>
 #include <stdint.h>
 
+// Number of arguments an engine syscall is called with, like the engine's VM_DllSyscall reads them.
+#define SYSCALL_ARGS 15
+
 EXPORTIMPORT void dllEntry(intptr_t(QDECL* syscallptr)(intptr_t arg, ...));
 
-intptr_t QDECL CG_SysCalls(uint8_t* memoryBase, int32_t cmd, int32_t* args);
+// Recording mode of the syscall shim, see syscall_log.h.
+void start_syscall_recording(void);
+void stop_syscall_recording(void);
+
+// Whether the traps go through the statistics, see syscall_stats.h.
+void sample_syscalls(qboolean sample);
+
+// Whether the expensive syscalls are spanned, see profile.h.
+void profile_syscalls(qboolean profile);
+
+// Whether frame costs are measured, see perf.h.
+void measure_syscalls(qboolean measure);
+
+char const* syscall_name(intptr_t cmd);
+
+// For the interposers in the syscall chain: reads the arguments of the variadic call and passes them on to next.
+void     read_syscall_args(va_list ap, intptr_t* args);
+intptr_t forward_syscall(intptr_t(QDECL* next)(intptr_t, ...), intptr_t cmd, intptr_t const* args);
+
+struct vm_s;
+
+// Passes a syscall of the qvm run by vm on to the engine, translating its qvm addresses.
+intptr_t QDECL CG_SysCalls(struct vm_s* vm, int32_t cmd, int32_t* args);
 
 #endif // CG_SYSCALL_H
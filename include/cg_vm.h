@@ -25,7 +25,32 @@
 
 #include "q_shared.h"
 
-#define VM_MAGIC 0x12721444
+#include <stddef.h>
+
+#define VM_MAGIC      0x12721444
+#define VM_MAGIC_VER2 0x12721445 // with a jump table after the lit segment
+
+// On 64-bit unix VM_Create reserves the 4 GB a qvm address can reach behind the data segment, with everything past
+// the stack left inaccessible, so data accesses don't need the mask to stay inside the vm's memory. An out of range
+// access faults instead of wrapping around. Configure with -DVM_GUARD_PAGES=OFF for the masked memory.
+#if !defined(VM_NO_GUARD_PAGES) && defined(__unix__) && UINTPTR_MAX > 0xFFFFFFFFu
+#  define VM_GUARD_PAGES
+#endif
+
+// offset into the data segment of a qvm address, mask = dataSegmentMask
+#ifdef VM_GUARD_PAGES
+#  define VM_ADDRESS(address, mask) ((void)(mask), (uint32_t)(address))
+#else
+#  define VM_ADDRESS(address, mask) ((address) & (mask))
+#endif
+
+// The interpreters are inlined into a counting and a non-counting copy, which the compiler has to do even without
+// optimizations.
+#ifdef _MSC_VER
+#  define VM_FORCE_INLINE __forceinline
+#else
+#  define VM_FORCE_INLINE inline __attribute__((always_inline))
+#endif
 
 typedef enum
 {
@@ -104,8 +129,19 @@ typedef struct
   int32_t dataLength;
   int32_t litLength; // ( dataLength - litLength ) should be byteswapped on load
   int32_t bssLength; // zero filled memory appended to datalength
+
+  // VM_MAGIC_VER2 only, not part of older headers
+  int32_t jtrgLength; // size of the jump table: the instruction indices computed jumps may go to
 } vmHeader_t;
 
+// size of a VM_MAGIC header, which ends before jtrgLength
+#define VM_HEADER_SIZE_VER1 ((int32_t)offsetof(vmHeader_t, jtrgLength))
+// jump table size of a validated header
+#define VM_JUMP_TABLE_LENGTH(header) ((header)->vmMagic == VM_MAGIC_VER2 ? (header)->jtrgLength : 0)
+
+struct vmAot_s;
+struct vmHooks_s;
+
 typedef struct vm_s
 {
   /* public interface */
@@ -117,8 +153,9 @@ typedef struct vm_s
   byte*    stackSegment; /* stack segment */
 
   /* status*/
-  int32_t codeSegmentLen; /* size of codeSegment */
-  int32_t dataSegmentLen; /* size of dataSegment */
+  int32_t codeSegmentLen;  /* size of codeSegment */
+  int32_t dataSegmentLen;  /* size of dataSegment */
+  int32_t stackSegmentLen; /* size of stackSegment */
   int32_t dataSegmentMask;
 
   /* registers */
@@ -126,18 +163,44 @@ typedef struct vm_s
   int32_t* opStack;
   int32_t  opBase;
 
+  /* jump table of a VM_MAGIC_VER2 qvm (NULL otherwise), valid targets of computed jumps */
+  int32_t* jumpTargets;
+  int32_t  numJumpTargets;
+
   /* memory */
   int32_t memorySize;
   byte*   memory;
 
   /* non-API function hooking */
-  int32_t hook_realfunc; /* address for a VM function to call after a hook completes (0 = don't call) */
+  int32_t  hook_realfunc; /* address for a VM function to call after a hook completes (0 = don't call) */
+  uint8_t* hookFlags;     /* instructions with native hooks attached, see vm_hook.h */
+
+  /* the table behind hookFlags */
+  struct vmHooks_s* hooks;
+
+  /* translation to C run instead of VM_Run, see vm_aot.h (NULL = interpret) */
+  struct vmAot_s const* aot;
+  qboolean              cacheTos; /* run VM_RunTos instead of VM_Run, see vm_tos.h */
+
+  /* engine its syscalls go to (NULL = the proxy's, through the recorder, the statistics and the profilers) */
+  intptr_t(QDECL* engine)(intptr_t, ...);
+
+  /* statistics */
+  qboolean countInstructions;    /* count into instructionsExecuted, off for players since it costs every instruction */
+  uint64_t instructionsExecuted; /* by VM_Run and VM_RunTos, not by translations */
+  /* where the interpreter publishes its pc for mdd_vm_sample (NULL = not sampled) */
+  int32_t const* volatile* samplePc;
 } vm_t;
 
-extern vm_t    g_VM;
-extern char    vmpath[MAX_QPATH];
-extern char    vmbase[16];
-extern int32_t vm_stacksize;
+// Bare vms, laid out in memory without VM_Create, can run on different threads at once: the functions below only work
+// on the vm they are passed. Their syscalls must go to their own engine, the proxy's syscall chain and VM_Create (which
+// loads through the proxy's engine) are single-instance.
+// g_VM is the proxy's own, the one callVM runs and the one VM_ArgPtr is used on by the hud.
+extern vm_t     g_VM;
+extern char     vmpath[MAX_QPATH];
+extern char     vmbase[16];
+extern int32_t  vm_stacksize;          // of the vms VM_Create loads
+extern qboolean vm_count_instructions; // whether initVM sets g_VM.countInstructions
 
 intptr_t QDECL VM_Exec(
   vm_t*   vm,
@@ -155,8 +218,45 @@ intptr_t QDECL VM_Exec(
   int32_t arg10,
   int32_t arg11);
 qboolean VM_Create(vm_t* vm, char const* path, byte* oldmem);
+// The loading steps of VM_Create, without the setup for the defrag version: streams path into vm and sets *crc32sum
+// to the checksum of the whole file.
+qboolean VM_Load(vm_t* vm, char const* path, byte* oldmem, uint32_t* crc32sum);
+// Loading steps of VM_Create, shared with qvmtool. Returns NULL or why the image is invalid, byte swaps the header.
+// jtrgLength is only read (and swapped) for VM_MAGIC_VER2.
+char const* VM_ValidateHeader(vmHeader_t* header, int32_t fileSize, qboolean* swapped);
+// Size in bytes of the parameter following op in the image: 0, 1 (OP_ARG) or 4.
+int32_t VM_ParamSize(vmOps_t op);
+// Decodes the complete instructions in src[0, len), at most count, to codeSegment (2 ints each: opcode, param).
+// Returns the number of bytes used, *decoded is set to the number of instructions.
+int32_t VM_DecodeInstructions(
+  int32_t*    codeSegment,
+  int32_t     count,
+  byte const* src,
+  int32_t     len,
+  qboolean    swapped,
+  int32_t*    decoded);
+// Decodes the code segment of a validated image, qfalse when it's truncated.
+qboolean VM_LoadInstructions(int32_t* codeSegment, vmHeader_t const* header, qboolean swapped);
+// Marks the instructions starting a basic block in blocks (a bitmap over instruction indices, cleared by the caller):
+// the first one, function entries, branch and constant jump targets, the instructions following a branch, jump, call
+// or leave, and the possible targets of computed jumps. These are the jumpTargets of a VM_MAGIC_VER2 image, older
+// ones have to pass every int of their data section, where q3lcc puts its switch tables. Any other instruction is
+// only reached from the one before it. Out of range targets are ignored.
+void VM_FindBlocks(
+  uint32_t*      blocks,
+  int32_t const* codeSegment,
+  int32_t        count,
+  int32_t const* jumpTargets,
+  int32_t        numJumpTargets);
+#define VM_IS_BLOCK(blocks, i) (((blocks)[(i) >> 5] >> ((i)&31)) & 1)
+// crc32_update(0, ...) starts a checksum, crc32_reflect checksums a single buffer.
+uint32_t crc32_update(uint32_t crc, byte const* buf, int32_t len);
+uint32_t crc32_reflect(byte const* buf, int32_t len);
 void     VM_Destroy(vm_t* vm);
 qboolean VM_Restart(vm_t* vm, qboolean savemem);
-void*    VM_ArgPtr(int32_t intValue);
+void*    VM_ArgPtr(vm_t const* vm, int32_t intValue);
+// OP_BLOCK_COPY of the interpreters and translations: copies n bytes within the data segment and the stack, trap_Error
+// when they don't fit or n isn't a multiple of 4.
+void VM_BlockCopy(vm_t* vm, int32_t to, int32_t from, int32_t n);
 
 #endif // CG_VM_H
@@ -0,0 +1,25 @@
+#ifndef NADE_PATH_H
+#define NADE_PATH_H
+
+#include "q_shared.h"
+
+typedef struct
+{
+  // Called every sample interval, origin is the trajectory evaluated at time.
+  void (*sample)(void* data, int32_t time, vec3_t const origin);
+  // Called after every bounce with the reflected and damped trajectory.
+  void (*bounce)(void* data, trajectory_t const* pos);
+  void* data;
+} nadePathVisitor_t;
+
+// Follows a grenade trajectory until end_time, bouncing like G_BounceMissile.
+// Bounces are resolved to the same step (in ms) as integrating in fixed steps, but long steps are taken while the
+// path is clear. Sample must be a multiple of step.
+void trace_nade_path(
+  trajectory_t const*      pos,
+  int32_t                  end_time,
+  int32_t                  step,
+  int32_t                  sample,
+  nadePathVisitor_t const* visitor);
+
+#endif // NADE_PATH_H
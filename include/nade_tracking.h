@@ -1,13 +1,13 @@
-#define MAX_NADES 10
-
-typedef struct
-{
-  /** the entity number of the nade being tracked, -1 if not tracking */
-  int id;
-  /** predicted time of when the nade will explode */
-  int explode_time;
-  /** flag for whether this nade was seen in current snapshot */
-  int seen;
-} nade_info_t;
-
-extern nade_info_t nades[MAX_NADES];
+#ifndef NADE_TRACKING_H
+#define NADE_TRACKING_H
+
+#include <stdint.h>
+
+#define NADE_EXPLODE_TIME 2500
+
+void init_nade_tracking(void);
+
+// predicted time of when the own nade with this entity number will explode, 0 if not tracking
+int32_t nade_explode_time(int32_t number);
+
+#endif // NADE_TRACKING_H
@@ -0,0 +1,164 @@
+#include "bench.h"
+
+#include "cg_draw.h"
+#include "cg_local.h"
+#include "cg_main.h"
+#include "cg_snap.h"
+#include "cg_utils.h"
+#include "cg_vm.h"
+#include "g_local.h"
+#include "nade_path.h"
+#include "nade_tracking.h"
+#include "quality.h"
+#include "timing.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define BENCH_DEFAULT_N 1000
+#define BENCH_MAX_N     100000
+// More rectangles don't fit the renderer's command buffer and would be dropped.
+#define BENCH_MAX_RECTS 4096
+// Time the hud may take per frame at the recommended settings, in ms.
+#define BENCH_BUDGET_MS 1.f
+// Snap-HUD zones are timed and estimated at the highest acceleration, CPM with haste.
+#define BENCH_SNAP_ACCEL 50.f
+
+static void print_result(char const* name, int32_t n, uint64_t ns)
+{
+  if (!ns) ns = 1;
+  trap_Print(vaf(
+    "%-24s %7i %9.3f %9.3f %11.0f\n", name, n, (double)ns / 1e6, (double)ns / 1e3 / n, n * 1e9 / (double)ns));
+}
+
+static void count_sample(void* data, int32_t time, vec3_t const origin)
+{
+  (void)time;
+  (void)origin;
+  ++*(int32_t*)data;
+}
+
+static void ignore_bounce(void* data, trajectory_t const* pos)
+{
+  (void)data;
+  (void)pos;
+}
+
+static uint64_t bench_vm(int32_t n)
+{
+  uint64_t const start = time_ns();
+  for (int32_t i = 0; i < n; ++i) VM_Exec(&g_VM, CG_CROSSHAIR_PLAYER, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0);
+  return time_ns() - start;
+}
+
+static uint64_t bench_trace(playerState_t const* ps, int32_t n)
+{
+  static vec3_t const mins = { -15, -15, -24 };
+  static vec3_t const maxs = { 15, 15, 32 };
+
+  vec3_t end;
+  VectorCopy(ps->origin, end);
+  end[2] -= 64;
+
+  trace_t        trace;
+  uint64_t const start = time_ns();
+  for (int32_t i = 0; i < n; ++i) trap_CM_BoxTrace(&trace, ps->origin, end, mins, maxs, 0, MASK_PLAYERSOLID);
+  return time_ns() - start;
+}
+
+static uint64_t bench_fill(int32_t n)
+{
+  static vec4_t const invisible = { 0, 0, 0, 0 };
+
+  uint64_t const start = time_ns();
+  for (int32_t i = 0; i < n; ++i) CG_FillRect((float)(i % 640), (float)(i % 480), 1, 1, invisible);
+  return time_ns() - start;
+}
+
+static uint64_t bench_snap(int32_t n)
+{
+  static snapZones_t zones;
+
+  uint64_t const start = time_ns();
+  // every a the hud can switch between
+  for (int32_t i = 0; i < n; ++i) update_snap_zones(&zones, 1 + (i % 491) * .1f);
+  return time_ns() - start;
+}
+
+static uint64_t bench_nade_path(playerState_t const* ps, quality_t const* level, int32_t n, int32_t* samples)
+{
+  playerState_t launcher = *ps;
+  launcher.weapon        = WP_GRENADE_LAUNCHER;
+
+  gentity_t ent;
+  BG_PlayerStateToEntityState(&launcher, &ent.s, qtrue);
+  VectorCopy(ent.s.pos.trBase, ent.r.currentOrigin);
+  gentity_t m;
+  FireWeapon(&launcher, &m, &ent);
+
+  nadePathVisitor_t const visitor = { count_sample, ignore_bounce, samples };
+  uint64_t const          start   = time_ns();
+  for (int32_t i = 0; i < n; ++i)
+  {
+    trace_nade_path(&m.s.pos, cg.time + NADE_EXPLODE_TIME, level->gl_path_step, level->gl_path_sample, &visitor);
+  }
+  return time_ns() - start;
+}
+
+void bench(void)
+{
+  char arg[MAX_QPATH];
+  trap_Argv(1, arg, sizeof(arg));
+  int32_t n = trap_Argc() > 1 ? atoi(arg) : BENCH_DEFAULT_N;
+  if (n <= 0 || n > BENCH_MAX_N)
+  {
+    trap_Print(vaf("usage: mdd_bench [n], 1 <= n <= %i\n", BENCH_MAX_N));
+    return;
+  }
+  if (!g_VM.memory)
+  {
+    trap_Print("^3no qvm loaded\n");
+    return;
+  }
+
+  playerState_t const* const ps    = getPs();
+  int32_t const              rects = n < BENCH_MAX_RECTS ? n : BENCH_MAX_RECTS;
+  int32_t const              paths = n / 10 > 0 ? n / 10 : 1;
+
+  trap_Print("workload                       n  total ms   each us     per sec\n");
+  print_result("qvm call", n, bench_vm(n));
+  print_result("trap_CM_BoxTrace", n, bench_trace(ps, n));
+  uint64_t const fill_ns = bench_fill(rects);
+  print_result("CG_FillRect", rects, fill_ns);
+  print_result("update_snap_zones", n, bench_snap(n));
+
+  // estimated hud cost per frame of each level: the grenade preview and every Snap-HUD layer at BENCH_SNAP_ACCEL,
+  // each zone being one rectangle in all 4 quadrants
+  int32_t const snap_rects  = 4 * 2 * (int32_t)(BENCH_SNAP_ACCEL + .5f);
+  int32_t       recommended = -1;
+  for (int32_t l = 0; l < quality_level_count(); ++l)
+  {
+    quality_t const* const level   = quality_level(l);
+    int32_t                samples = 0;
+    uint64_t const         path_ns = bench_nade_path(ps, level, paths, &samples);
+
+    char name[48];
+    snprintf(name, sizeof(name), "grenade path, quality %i", l);
+    print_result(name, paths, path_ns);
+
+    double const snap_ns  = (double)fill_ns / rects * snap_rects * level->snap_layers;
+    float const  frame_ms = (float)(((double)path_ns / paths + snap_ns) / 1e6);
+    trap_Print(vaf("  %i samples, %.3f ms per frame\n", samples / paths, frame_ms));
+    if (recommended < 0 && frame_ms <= BENCH_BUDGET_MS) recommended = l;
+  }
+
+  if (!recommended)
+    trap_Print("recommended: full quality, mdd_quality_budget 0\n");
+  else if (recommended > 0)
+    trap_Print(vaf("recommended: mdd_quality_budget %g, mdd_quality_max %i\n", BENCH_BUDGET_MS, recommended));
+  else
+    trap_Print(vaf(
+      "recommended: mdd_quality_budget %g, mdd_quality_max %i and fewer huds\n",
+      BENCH_BUDGET_MS,
+      quality_level_count() - 1));
+}
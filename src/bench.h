@@ -0,0 +1,9 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+// mdd_bench [n]: times the work the proxy does per frame on this machine, n times each (default 1000). Calls into
+// the qvm, traces at the player's position, filled rectangles, Snap-HUD zones and a grenade path for every quality
+// level. Prints the throughput and the quality settings whose hud fits a frame.
+void bench(void);
+
+#endif // BENCH_H
@@ -126,10 +126,7 @@ typedef struct
   vec4_t graph_rgbaFullAccel;
   vec4_t graph_rgbaTurnZone;
 
-  float d_min;
-  float d_opt;
-  float d_max_cos;
-  float d_max;
+  cgazZones_t z;
 
   float d_vel;
 
@@ -265,16 +262,16 @@ static void CG_DrawCGaz(void)
   ParseVec(cgaz_rgbaFullAccel.string, s.graph_rgbaFullAccel, 4);
   ParseVec(cgaz_rgbaTurnZone.string, s.graph_rgbaTurnZone, 4);
 
-  CG_FillAngleYaw(-s.d_min, +s.d_min, yaw, s.graph_yh[0], s.graph_yh[1], s.graph_rgbaNoAccel);
+  CG_FillAngleYaw(-s.z.d_min, +s.z.d_min, yaw, s.graph_yh[0], s.graph_yh[1], s.graph_rgbaNoAccel);
 
-  CG_FillAngleYaw(+s.d_min, +s.d_opt, yaw, s.graph_yh[0], s.graph_yh[1], s.graph_rgbaPartialAccel);
-  CG_FillAngleYaw(-s.d_opt, -s.d_min, yaw, s.graph_yh[0], s.graph_yh[1], s.graph_rgbaPartialAccel);
+  CG_FillAngleYaw(+s.z.d_min, +s.z.d_opt, yaw, s.graph_yh[0], s.graph_yh[1], s.graph_rgbaPartialAccel);
+  CG_FillAngleYaw(-s.z.d_opt, -s.z.d_min, yaw, s.graph_yh[0], s.graph_yh[1], s.graph_rgbaPartialAccel);
 
-  CG_FillAngleYaw(+s.d_opt, +s.d_max_cos, yaw, s.graph_yh[0], s.graph_yh[1], s.graph_rgbaFullAccel);
-  CG_FillAngleYaw(-s.d_max_cos, -s.d_opt, yaw, s.graph_yh[0], s.graph_yh[1], s.graph_rgbaFullAccel);
+  CG_FillAngleYaw(+s.z.d_opt, +s.z.d_max_cos, yaw, s.graph_yh[0], s.graph_yh[1], s.graph_rgbaFullAccel);
+  CG_FillAngleYaw(-s.z.d_max_cos, -s.z.d_opt, yaw, s.graph_yh[0], s.graph_yh[1], s.graph_rgbaFullAccel);
 
-  CG_FillAngleYaw(+s.d_max_cos, +s.d_max, yaw, s.graph_yh[0], s.graph_yh[1], s.graph_rgbaTurnZone);
-  CG_FillAngleYaw(-s.d_max, -s.d_max_cos, yaw, s.graph_yh[0], s.graph_yh[1], s.graph_rgbaTurnZone);
+  CG_FillAngleYaw(+s.z.d_max_cos, +s.z.d_max, yaw, s.graph_yh[0], s.graph_yh[1], s.graph_rgbaTurnZone);
+  CG_FillAngleYaw(-s.z.d_max, -s.z.d_max_cos, yaw, s.graph_yh[0], s.graph_yh[1], s.graph_rgbaTurnZone);
 }
 
 /*
@@ -407,21 +404,24 @@ static float update_d_max(state_t const* state, float d_max_cos)
   return d_max;
 }
 
-static void update_d(float wishspeed, float accel, float slickGravity)
+void update_cgaz_zones(
+  cgazZones_t* z,
+  float        v_squared,
+  float        vf_squared,
+  float        wishspeed,
+  float        a,
+  float        slickGravity)
 {
   ASSERT_GE(slickGravity, 0);
-  assert(slickGravity == 0 || s.pml.groundTrace.surfaceFlags & SURF_SLICK || s.pm_ps.pm_flags & PMF_TIME_KNOCKBACK);
 
   state_t state;
   state.g_squared  = slickGravity * slickGravity;
-  state.v_squared  = VectorLengthSquared2(s.pml.previous_velocity);
-  state.vf_squared = VectorLengthSquared2(s.pm_ps.velocity);
+  state.v_squared  = v_squared;
+  state.vf_squared = vf_squared;
   state.wishspeed  = wishspeed;
-  state.a          = accel * state.wishspeed * pm_frametime;
+  state.a          = a;
   state.a_squared  = state.a * state.a;
-  if (
-    !(cgaz_trueness.integer & CGAZ_GROUND) ||
-    state.v_squared - state.vf_squared >= 2 * state.a * state.wishspeed - state.a_squared)
+  if (state.v_squared - state.vf_squared >= 2 * state.a * state.wishspeed - state.a_squared)
   {
     state.v_squared = state.vf_squared;
   }
@@ -430,14 +430,24 @@ static void update_d(float wishspeed, float accel, float slickGravity)
 
   ASSERT_LE(state.a * pm_frametime, 1);
 
-  s.d_min     = update_d_min(&state);
-  s.d_opt     = update_d_opt(&state);
-  s.d_max_cos = update_d_max_cos(&state, s.d_opt);
-  s.d_max     = update_d_max(&state, s.d_max_cos);
+  z->d_min     = update_d_min(&state);
+  z->d_opt     = update_d_opt(&state);
+  z->d_max_cos = update_d_max_cos(&state, z->d_opt);
+  z->d_max     = update_d_max(&state, z->d_max_cos);
+
+  ASSERT_LE(z->d_min, z->d_opt);
+  ASSERT_LE(z->d_opt, z->d_max_cos);
+  ASSERT_LE(z->d_max_cos, z->d_max);
+}
+
+static void update_d(float wishspeed, float accel, float slickGravity)
+{
+  assert(slickGravity == 0 || s.pml.groundTrace.surfaceFlags & SURF_SLICK || s.pm_ps.pm_flags & PMF_TIME_KNOCKBACK);
 
-  ASSERT_LE(s.d_min, s.d_opt);
-  ASSERT_LE(s.d_opt, s.d_max_cos);
-  ASSERT_LE(s.d_max_cos, s.d_max);
+  float const vf_squared = VectorLengthSquared2(s.pm_ps.velocity);
+  float const v_squared =
+    cgaz_trueness.integer & CGAZ_GROUND ? VectorLengthSquared2(s.pml.previous_velocity) : vf_squared;
+  update_cgaz_zones(&s.z, v_squared, vf_squared, wishspeed, accel * wishspeed * pm_frametime, slickGravity);
 
   s.d_vel = atan2f(s.pm_ps.velocity[1], s.pm_ps.velocity[0]);
 }
@@ -496,7 +506,7 @@ static void PM_AirMove(void)
       // Air control when s.pm.cmd.forwardmove != 0 && s.pm.cmd.rightmove == 0 only changes direction
       PM_Accelerate(wishspeed, pm_airaccelerate);
       // TODO: clean up
-      if (s.d_max > (float)M_PI / 2)
+      if (s.z.d_max > (float)M_PI / 2)
       {
         float       v_squared  = VectorLengthSquared2(s.pml.previous_velocity);
         float const vf_squared = VectorLengthSquared2(s.pm_ps.velocity);
@@ -508,18 +518,18 @@ static void PM_AirMove(void)
           float const den = 2 * a * vf;
           if (num >= den)
           {
-            s.d_max = 0;
+            s.z.d_max = 0;
           }
           else if (-num >= den)
           {
-            s.d_max = (float)M_PI;
+            s.z.d_max = (float)M_PI;
           }
           else
           {
-            s.d_max = acosf(num / den);
+            s.z.d_max = acosf(num / den);
           }
         }
-        ASSERT_LE(s.d_max_cos, s.d_max);
+        ASSERT_LE(s.z.d_max_cos, s.z.d_max);
       }
     }
   }
@@ -623,9 +633,9 @@ static void PM_WalkMove(void)
   if (s.pml.groundTrace.surfaceFlags & SURF_SLICK || s.pm_ps.pm_flags & PMF_TIME_KNOCKBACK)
   {
     // PM_Accelerate(wishspeed, s.pm_ps.pm_flags & PMF_PROMODE ? cpm_slickaccelerate : pm_slickaccelerate);
-    // g_syscall(CG_PRINT, vaf("a: %1.3f %1.3f %1.3f %1.3f\n", s.d_min, s.d_opt, s.d_max_cos, s.d_max));
+    // g_syscall(CG_PRINT, vaf("a: %1.3f %1.3f %1.3f %1.3f\n", s.z.d_min, s.z.d_opt, s.z.d_max_cos, s.z.d_max));
     PM_SlickAccelerate(wishspeed, s.pm_ps.pm_flags & PMF_PROMODE ? cpm_slickaccelerate : pm_slickaccelerate);
-    // g_syscall(CG_PRINT, vaf("a: %1.3f %1.3f %1.3f %1.3f\n", s.d_min, s.d_opt, s.d_max_cos, s.d_max));
+    // g_syscall(CG_PRINT, vaf("a: %1.3f %1.3f %1.3f %1.3f\n", s.z.d_min, s.z.d_opt, s.z.d_max_cos, s.z.d_max));
   }
   else
   {
@@ -19,9 +19,13 @@
   ==============================
   Note: mdd client proxymod contains large quantities from the quake III arena source code
 */
+#include "bench.h"
 #include "cg_local.h"
 #include "cg_vm.h"
 #include "help.h"
+#include "profile.h"
+#include "syscall_stats.h"
+#include "vm_sampler.h"
 
 #include <stdlib.h>
 
@@ -37,7 +41,11 @@ typedef struct
 } consoleCommand_t;
 
 static consoleCommand_t commands[] = {
+  { "mdd_bench", bench },
   { "mdd_help", cmdHelp },
+  { "mdd_profile_dump", dump_profile },
+  { "mdd_syscall_stats", print_syscall_stats },
+  { "mdd_vm_sample", vm_sample },
 #ifndef NDEBUG
   { "mdd_points_to", cmdPointsTo_DebugOnly },
 #endif
@@ -112,6 +120,6 @@ static void cmdPointsTo_DebugOnly(void)
   trap_Argv(1, cmd, sizeof(cmd));
 
   long const offset = strtol(cmd, NULL, 0);
-  trap_Print(vaf("%s -> 0x%lx\n", cmd, *(int32_t*)VM_ArgPtr(offset)));
+  trap_Print(vaf("%s -> 0x%lx\n", cmd, *(int32_t*)VM_ArgPtr(&g_VM, offset)));
 }
 #endif
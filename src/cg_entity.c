@@ -2,6 +2,9 @@
 
 #include "cg_cvar.h"
 #include "cg_utils.h"
+#include "q_assert.h"
+
+#define MAX_ENTITY_LISTENERS 8
 
 static vmCvar_t sound_local_only;
 
@@ -9,24 +12,194 @@ static cvarTable_t sound_cvars[] = {
   { &sound_local_only, "mdd_sound_local_only", "0", CVAR_ARCHIVE_ND },
 };
 
-static entityState_t cg_entityStates[1024];
+typedef struct
+{
+  qboolean valid;
+  int32_t  serverTime; // of the snapshot the index was built from
+  int32_t  clientNum;  // of the player the snapshot was taken for
+
+  // double buffered so that the previous snapshot can be diffed against the current one
+  uint8_t       cur;
+  int32_t       numEntities[2];
+  entityState_t entities[2][MAX_ENTITIES_IN_SNAPSHOT];
+  int16_t       slots[2][MAX_GENTITIES]; // entity number -> index in entities, -1 if not in snapshot
+
+  uint16_t generations[MAX_GENTITIES]; // incremented each time an entity number spawns
+
+  entityList_t own_grenades;
+  entityList_t own_rockets;
+  entityList_t missiles;
+
+  uint8_t          numListeners;
+  entityListener_t listeners[MAX_ENTITY_LISTENERS];
+} entityIndex_t;
+
+static entityIndex_t index_;
+
+// The sound filter only needs to know who owns an entity, so don't keep full entity states around.
+// entity number -> client number of its last seen owner, -1 if never seen
+static int16_t owners[MAX_GENTITIES];
+
+static void on_entity_event(entityEvent_t const* event);
 
 void init_entityStates(void)
 {
   init_cvars(sound_cvars, ARRAY_LEN(sound_cvars));
 
-  memset(cg_entityStates, -1, sizeof(cg_entityStates));
+  memset(owners, -1, sizeof(owners));
+
+  index_.valid          = qfalse;
+  index_.numEntities[0] = 0;
+  index_.numEntities[1] = 0;
+  memset(index_.slots, -1, sizeof(index_.slots));
+
+  subscribe_entityEvents(on_entity_event);
 }
 
-void update_entityStates(void)
+void del_entityStates(void)
 {
-  update_cvars(sound_cvars, ARRAY_LEN(sound_cvars));
+  // the listeners may not survive the next CG_INIT, they subscribe again in their init
+  index_.numListeners = 0;
+  index_.valid        = qfalse;
+}
 
+void subscribe_entityEvents(entityListener_t listener)
+{
+  for (uint8_t i = 0; i < index_.numListeners; ++i)
+  {
+    if (index_.listeners[i] == listener) return;
+  }
+  ASSERT_LT(index_.numListeners, MAX_ENTITY_LISTENERS);
+  index_.listeners[index_.numListeners++] = listener;
+}
+
+static inline entityHandle_t make_handle(int32_t number)
+{
+  return (entityHandle_t)index_.generations[number] << GENTITYNUM_BITS | number;
+}
+
+static void emit(entityEventType_t type, entityState_t const* state)
+{
+  entityEvent_t const event = { type, make_handle(state->number), state, index_.serverTime };
+  for (uint8_t i = 0; i < index_.numListeners; ++i) index_.listeners[i](&event);
+}
+
+static inline void push_entity(entityList_t* list, entityState_t const* entity)
+{
+  ASSERT_LT(list->count, MAX_ENTITIES_IN_SNAPSHOT);
+  list->entities[list->count++] = entity;
+}
+
+static entityIndex_t const* entity_index(void)
+{
   snapshot_t const* const snap = getSnap();
-  for (int i = 0; i < snap->numEntities; i++)
+  if (index_.valid && index_.serverTime == snap->serverTime) return &index_;
+
+  uint8_t const        prev      = index_.cur;
+  uint8_t const        next      = prev ^ 1;
+  entityState_t* const entities  = index_.entities[next];
+  int16_t* const       slots     = index_.slots[next];
+  int16_t const* const prevSlots = index_.slots[prev];
+
+  // only reset the slots used by the snapshot before the previous one
+  for (int32_t i = 0; i < index_.numEntities[next]; ++i) slots[entities[i].number] = -1;
+
+  index_.valid      = qtrue;
+  index_.serverTime = snap->serverTime;
+  index_.clientNum  = snap->ps.clientNum;
+  index_.cur        = next;
+
+  index_.own_grenades.count = 0;
+  index_.own_rockets.count  = 0;
+  index_.missiles.count     = 0;
+
+  ASSERT_LE(snap->numEntities, MAX_ENTITIES_IN_SNAPSHOT);
+  index_.numEntities[next] = snap->numEntities;
+  memcpy(entities, snap->entities, snap->numEntities * sizeof(entityState_t));
+  for (int32_t i = 0; i < snap->numEntities; ++i)
   {
-    cg_entityStates[snap->entities[i].number] = snap->entities[i];
+    entityState_t const* const entity = &entities[i];
+    slots[entity->number]             = (int16_t)i;
+
+    if (entity->eType != ET_MISSILE) continue;
+    push_entity(&index_.missiles, entity);
+
+    if (entity->clientNum != snap->ps.clientNum) continue;
+    if (entity->weapon == WP_GRENADE_LAUNCHER)
+      push_entity(&index_.own_grenades, entity);
+    else if (entity->weapon == WP_ROCKET_LAUNCHER)
+      push_entity(&index_.own_rockets, entity);
   }
+
+  // diff against the previous snapshot
+  for (int32_t i = 0; i < snap->numEntities; ++i)
+  {
+    entityState_t const* const entity   = &entities[i];
+    int16_t const              prevSlot = prevSlots[entity->number];
+    if (prevSlot < 0)
+    {
+      // generation 0 is reserved for entity numbers which never spawned
+      if (!++index_.generations[entity->number]) ++index_.generations[entity->number];
+      emit(ENTITY_SPAWNED, entity);
+    }
+    else if (memcmp(entity, &index_.entities[prev][prevSlot], sizeof(entityState_t)))
+    {
+      emit(ENTITY_CHANGED, entity);
+    }
+  }
+  for (int32_t i = 0; i < index_.numEntities[prev]; ++i)
+  {
+    entityState_t const* const entity = &index_.entities[prev][i];
+    if (slots[entity->number] < 0) emit(ENTITY_REMOVED, entity);
+  }
+  return &index_;
+}
+
+entityState_t const* entity_by_number(int32_t number)
+{
+  ASSERT_GE(number, 0);
+  ASSERT_LT(number, MAX_GENTITIES);
+  entityIndex_t const* const index = entity_index();
+  int16_t const              slot  = index->slots[index->cur][number];
+  return slot >= 0 ? &index->entities[index->cur][slot] : NULL;
+}
+
+entityHandle_t entity_handle(int32_t number)
+{
+  ASSERT_GE(number, 0);
+  ASSERT_LT(number, MAX_GENTITIES);
+  entity_index();
+  return make_handle(number);
+}
+
+entityList_t const* own_grenades(void)
+{
+  return &entity_index()->own_grenades;
+}
+
+entityList_t const* own_rockets(void)
+{
+  return &entity_index()->own_rockets;
+}
+
+entityList_t const* all_missiles(void)
+{
+  return &entity_index()->missiles;
+}
+
+void update_entityStates(void)
+{
+  update_cvars(sound_cvars, ARRAY_LEN(sound_cvars));
+
+  // dispatch the entity events of a new snapshot before any module draws
+  entity_index();
+}
+
+static void on_entity_event(entityEvent_t const* event)
+{
+  // keep the last seen owner of entities that left the snapshot, their sounds can still play
+  if (event->type == ENTITY_REMOVED) return;
+  owners[event->state->number] = (int16_t)event->state->clientNum;
 }
 
 int8_t should_filter_sound(int entity_num, int8_t is_loop)
@@ -38,9 +211,13 @@ int8_t should_filter_sound(int entity_num, int8_t is_loop)
   // can't do anything about this w/o df code
   if (!is_loop && entity_num == ENTITYNUM_WORLD) return 1;
 
+  // the owners are updated by update_entityStates once per snapshot, looking them up takes no syscalls
+
   // refers to a entity number we dont have (i.e. ourself!)
   // no clue whose sound it could be just let it play
-  if (cg_entityStates[entity_num].number == -1) return 0;
+  ASSERT_GE(entity_num, 0);
+  ASSERT_LT(entity_num, MAX_GENTITIES);
+  if (owners[entity_num] < 0) return 0;
 
-  return cg_entityStates[entity_num].clientNum != getSnap()->ps.clientNum;
+  return owners[entity_num] != index_.clientNum;
 }
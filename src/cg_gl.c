@@ -1,11 +1,14 @@
 #include "cg_gl.h"
 
 #include "cg_cvar.h"
+#include "cg_entity.h"
 #include "cg_local.h"
 #include "cg_utils.h"
 #include "g_local.h"
 #include "help.h"
+#include "nade_path.h"
 #include "nade_tracking.h"
+#include "quality.h"
 
 static vmCvar_t gl_path_draw;
 static vmCvar_t gl_path_rgba;
@@ -61,8 +64,6 @@ void draw_gl(void)
 
   playerState_t const* const ps = getPs();
 
-  snapshot_t const* const snap = getSnap();
-
   if (ps->weapon == WP_GRENADE_LAUNCHER && gl_path_preview_draw.integer)
   {
     ParseVec(gl_path_preview_rgba.string, color, 4);
@@ -78,7 +79,7 @@ void draw_gl(void)
     gentity_t m;
     FireWeapon(ps, &m, &ent);
 
-    draw_nade_path(&m.s.pos, cg.time + 2500, preview_color);
+    draw_nade_path(&m.s.pos, cg.time + NADE_EXPLODE_TIME, preview_color);
   }
 
   if (!gl_path_draw.integer) return;
@@ -86,26 +87,39 @@ void draw_gl(void)
   ParseVec(gl_path_rgba.string, color, 4);
   for (uint8_t i = 0; i < 4; ++i) path_color[i] = (uint8_t)(color[i] * 255);
 
-  for (uint8_t i = 0; i < MAX_NADES; ++i)
+  entityList_t const* const grenades = own_grenades();
+  for (int32_t i = 0; i < grenades->count; ++i)
   {
-    if (nades[i].id >= 0 && nades[i].seen)
-    {
-      for (int j = 0; j < snap->numEntities; ++j)
-      {
-        entityState_t const* const entity = &snap->entities[j];
-        if (entity->number != nades[i].id) continue;
-        draw_nade_path(&entity->pos, nades[i].explode_time, path_color);
-      }
-    }
+    entityState_t const* const entity       = grenades->entities[i];
+    int32_t const              explode_time = nade_explode_time(entity->number);
+    if (explode_time) draw_nade_path(&entity->pos, explode_time, path_color);
   }
 }
 
+static void reset_nade_path_beam(void* data, trajectory_t const* pos)
+{
+  refEntity_t* const beam = data;
+  if (cg.time > pos->trTime)
+    BG_EvaluateTrajectory(pos, cg.time, beam->oldorigin);
+  else
+    VectorCopy(pos->trBase, beam->oldorigin);
+}
+
+static void add_nade_path_beam(void* data, int32_t time, vec3_t const origin)
+{
+  refEntity_t* const beam = data;
+  if (time < cg.time) return;
+
+  vec3_t d;
+  VectorSubtract(origin, beam->oldorigin, d);
+  VectorMA(beam->oldorigin, .5f, d, beam->origin);
+  trap_R_AddRefEntityToScene(beam);
+  VectorCopy(origin, beam->oldorigin);
+}
+
 static void draw_nade_path(trajectory_t const* pos, int end_time, uint8_t const* color)
 {
   refEntity_t beam;
-  trace_t     trace;
-  int         sample_timer = 0;
-  vec3_t      currentOrigin, origin;
 
   if (pos->trType != TR_GRAVITY) return;
 
@@ -117,59 +131,8 @@ static void draw_nade_path(trajectory_t const* pos, int end_time, uint8_t const*
   AxisClear(beam.axis);
   memcpy(beam.shaderRGBA, color, sizeof(beam.shaderRGBA));
 
-  VectorCopy(pos->trBase, currentOrigin);
-  if (cg.time > pos->trTime)
-    BG_EvaluateTrajectory(pos, cg.time, beam.oldorigin);
-  else
-    VectorCopy(pos->trBase, beam.oldorigin);
-
-  trajectory_t local_pos = *pos;
-  for (int leveltime = local_pos.trTime + 8; leveltime < end_time; leveltime += 8)
-  {
-    BG_EvaluateTrajectory(&local_pos, leveltime, origin);
-    trap_CM_BoxTrace(&trace, currentOrigin, origin, NULL, NULL, 0, MASK_SHOT);
-    VectorCopy(trace.endpos, currentOrigin);
+  reset_nade_path_beam(&beam, pos);
 
-    sample_timer -= 8;
-    if (sample_timer <= 0)
-    {
-      sample_timer = 32;
-      VectorCopy(origin, beam.origin);
-      if (leveltime >= cg.time)
-      {
-        vec3_t d, saved_origin;
-        VectorCopy(beam.origin, saved_origin);
-        VectorSubtract(beam.origin, beam.oldorigin, d);
-        VectorMA(beam.oldorigin, .5f, d, beam.origin);
-        trap_R_AddRefEntityToScene(&beam);
-        VectorCopy(saved_origin, beam.oldorigin);
-      }
-    }
-
-    if (trace.fraction != 1)
-    {
-      // G_BounceMissile
-      vec3_t velocity;
-      float  dot;
-      int    hitTime;
-
-      // reflect the velocity on the trace plane
-      hitTime = (leveltime - 8) + (int)(8 * trace.fraction);
-      BG_EvaluateTrajectoryDelta(&local_pos, hitTime, velocity);
-      dot = DotProduct(velocity, trace.plane.normal);
-      VectorMA(velocity, -2 * dot, trace.plane.normal, local_pos.trDelta);
-
-      VectorScale(local_pos.trDelta, .65f, local_pos.trDelta);
-
-      VectorAdd(currentOrigin, trace.plane.normal, currentOrigin);
-      VectorCopy(currentOrigin, local_pos.trBase);
-      local_pos.trTime = leveltime;
-
-      sample_timer = 0;
-      if (cg.time > local_pos.trTime)
-        BG_EvaluateTrajectory(&local_pos, cg.time, beam.oldorigin);
-      else
-        VectorCopy(local_pos.trBase, beam.oldorigin);
-    }
-  }
+  nadePathVisitor_t const visitor = { add_nade_path_beam, reset_nade_path_beam, &beam };
+  trace_nade_path(pos, end_time, quality()->gl_path_step, quality()->gl_path_sample, &visitor);
 }
@@ -33,8 +33,14 @@
 #include "cg_timer.h"
 #include "compass.h"
 #include "help.h"
+#include "nade_tracking.h"
+#include "perf.h"
 #include "pitch.h"
+#include "profile.h"
+#include "quality.h"
+#include "syscall_stats.h"
 #include "version.h"
+#include "vm_tos.h"
 
 static vmCvar_t hud;
 static vmCvar_t version;
@@ -60,14 +66,21 @@ void init_hud(void)
   init_entityStates();
   init_gl();
   init_jump();
+  init_nade_tracking();
+  init_perf();
   init_pitch();
+  init_profile();
+  init_quality();
   init_rl();
   init_snap();
+  init_syscall_stats();
   init_timer();
+  init_vm_tos();
 }
 
 void del_hud(void)
 {
+  del_entityStates();
   del_help();
 }
 
@@ -75,13 +88,21 @@ void update_hud(void)
 {
   update_cvars(hud_cvars, ARRAY_LEN(hud_cvars));
 
+  // Also closes the frame budget measurement, so update even when the hud is disabled.
+  update_quality();
+  update_perf();
+  update_profile();
+  update_syscall_stats();
+  update_vm_tos();
+  // The sound filter needs the entity owners even when the hud is disabled.
+  update_entityStates();
+
   if (!hud.integer) return;
 
   update_ammo();
   update_bbox();
   update_cgaz();
   update_compass();
-  update_entityStates();
   update_gl();
   update_jump();
   update_pitch();
@@ -97,12 +118,15 @@ void draw_hud(void)
 
   if (!hud.integer) return;
 
-  draw_compass();
-  draw_cgaz();
-  draw_snap();
-  draw_pitch();
+  perf_call(PERF_OTHER, "draw_compass", draw_compass);
+  perf_call(PERF_CGAZ, "draw_cgaz", draw_cgaz);
+  perf_call(PERF_SNAP, "draw_snap", draw_snap);
+  perf_call(PERF_OTHER, "draw_pitch", draw_pitch);
+
+  perf_call(PERF_OTHER, "draw_ammo", draw_ammo);
+  perf_call(PERF_OTHER, "draw_jump", draw_jump);
+  perf_call(PERF_TIMER, "draw_timer", draw_timer);
 
-  draw_ammo();
-  draw_jump();
-  draw_timer();
+  draw_quality();
+  draw_perf();
 }
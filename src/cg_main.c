@@ -21,7 +21,12 @@
 #include "cg_main.h"
 
 #include "cg_hud.h"
+#include "cg_syscall.h"
+#include "perf.h"
+#include "profile.h"
 #include "q_assert.h"
+#include "syscall_log.h"
+#include "syscall_stats.h"
 #include "version.h"
 
 #include <stdlib.h>
@@ -48,6 +53,16 @@ intptr_t vmMain(
 {
   intptr_t ret;
 
+  if (cmd == CG_INIT) start_syscall_recording();
+  syscall_log_call(cmd, arg0, arg1, arg2);
+
+  if (cmd == CG_DRAW_ACTIVE_FRAME)
+  {
+    profile_frame();
+    perf_frame_begin();
+  }
+  span_t const span = span_begin("vmMain");
+
   /* PRE CALL */
   switch (cmd)
   {
@@ -60,8 +75,13 @@ intptr_t vmMain(
 
   case CG_DRAW_ACTIVE_FRAME: // void (*CG_DrawActiveFrame)( int32_t serverTime, stereoFrame_t stereoView, qboolean
                              // demoPlayback );
+  {
+    sample_syscall_stats();
+    span_t const pre = span_begin("CG_DrawActiveFrame");
     CG_DrawActiveFrame(arg0, arg1, arg2);
+    span_end(pre);
     break;
+  }
 
   case CG_CROSSHAIR_PLAYER: // int32_t (*CG_CrosshairPlayer)( void );
     break;
@@ -83,6 +103,7 @@ intptr_t vmMain(
 
   case -1:
     setVMPtr(arg0);
+    span_end(span);
     return 0;
     break;
   }
@@ -122,9 +143,12 @@ intptr_t vmMain(
   case CG_SHUTDOWN: // void (*CG_Shutdown)( void )
     CG_Shutdown();
     ASSERT_EQ(ret, 0);
+    stop_syscall_recording();
     break;
   }
 
+  if (cmd == CG_DRAW_ACTIVE_FRAME) perf_frame_end();
+  span_end(span);
   return ret;
 }
 
@@ -1,5 +1,6 @@
 #include "cg_local.h"
 #include "q_assert.h"
+#include "quality.h"
 
 /*
 =================
@@ -72,10 +73,18 @@ void CG_ImpactMark(
     originalPoints[3][i] = origin[i] - radius * axis[1][i] + radius * axis[2][i];
   }
 
-  // get the fragments
+  // get the fragments, fewer of them when the frame budget is exceeded
+  int32_t const maxFragments = quality()->mark_fragments;
+  ASSERT_LE(maxFragments, MAX_MARK_FRAGMENTS);
   VectorScale(dir, -20, projection);
   numFragments = trap_CM_MarkFragments(
-    4, (void*)originalPoints, projection, MAX_MARK_POINTS, markPoints[0], MAX_MARK_FRAGMENTS, markFragments);
+    4,
+    (void*)originalPoints,
+    projection,
+    MAX_MARK_POINTS * maxFragments / MAX_MARK_FRAGMENTS,
+    markPoints[0],
+    maxFragments,
+    markFragments);
 
   colors[0] = (byte)(red * 255);
   colors[1] = (byte)(green * 255);
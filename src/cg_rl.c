@@ -1,6 +1,7 @@
 #include "cg_rl.h"
 
 #include "cg_cvar.h"
+#include "cg_entity.h"
 #include "cg_local.h"
 #include "cg_utils.h"
 #include "g_local.h"
@@ -61,8 +62,7 @@ void draw_rl(void)
   vec3_t      origin;
   vec3_t      dest;
 
-  snapshot_t const* const    snap = getSnap();
-  playerState_t const* const ps   = getPs();
+  playerState_t const* const ps = getPs();
 
   if (target_draw.integer && ps->weapon == WP_ROCKET_LAUNCHER)
   {
@@ -85,38 +85,37 @@ void draw_rl(void)
   }
 
   // TODO: lerp trajectory stuff?
-  for (int32_t i = 0; i < snap->numEntities; ++i)
+  entityList_t const* const rockets = own_rockets();
+  for (int32_t i = 0; i < rockets->count; ++i)
   {
-    entityState_t const entity = snap->entities[i];
-    if (entity.eType == ET_MISSILE && entity.weapon == WP_ROCKET_LAUNCHER && entity.clientNum == ps->clientNum)
+    entityState_t const* const entity = rockets->entities[i];
+
+    BG_EvaluateTrajectory(&entity->pos, cg.time, origin);
+    BG_EvaluateTrajectory(&entity->pos, entity->pos.trTime + MAX_RL_TIME, dest);
+    trap_CM_BoxTrace(&beam_trace, origin, dest, NULL, NULL, 0, CONTENTS_SOLID);
+    if (path_draw.integer)
+    {
+      vec4_t color;
+      ParseVec(path_rgba.string, color, 4);
+
+      memset(&beam, 0, sizeof(beam));
+      VectorCopy(origin, beam.oldorigin);
+      VectorCopy(beam_trace.endpos, beam.origin);
+      beam.reType       = RT_RAIL_CORE;
+      beam.customShader = rl_.line_shader;
+      AxisClear(beam.axis);
+      beam.shaderRGBA[0] = (byte)(color[0] * 255);
+      beam.shaderRGBA[1] = (byte)(color[1] * 255);
+      beam.shaderRGBA[2] = (byte)(color[2] * 255);
+      beam.shaderRGBA[3] = (byte)(color[3] * 255);
+      trap_R_AddRefEntityToScene(&beam);
+    }
+
+    if (target_draw.integer)
     {
-      BG_EvaluateTrajectory(&entity.pos, cg.time, origin);
-      BG_EvaluateTrajectory(&entity.pos, entity.pos.trTime + MAX_RL_TIME, dest);
-      trap_CM_BoxTrace(&beam_trace, origin, dest, NULL, NULL, 0, CONTENTS_SOLID);
-      if (path_draw.integer)
-      {
-        vec4_t color;
-        ParseVec(path_rgba.string, color, 4);
-
-        memset(&beam, 0, sizeof(beam));
-        VectorCopy(origin, beam.oldorigin);
-        VectorCopy(beam_trace.endpos, beam.origin);
-        beam.reType       = RT_RAIL_CORE;
-        beam.customShader = rl_.line_shader;
-        AxisClear(beam.axis);
-        beam.shaderRGBA[0] = (byte)(color[0] * 255);
-        beam.shaderRGBA[1] = (byte)(color[1] * 255);
-        beam.shaderRGBA[2] = (byte)(color[2] * 255);
-        beam.shaderRGBA[3] = (byte)(color[3] * 255);
-        trap_R_AddRefEntityToScene(&beam);
-      }
-
-      if (target_draw.integer)
-      {
-        qhandle_t m_shader = trap_R_RegisterShader(target_shader.string);
-        CG_ImpactMark(
-          m_shader, beam_trace.endpos, beam_trace.plane.normal, 0, 1, 1, 1, 1, qfalse, target_size.value, qtrue);
-      }
+      qhandle_t m_shader = trap_R_RegisterShader(target_shader.string);
+      CG_ImpactMark(
+        m_shader, beam_trace.endpos, beam_trace.plane.normal, 0, 1, 1, 1, 1, qfalse, target_size.value, qtrue);
     }
   }
 }
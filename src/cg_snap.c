@@ -7,6 +7,8 @@
 #include "cg_utils.h"
 #include "help.h"
 #include "q_assert.h"
+#include "quality.h"
+#include "simd.h"
 
 static vmCvar_t snap;
 static vmCvar_t snap_trueness;
@@ -131,23 +133,10 @@ void update_snap(void)
   snap_trueness.integer = cvar_getInteger("mdd_snap_trueness");
 }
 
-#define MAX_SNAPHUD_ZONES_Q1                                                                                           \
-  101 // Max nb of snapzones in 1 quadrant
-      // => round(2.56 * 15 * 1.3) * 2 + 1 = 101
-      //                 ^^   ^^^
-      //                CPM   HASTE
-
 typedef struct
 {
-  float         a;
-  unsigned char maxAccel; // Max accel defined as
-                          // => maxAccel = round(sAT)
-  unsigned short zones[MAX_SNAPHUD_ZONES_Q1];
-  unsigned char  xAccel[MAX_SNAPHUD_ZONES_Q1];
-  unsigned char  yAccel[MAX_SNAPHUD_ZONES_Q1];
-  float          absAccel[MAX_SNAPHUD_ZONES_Q1];
-  float          minAbsAccel;
-  float          maxAbsAccel;
+  float              a;
+  snapZones_t const* z;
 
   uint32_t mode;
 
@@ -166,12 +155,21 @@ typedef struct
 
 static snap_t s;
 
+typedef struct
+{
+  float       a[SNAP_ZONES_CACHED];
+  snapZones_t z[SNAP_ZONES_CACHED];
+  uint8_t     count;
+  uint8_t     next; // replaced when full
+} snapZonesCache_t;
+
+static snapZonesCache_t cache;
+
 static void PmoveSingle(void);
 static void PM_AirMove(void);
 static void PM_WalkMove(void);
 
-static void update_snap_state(void);
-static void one_snap_draw(int yaw);
+static void one_snap_draw(float yaw);
 
 void draw_snap(void)
 {
@@ -278,11 +276,7 @@ static void PmoveSingle(void)
     PM_AirMove();
   }
 
-  // TODO: we should not go to short angles just yet and keep using floating point numbers until we start drawing.
-  // Otherwise the positions of the snapzone borders will be slightly off since we round/snap the yaw angle here.
-  float const yaw = RAD2SHORT(atan2f(s.wishvel[1], s.wishvel[0]));
-
-  one_snap_draw(AngleNormalize65536(lroundf(yaw)));
+  one_snap_draw(atan2f(s.wishvel[1], s.wishvel[0]));
 }
 
 /*
@@ -303,7 +297,7 @@ static void PM_Accelerate(float const wishspeed, float const accel)
   if (a != s.a)
   {
     s.a = a;
-    update_snap_state();
+    s.z = snap_zones(s.a);
   }
 }
 
@@ -321,7 +315,7 @@ static void PM_SlickAccelerate(float const wishspeed, float const accel)
   if (a != s.a)
   {
     s.a = a;
-    update_snap_state();
+    s.z = snap_zones(s.a);
   }
 }
 
@@ -525,117 +519,107 @@ static void PM_WalkMove(void)
   // PM_StepSlideMove(qfalse);
 }
 
-static void update_snap_state(void)
+// Batches padded to whole vectors, each half of the quadrant has maxAccel edges and maxAccel + 1 zones.
+#define SNAP_BATCH SIMD_ROUND_UP(MAX_SNAPHUD_ZONES_Q1 / 2 + 1)
+
+void update_snap_zones(snapZones_t* z, float a)
 {
-  // double startTime = get_time();
-  // double endTime = (double) clock() / CLOCKS_PER_SEC;
-  // double timeElapsed = endTime - startTime;
-  // g_syscall( CG_PRINT, vaf("Elapsed time: %.6f\n", timeElapsed));
-
-  ASSERT_GT(s.a, 0);
-  s.maxAccel             = (unsigned char)(s.a + .5f);
-  unsigned char xnyAccel = (unsigned char)(s.a / sqrtf(2.f) + .5f); // xAccel and yAccel at 45deg
-                                                                    // ^       ^  ^
-  // Find the last shortangle in each snapzone which is smaller than 45deg (= 8192) using
-  //  /asin -> increasing angles
-  //  \acos -> decreasing angles
-  // and concatenate those 2 sorted arrays in the upperhalf of 'zones' so we can merge them
-  // in the lower half afterwards                 ^^^^^^^^^ => s.maxAccel +
-  for (unsigned char i = 0; i <= xnyAccel - 1; ++i)
-    s.zones[s.maxAccel + i] = 16383 - (unsigned short)(RAD2SHORT(acosf((i + .5f) / s.a)));
-  for (unsigned char i = xnyAccel; i <= s.maxAccel - 1; ++i)
-    s.zones[s.maxAccel + (s.maxAccel - 1) - (i - xnyAccel)] = (unsigned short)(RAD2SHORT(acosf((i + .5f) / s.a)));
-
-  // Merge 2 sorted arrays in the lowerhalf
-  unsigned char bi      = s.maxAccel + 0;          // begin i
-  unsigned char ei      = s.maxAccel + xnyAccel;   // end   i
-  unsigned char bj      = s.maxAccel + xnyAccel;   // begin j
-  unsigned char ej      = s.maxAccel + s.maxAccel; // end   j
-  unsigned char i       = bi;
-  unsigned char j       = bj;
-  unsigned char k       = 0;
-  unsigned char xAccel_ = s.maxAccel - (j - bj);
-  unsigned char yAccel_ = i - bi;
-  float         absAccel_;
-  s.minAbsAccel = (float)(2 * s.maxAccel); // upperbound > sqrt(2)*s.maxAccel
-  s.maxAbsAccel = 0;                       // lowerbound
-  while (i < ei && j < ej)
-  {
-    absAccel_ = sqrtf((float)(xAccel_ * xAccel_ + yAccel_ * yAccel_));
-    if (absAccel_ < s.minAbsAccel) s.minAbsAccel = absAccel_;
-    if (absAccel_ > s.maxAbsAccel) s.maxAbsAccel = absAccel_;
-    s.xAccel[k]                    = xAccel_;
-    s.yAccel[k]                    = yAccel_;
-    s.absAccel[k]                  = absAccel_;
-    s.xAccel[2 * s.maxAccel - k]   = yAccel_;
-    s.yAccel[2 * s.maxAccel - k]   = xAccel_;
-    s.absAccel[2 * s.maxAccel - k] = absAccel_;
-    if (s.zones[i] < s.zones[j])
-    {
-      s.zones[k++] = s.zones[i++];
-      yAccel_      = i - bi;
-    }
-    else
-    {
-      s.zones[k++] = s.zones[j++];
-      xAccel_      = s.maxAccel - (j - bj);
-    }
+  ASSERT_GT(a, 0);
+  ASSERT_LE(a, 50);
+  int32_t const maxAccel = (int32_t)(a + .5f);
+  int32_t const xnyAccel = (int32_t)(a / sqrtf(2.f) + .5f); // xAccel and yAccel at 45deg
+  z->maxAccel            = (unsigned char)maxAccel;
+
+  // Below 45deg the x accel drops from i + 1 to i at acos((i + .5) / a) for i >= xnyAccel, the y accel rises from i
+  // to i + 1 at asin((i + .5) / a) = pi/2 - acos((i + .5) / a) for i < xnyAccel. Lanes past maxAccel are clamped.
+  float      edges[SNAP_BATCH];
+  vf_t const va  = vf_set1(a);
+  vf_t const one = vf_set1(1);
+  for (int32_t i = 0; i < maxAccel; i += SIMD_WIDTH)
+  {
+    vf_t const x = vf_div(vf_iota(i + .5f), va);
+    vf_store(edges + i, vf_acos(vf_min(x, one)));
+  }
+
+  // both increasing, ended by a sentinel
+  float         y[SNAP_BATCH + 1];
+  float         x[SNAP_BATCH + 1];
+  int32_t const ny = xnyAccel;
+  int32_t const nx = maxAccel - xnyAccel;
+  for (int32_t i = 0; i < ny; ++i) y[i] = (float)M_PI / 2 - edges[i];
+  for (int32_t i = 0; i < nx; ++i) x[i] = edges[maxAccel - 1 - i];
+  y[ny] = INFINITY;
+  x[nx] = INFINITY;
+
+  // Branch-free merge of the two, zone k ends at edge k: until then maxAccel - j x edges and i y edges were passed.
+  float   ax[SNAP_BATCH];
+  float   ay[SNAP_BATCH];
+  int32_t i = 0;
+  int32_t j = 0;
+  for (int32_t k = 0; k < maxAccel; ++k)
+  {
+    float const   next[2] = { x[j], y[i] };
+    int32_t const takeY   = y[i] < x[j];
+    ax[k]                 = (float)(maxAccel - j);
+    ay[k]                 = (float)i;
+    z->zones[k]           = next[takeY];
+    i += takeY;
+    j += 1 - takeY;
+  }
+  // the zone at 45deg, repeated as padding
+  for (int32_t k = maxAccel; k < SIMD_ROUND_UP(maxAccel + 1); ++k)
+  {
+    ax[k] = (float)xnyAccel;
+    ay[k] = (float)xnyAccel;
+  }
+
+  float absAccel[SNAP_BATCH];
+  vf_t  minAbsAccel = vf_set1(INFINITY);
+  vf_t  maxAbsAccel = vf_set1(0);
+  for (int32_t k = 0; k <= maxAccel; k += SIMD_WIDTH)
+  {
+    vf_t const xAccel = vf_load(ax + k);
+    vf_t const yAccel = vf_load(ay + k);
+    vf_t const abs    = vf_sqrt(vf_add(vf_mul(xAccel, xAccel), vf_mul(yAccel, yAccel)));
+    vf_store(absAccel + k, abs);
+    minAbsAccel = vf_min(minAbsAccel, abs);
+    maxAbsAccel = vf_max(maxAbsAccel, abs);
+  }
+  z->minAbsAccel = vf_hmin(minAbsAccel);
+  z->maxAbsAccel = vf_hmax(maxAbsAccel);
+
+  // Above 45deg x and y swap roles, mirrored at 45deg
+  for (int32_t k = 0; k <= maxAccel; ++k)
+  {
+    z->xAccel[k]                  = (unsigned char)ax[k];
+    z->yAccel[k]                  = (unsigned char)ay[k];
+    z->absAccel[k]                = absAccel[k];
+    z->xAccel[2 * maxAccel - k]   = (unsigned char)ay[k];
+    z->yAccel[2 * maxAccel - k]   = (unsigned char)ax[k];
+    z->absAccel[2 * maxAccel - k] = absAccel[k];
   }
-  while (i < ei) // Store remaining elements
-  {
-    absAccel_ = sqrtf((float)(xAccel_ * xAccel_ + yAccel_ * yAccel_));
-    if (absAccel_ < s.minAbsAccel) s.minAbsAccel = absAccel_;
-    if (absAccel_ > s.maxAbsAccel) s.maxAbsAccel = absAccel_;
-    s.xAccel[k]                    = xAccel_;
-    s.yAccel[k]                    = yAccel_;
-    s.absAccel[k]                  = absAccel_;
-    s.xAccel[2 * s.maxAccel - k]   = yAccel_;
-    s.yAccel[2 * s.maxAccel - k]   = xAccel_;
-    s.absAccel[2 * s.maxAccel - k] = absAccel_;
-    s.zones[k++]                   = s.zones[i++];
-    yAccel_                        = i - bi;
-  }
-  while (j < ej) // Store remaining elements
-  {
-    absAccel_ = sqrtf((float)(xAccel_ * xAccel_ + yAccel_ * yAccel_));
-    if (absAccel_ < s.minAbsAccel) s.minAbsAccel = absAccel_;
-    if (absAccel_ > s.maxAbsAccel) s.maxAbsAccel = absAccel_;
-    s.xAccel[k]                    = xAccel_;
-    s.yAccel[k]                    = yAccel_;
-    s.absAccel[k]                  = absAccel_;
-    s.xAccel[2 * s.maxAccel - k]   = yAccel_;
-    s.yAccel[2 * s.maxAccel - k]   = xAccel_;
-    s.absAccel[2 * s.maxAccel - k] = absAccel_;
-    s.zones[k++]                   = s.zones[j++];
-    xAccel_                        = s.maxAccel - (j - bj);
-  }
-  // Fill in the acceleration of the snapzone at 45deg since we only searched for shortangles
-  // smaller than 45deg (= 8192)
-  absAccel_ = sqrtf(2) * xnyAccel;
-  if (absAccel_ < s.minAbsAccel) s.minAbsAccel = absAccel_;
-  if (absAccel_ > s.maxAbsAccel) s.maxAbsAccel = absAccel_;
-  s.xAccel[k]   = xnyAccel;
-  s.yAccel[k]   = xnyAccel;
-  s.absAccel[k] = absAccel_;
-
-  for (i = 0; i < s.maxAccel; ++i) s.zones[s.maxAccel + i] = 16383 - s.zones[s.maxAccel - 1 - i];
-  s.zones[2 * s.maxAccel] = s.zones[0] + 16384;
-
-  // g_syscall( CG_PRINT, vaf("%.3f %.3f\n", s.minAbsAccel, s.maxAbsAccel));
-
-  // for (int i = 0; i < 2*s.maxAccel; i++)
-  //     g_syscall( CG_PRINT, vaf("%u ", s.zones[i]));
-  // g_syscall( CG_PRINT, "\n");
-
-  // for (int i = 0; i < 2*s.maxAccel; i++)
-  //     g_syscall( CG_PRINT, vaf("%.3f ", s.absAccel[i]));
-  // g_syscall( CG_PRINT, "\n");
+  for (int32_t k = 0; k < maxAccel; ++k) z->zones[maxAccel + k] = (float)M_PI / 2 - z->zones[maxAccel - 1 - k];
+  z->zones[2 * maxAccel] = z->zones[0] + (float)M_PI / 2;
+}
+
+snapZones_t const* snap_zones(float a)
+{
+  for (uint8_t i = 0; i < cache.count; ++i)
+  {
+    if (cache.a[i] == a) return &cache.z[i];
+  }
+
+  uint8_t const i = cache.count < SNAP_ZONES_CACHED ? cache.count++ : cache.next;
+  cache.next      = (i + 1) % SNAP_ZONES_CACHED;
+  cache.a[i]      = a;
+  update_snap_zones(&cache.z[i], a);
+  return &cache.z[i];
 }
 
 static void one_zone_draw(
-  int const      start,
-  int const      end,
-  int const      yaw,
+  float const    start,
+  float const    end,
+  float const    yaw,
   float const    y,
   float const    h,
   vec4_t* const  def_color,
@@ -644,83 +628,104 @@ static void one_zone_draw(
 {
   ASSERT_LE(start, end);
   ASSERT_LE(alt_color, 1); // 0 or 1
-  if (hl_color && AngleNormalize65536(yaw - start) <= AngleNormalize65536(end - start))
+  if (hl_color && AngleNormalize2PI(yaw - start) <= end - start)
   {
-    CG_FillAngleYaw(SHORT2RAD(start), SHORT2RAD(end), SHORT2RAD(yaw), y, h, s.graph_rgba[2 + alt_color]);
+    CG_FillAngleYaw(start, end, yaw, y, h, s.graph_rgba[2 + alt_color]);
   }
   else
   {
-    CG_FillAngleYaw(SHORT2RAD(start), SHORT2RAD(end), SHORT2RAD(yaw), y, h, def_color[alt_color]);
+    CG_FillAngleYaw(start, end, yaw, y, h, def_color[alt_color]);
   }
 }
 
-static void one_snap_draw(int yaw)
+// Drops the least important layers first when the frame budget limits the nb of layers drawn.
+static uint32_t snap_layers(void)
 {
+  static uint32_t const priority[] = { SNAP_NORMAL, SNAP_HEIGHT, SNAP_45, SNAP_BLUERED };
+
+  uint32_t layers = snap.integer & SNAP_HL_ACTIVE;
+  int32_t  left   = quality()->snap_layers;
+  for (size_t i = 0; i < ARRAY_LEN(priority) && left > 0; ++i)
+  {
+    if (!(snap.integer & priority[i])) continue;
+    layers |= priority[i];
+    --left;
+  }
+  return layers;
+}
+
+static void one_snap_draw(float yaw)
+{
+  if (!s.z) return; // no acceleration yet
+
   ParseVec(snap_yh.string, s.graph_yh, 2);
   for (uint8_t i = 0; i < 6; ++i) ParseVec(snap_cvars[5 + i].vmCvar->string, s.graph_rgba[i], 4);
 
-  if (snap.integer & SNAP_BLUERED) // blue/red (min/max accel)
+  s.mode = snap_layers();
+
+  if (s.mode & SNAP_BLUERED) // blue/red (min/max accel)
   {
     vec4_t colorr;
-    float  diffAbsAccel = s.maxAbsAccel - s.minAbsAccel;
-    for (int i = 0; i < 2 * s.maxAccel; ++i)
+    float  diffAbsAccel = s.z->maxAbsAccel - s.z->minAbsAccel;
+    for (int i = 0; i < 2 * s.z->maxAccel; ++i)
     {
-      colorr[0] = (s.absAccel[i + 1] - s.minAbsAccel) / diffAbsAccel;
+      colorr[0] = (s.z->absAccel[i + 1] - s.z->minAbsAccel) / diffAbsAccel;
       colorr[1] = 0.f;
-      colorr[2] = (s.maxAbsAccel - s.absAccel[i + 1]) / diffAbsAccel;
+      colorr[2] = (s.z->maxAbsAccel - s.z->absAccel[i + 1]) / diffAbsAccel;
       colorr[3] = s.graph_rgba[0][3];
-      for (int j = 0; j < 65536; j += 16384)
+      for (int j = 0; j < 4; ++j)
       {
-        int const bSnap = s.zones[i] + 1 + j;
-        int const eSnap = s.zones[i + 1] + 0 + j;
-        one_zone_draw(bSnap, eSnap, yaw, s.graph_yh[0], s.graph_yh[1], &colorr, 0, snap.integer & SNAP_HL_ACTIVE);
+        float const bSnap = s.z->zones[i] + j * (float)M_PI / 2;
+        float const eSnap = s.z->zones[i + 1] + j * (float)M_PI / 2;
+        one_zone_draw(bSnap, eSnap, yaw, s.graph_yh[0], s.graph_yh[1], &colorr, 0, s.mode & SNAP_HL_ACTIVE);
       }
     }
   }
-  if (snap.integer & SNAP_45) // shifted 45deg
+  if (s.mode & SNAP_45) // shifted 45deg
   {
     int8_t alt_color = 0;
-    for (int i = 0; i < 2 * s.maxAccel; ++i)
+    for (int i = 0; i < 2 * s.z->maxAccel; ++i)
     {
-      for (int j = 0; j < 65536; j += 16384)
+      for (int j = 0; j < 4; ++j)
       {
-        int const bSnap = s.zones[i] + 1 + j;
-        int const eSnap = s.zones[i + 1] + 0 + j;
-        one_zone_draw(bSnap, eSnap, yaw + 8192, s.graph_yh[0], s.graph_yh[1], &s.graph_rgba[4], alt_color, qfalse);
+        float const bSnap = s.z->zones[i] + j * (float)M_PI / 2;
+        float const eSnap = s.z->zones[i + 1] + j * (float)M_PI / 2;
+        one_zone_draw(
+          bSnap, eSnap, yaw + (float)M_PI / 4, s.graph_yh[0], s.graph_yh[1], &s.graph_rgba[4], alt_color, qfalse);
       }
       alt_color ^= 1;
     }
   }
-  if (snap.integer & SNAP_NORMAL) // normal
+  if (s.mode & SNAP_NORMAL) // normal
   {
     int8_t alt_color = 0;
-    for (int i = 0; i < 2 * s.maxAccel; ++i)
+    for (int i = 0; i < 2 * s.z->maxAccel; ++i)
     {
-      for (int j = 0; j < 65536; j += 16384)
+      for (int j = 0; j < 4; ++j)
       {
-        int const bSnap = s.zones[i] + 1 + j;
-        int const eSnap = s.zones[i + 1] + 0 + j;
+        float const bSnap = s.z->zones[i] + j * (float)M_PI / 2;
+        float const eSnap = s.z->zones[i + 1] + j * (float)M_PI / 2;
         one_zone_draw(
-          bSnap, eSnap, yaw, s.graph_yh[0], s.graph_yh[1], &s.graph_rgba[0], alt_color, snap.integer & SNAP_HL_ACTIVE);
+          bSnap, eSnap, yaw, s.graph_yh[0], s.graph_yh[1], &s.graph_rgba[0], alt_color, s.mode & SNAP_HL_ACTIVE);
       }
       alt_color ^= 1;
     }
   }
-  if (snap.integer & SNAP_HEIGHT) // heavily inspired by breadsticks' version
+  if (s.mode & SNAP_HEIGHT) // heavily inspired by breadsticks' version
   {
     float       gain;
-    float const diffAbsAccel = s.maxAbsAccel - s.minAbsAccel;
-    for (int i = 0; i < 2 * s.maxAccel; ++i)
+    float const diffAbsAccel = s.z->maxAbsAccel - s.z->minAbsAccel;
+    for (int i = 0; i < 2 * s.z->maxAccel; ++i)
     {
-      gain           = (s.absAccel[i + 1] - s.minAbsAccel) / diffAbsAccel;
+      gain           = (s.z->absAccel[i + 1] - s.z->minAbsAccel) / diffAbsAccel;
       gain           = gain * .8f + .2f;
       float const h_ = s.graph_yh[1] * gain;
       float const y_ = s.graph_yh[0] + s.graph_yh[1] * (1.f - gain);
-      for (int j = 0; j < 65536; j += 16384)
+      for (int j = 0; j < 4; ++j)
       {
-        int const bSnap = s.zones[i] + 1 + j;
-        int const eSnap = s.zones[i + 1] + 0 + j;
-        one_zone_draw(bSnap, eSnap, yaw, y_, h_, &s.graph_rgba[0], 0, snap.integer & SNAP_HL_ACTIVE);
+        float const bSnap = s.z->zones[i] + j * (float)M_PI / 2;
+        float const eSnap = s.z->zones[i + 1] + j * (float)M_PI / 2;
+        one_zone_draw(bSnap, eSnap, yaw, y_, h_, &s.graph_rgba[0], 0, s.mode & SNAP_HL_ACTIVE);
       }
     }
   }
@@ -24,13 +24,113 @@
 #include "cg_entity.h"
 #include "cg_gl.h"
 #include "cg_local.h"
+#include "cg_vm.h"
 #include "cg_rl.h"
-
-static intptr_t(QDECL* syscall)(intptr_t, ...) = (intptr_t(QDECL*)(intptr_t, ...)) - 1;
+#include "perf.h"
+#include "profile.h"
+#include "quality.h"
+#include "syscall_log.h"
+#include "syscall_stats.h"
+
+static intptr_t(QDECL* engine_syscall)(intptr_t, ...) = (intptr_t(QDECL*)(intptr_t, ...)) - 1;
+static intptr_t(QDECL* syscall)(intptr_t, ...)        = (intptr_t(QDECL*)(intptr_t, ...)) - 1;
+
+static qboolean recording;
+static qboolean sampling;
+static qboolean profiling;
+static qboolean measuring;
+
+// The traps call the engine through the recorder, the profiler, the frame cost measurement and the statistics when
+// they're enabled.
+static void chain_syscalls(void)
+{
+  syscall = engine_syscall;
+  if (sampling)
+  {
+    syscall_stats_chain(syscall);
+    syscall = syscall_stats_record;
+  }
+  if (measuring)
+  {
+    perf_chain(syscall);
+    syscall = perf_syscall;
+  }
+  if (profiling)
+  {
+    profile_chain(syscall);
+    syscall = profile_syscall;
+  }
+  if (recording)
+  {
+    syscall_log_chain(syscall);
+    syscall = syscall_log_record;
+  }
+}
 
 void dllEntry(intptr_t(QDECL* syscallptr)(intptr_t arg, ...))
 {
-  syscall = syscallptr;
+  engine_syscall = syscallptr;
+  chain_syscalls();
+}
+
+void start_syscall_recording(void)
+{
+  recording = syscall_log_start(engine_syscall);
+  chain_syscalls();
+}
+
+void stop_syscall_recording(void)
+{
+  syscall_log_stop();
+  recording = qfalse;
+  chain_syscalls();
+}
+
+void sample_syscalls(qboolean sample)
+{
+  if (sample == sampling) return;
+  sampling = sample;
+  chain_syscalls();
+}
+
+void profile_syscalls(qboolean profile)
+{
+  if (profile == profiling) return;
+  profiling = profile;
+  chain_syscalls();
+}
+
+void measure_syscalls(qboolean measure)
+{
+  if (measure == measuring) return;
+  measuring = measure;
+  chain_syscalls();
+}
+
+void read_syscall_args(va_list ap, intptr_t* args)
+{
+  for (int32_t i = 0; i < SYSCALL_ARGS; ++i) args[i] = va_arg(ap, intptr_t);
+}
+
+intptr_t forward_syscall(intptr_t(QDECL* next)(intptr_t, ...), intptr_t cmd, intptr_t const* args)
+{
+  return next(
+    cmd,
+    args[0],
+    args[1],
+    args[2],
+    args[3],
+    args[4],
+    args[5],
+    args[6],
+    args[7],
+    args[8],
+    args[9],
+    args[10],
+    args[11],
+    args[12],
+    args[13],
+    args[14]);
 }
 
 static inline int32_t FloatAsInt(float f)
@@ -305,299 +405,314 @@ qboolean trap_GetEntityToken(char* buffer, int32_t bufferSize)
 
 #define _ptr(x) (add(x)) // ???
 
-intptr_t QDECL CG_SysCalls(uint8_t* memoryBase, int32_t cmd, int32_t* args)
+intptr_t QDECL CG_SysCalls(struct vm_s* vm, int32_t cmd, int32_t* args)
 {
+  uint8_t* const memoryBase = vm->dataSegment;
+
+  // a vm with an engine of its own bypasses the proxy, its chain and its hud
+  qboolean const proxied                     = !vm->engine;
+  intptr_t(QDECL* const call)(intptr_t, ...) = proxied ? syscall : vm->engine;
+
+  if (proxied && sampling) syscall_stats_vm(cmd);
+
   switch (cmd)
   {
   case CG_PRINT: // void trap_Printf( char const *fmt )
-    syscall(cmd, ptr(0));
+    call(cmd, ptr(0));
     return 0;
 
   case CG_ERROR: // void trap_Error( char const *fmt )
-    syscall(cmd, ptr(0));
+    call(cmd, ptr(0));
     return 0;
 
   case CG_MILLISECONDS: // int32_t trap_Milliseconds( void )
-    return syscall(cmd);
+    return call(cmd);
 
   case CG_ARGC: // int32_t trap_Argc( void )
-    return syscall(cmd);
+    return call(cmd);
 
   case CG_ARGV: // void trap_Argv( int32_t n, char *buffer, int32_t bufferLength )
-    syscall(cmd, arg(0), ptr(1), arg(2));
+    call(cmd, arg(0), ptr(1), arg(2));
     return 0;
 
   case CG_ARGS:
-    syscall(cmd, ptr(0), arg(1));
+    call(cmd, ptr(0), arg(1));
     return 0;
 
   case CG_FS_FOPENFILE: // int32_t   trap_FS_FOpenFile( char const *qpath, fileHandle_t *f, fsMode_t mode )
-    return syscall(cmd, ptr(0), ptr(1), arg(2));
+    return call(cmd, ptr(0), ptr(1), arg(2));
 
   case CG_FS_READ: // void  trap_FS_Read( void *buffer, int32_t len, fileHandle_t f )
-    syscall(cmd, ptr(0), arg(1), arg(2));
+    call(cmd, ptr(0), arg(1), arg(2));
     return 0;
 
   case CG_FS_WRITE: // void  trap_FS_Write( void const *buffer, int32_t len, fileHandle_t f )
-    syscall(cmd, ptr(0), arg(1), arg(2));
+    call(cmd, ptr(0), arg(1), arg(2));
     return 0;
 
   case CG_FS_FCLOSEFILE: // void  trap_FS_FCloseFile( fileHandle_t f )
-    syscall(cmd, arg(0));
+    call(cmd, arg(0));
     return 0;
 
   case CG_FS_SEEK: // int32_t trap_FS_Seek( fileHandle_t f, long offset, int32_t origin )
-    return syscall(cmd, arg(0), arg(1), arg(2));
+    return call(cmd, arg(0), arg(1), arg(2));
 
   case CG_SENDCONSOLECOMMAND: // void  trap_SendConsoleCommand( int32_t exec_when, char const *text )
-    syscall(cmd, ptr(0));
+    call(cmd, ptr(0));
     return 0;
 
   case CG_CVAR_REGISTER: // void  trap_Cvar_Register( vmCvar_t *cvar, char const *var_name, char const *value, int32_t
                          // flags )
-    syscall(cmd, ptr(0), ptr(1), ptr(2), arg(3));
+    call(cmd, ptr(0), ptr(1), ptr(2), arg(3));
     return 0;
 
   case CG_CVAR_UPDATE: // void  trap_Cvar_Update( vmCvar_t *cvar )
-    syscall(cmd, ptr(0));
+    call(cmd, ptr(0));
     return 0;
 
   case CG_CVAR_SET: // void trap_Cvar_Set( char const *var_name, char const *value )
-    syscall(cmd, ptr(0), ptr(1));
+    call(cmd, ptr(0), ptr(1));
     return 0;
 
   case CG_CVAR_VARIABLESTRINGBUFFER: // void trap_Cvar_VariableStringBuffer( char const *var_name, char *buffer, int32_t
                                      // bufsize )
-    syscall(cmd, ptr(0), ptr(1), arg(2));
+    call(cmd, ptr(0), ptr(1), arg(2));
     return 0;
 
   case CG_ADDCOMMAND: // void CL_AddCgameCommand( char const *cmdName )
-    syscall(cmd, ptr(0));
+    call(cmd, ptr(0));
     return 0;
 
   case CG_REMOVECOMMAND:
-    syscall(cmd, ptr(0));
+    call(cmd, ptr(0));
     return 0;
   case CG_SENDCLIENTCOMMAND:
-    syscall(cmd, ptr(0));
+    call(cmd, ptr(0));
     return 0;
   case CG_UPDATESCREEN:
-    syscall(cmd);
+    call(cmd);
     return 0;
   case CG_CM_LOADMAP:
-    syscall(cmd, ptr(0));
+    call(cmd, ptr(0));
     return 0;
   case CG_CM_NUMINLINEMODELS:
-    return syscall(cmd);
+    return call(cmd);
   case CG_CM_INLINEMODEL:
-    return syscall(cmd, arg(0));
+    return call(cmd, arg(0));
   case CG_CM_TEMPBOXMODEL:
-    return syscall(cmd, ptr(0), ptr(1));
+    return call(cmd, ptr(0), ptr(1));
   case CG_CM_TEMPCAPSULEMODEL:
-    return syscall(cmd, ptr(0), ptr(1));
+    return call(cmd, ptr(0), ptr(1));
   case CG_CM_POINTCONTENTS:
-    return syscall(cmd, ptr(0), arg(1));
+    return call(cmd, ptr(0), arg(1));
   case CG_CM_TRANSFORMEDPOINTCONTENTS:
-    return syscall(cmd, ptr(0), arg(1), ptr(2), ptr(3));
+    return call(cmd, ptr(0), arg(1), ptr(2), ptr(3));
   case CG_CM_BOXTRACE:
-    syscall(cmd, ptr(0), ptr(1), ptr(2), ptr(3), ptr(4), arg(5), arg(6));
+    call(cmd, ptr(0), ptr(1), ptr(2), ptr(3), ptr(4), arg(5), arg(6));
     return 0;
   case CG_CM_CAPSULETRACE:
-    syscall(cmd, ptr(0), ptr(1), ptr(2), ptr(3), ptr(4), arg(5), arg(6));
+    call(cmd, ptr(0), ptr(1), ptr(2), ptr(3), ptr(4), arg(5), arg(6));
     return 0;
   case CG_CM_TRANSFORMEDBOXTRACE:
-    syscall(cmd, ptr(0), ptr(1), ptr(2), ptr(3), ptr(4), arg(5), arg(6), ptr(7), ptr(8));
+    call(cmd, ptr(0), ptr(1), ptr(2), ptr(3), ptr(4), arg(5), arg(6), ptr(7), ptr(8));
     return 0;
   case CG_CM_TRANSFORMEDCAPSULETRACE:
-    syscall(cmd, ptr(0), ptr(1), ptr(2), ptr(3), ptr(4), arg(5), arg(6), ptr(7), ptr(8));
+    call(cmd, ptr(0), ptr(1), ptr(2), ptr(3), ptr(4), arg(5), arg(6), ptr(7), ptr(8));
     return 0;
   case CG_CM_MARKFRAGMENTS:
-    return syscall(cmd, arg(0), ptr(1), ptr(2), arg(3), ptr(4), arg(5), ptr(6));
+    return call(cmd, arg(0), ptr(1), ptr(2), arg(3), ptr(4), arg(5), ptr(6));
   case CG_S_STARTSOUND:
-    if (should_filter_sound(arg(1), 0)) return 0;
-    syscall(cmd, ptr(0), arg(1), arg(2), arg(3));
+    if (proxied && should_filter_sound(arg(1), 0)) return 0;
+    call(cmd, ptr(0), arg(1), arg(2), arg(3));
     return 0;
   case CG_S_STARTLOCALSOUND:
-    syscall(cmd, arg(0), arg(1));
+    call(cmd, arg(0), arg(1));
     return 0;
   case CG_S_CLEARLOOPINGSOUNDS:
-    syscall(cmd, arg(0));
+    call(cmd, arg(0));
     return 0;
   case CG_S_ADDLOOPINGSOUND:
-    if (should_filter_sound(arg(0), 1)) return 0;
-    syscall(cmd, arg(0), ptr(1), ptr(2), arg(3));
+    if (proxied && should_filter_sound(arg(0), 1)) return 0;
+    call(cmd, arg(0), ptr(1), ptr(2), arg(3));
     return 0;
   case CG_S_ADDREALLOOPINGSOUND:
-    syscall(cmd, arg(0), ptr(1), ptr(2), arg(3));
+    call(cmd, arg(0), ptr(1), ptr(2), arg(3));
     return 0;
   case CG_S_STOPLOOPINGSOUND:
-    syscall(cmd, arg(0));
+    call(cmd, arg(0));
     return 0;
   case CG_S_UPDATEENTITYPOSITION:
-    syscall(cmd, arg(0), ptr(1));
+    call(cmd, arg(0), ptr(1));
     return 0;
   case CG_S_RESPATIALIZE:
-    syscall(cmd, arg(0), ptr(1), ptr(2), arg(3));
+    call(cmd, arg(0), ptr(1), ptr(2), arg(3));
     return 0;
   case CG_S_REGISTERSOUND:
-    return syscall(cmd, ptr(0), arg(1));
+    return call(cmd, ptr(0), arg(1));
   case CG_S_STARTBACKGROUNDTRACK:
-    syscall(cmd, ptr(0), ptr(1));
+    call(cmd, ptr(0), ptr(1));
     return 0;
   case CG_R_LOADWORLDMAP:
-    syscall(cmd, ptr(0));
+    call(cmd, ptr(0));
     return 0;
   case CG_R_REGISTERMODEL:
-    return syscall(cmd, ptr(0));
+    return call(cmd, ptr(0));
   case CG_R_REGISTERSKIN:
-    return syscall(cmd, ptr(0));
+    return call(cmd, ptr(0));
   case CG_R_REGISTERSHADER:
-    return syscall(cmd, ptr(0));
+    return call(cmd, ptr(0));
 
   case CG_R_REGISTERSHADERNOMIP:
-    return syscall(cmd, ptr(0));
+    return call(cmd, ptr(0));
   case CG_R_REGISTERFONT:
-    syscall(cmd, ptr(0), arg(1), ptr(2));
+    call(cmd, ptr(0), arg(1), ptr(2));
     return 0;
   case CG_R_CLEARSCENE:
-    syscall(cmd);
+    call(cmd);
     return 0;
   case CG_R_ADDREFENTITYTOSCENE:
-    syscall(cmd, ptr(0));
+    call(cmd, ptr(0));
     return 0;
   case CG_R_ADDPOLYTOSCENE:
-    syscall(cmd, arg(0), arg(1), ptr(2));
+    call(cmd, arg(0), arg(1), ptr(2));
     return 0;
   case CG_R_ADDPOLYSTOSCENE:
-    syscall(cmd, arg(0), arg(1), ptr(2), arg(3));
+    call(cmd, arg(0), arg(1), ptr(2), arg(3));
     return 0;
   case CG_R_LIGHTFORPOINT:
-    return syscall(cmd, ptr(0), ptr(1), ptr(2), ptr(3));
+    return call(cmd, ptr(0), ptr(1), ptr(2), ptr(3));
   case CG_R_ADDLIGHTTOSCENE:
-    syscall(cmd, ptr(0), arg(1), arg(2), arg(3), arg(4));
+    call(cmd, ptr(0), arg(1), arg(2), arg(3), arg(4));
     return 0;
   case CG_R_ADDADDITIVELIGHTTOSCENE:
-    syscall(cmd, ptr(0), arg(1), arg(2), arg(3), arg(4));
+    call(cmd, ptr(0), arg(1), arg(2), arg(3), arg(4));
     return 0;
   case CG_R_RENDERSCENE:
-    draw_gl();
-    draw_rl();
-    draw_bbox();
-
-    syscall(cmd, ptr(0));
+    if (proxied)
+    {
+      quality_measure_begin();
+      perf_enter(PERF_PROXY);
+      perf_call(PERF_GL, "draw_gl", draw_gl);
+      perf_call(PERF_RL, "draw_rl", draw_rl);
+      perf_call(PERF_OTHER, "draw_bbox", draw_bbox);
+      perf_leave();
+      quality_measure_end();
+    }
+
+    call(cmd, ptr(0));
     return 0;
   case CG_R_SETCOLOR:
-    syscall(cmd, ptr(0));
+    call(cmd, ptr(0));
     return 0;
   case CG_R_DRAWSTRETCHPIC:
-    syscall(cmd, arg(0), arg(1), arg(2), arg(3), arg(4), arg(5), arg(6), arg(7), arg(8));
+    call(cmd, arg(0), arg(1), arg(2), arg(3), arg(4), arg(5), arg(6), arg(7), arg(8));
     return 0;
   case CG_R_MODELBOUNDS:
-    syscall(cmd, arg(0), ptr(1), ptr(2));
+    call(cmd, arg(0), ptr(1), ptr(2));
     return 0;
   case CG_R_LERPTAG:
-    return syscall(cmd, ptr(0), arg(1), arg(2), arg(3), arg(4), ptr(5));
+    return call(cmd, ptr(0), arg(1), arg(2), arg(3), arg(4), ptr(5));
   case CG_GETGLCONFIG:
-    syscall(cmd, ptr(0));
+    call(cmd, ptr(0));
     return 0;
   case CG_GETGAMESTATE: // void CL_GetGameState( gameState_t *gs )
-    syscall(cmd, ptr(0));
+    call(cmd, ptr(0));
     return 0;
 
   case CG_GETCURRENTSNAPSHOTNUMBER: // void  CL_GetCurrentSnapshotNumber( int32_t *snapshotNumber, int32_t *serverTime )
-    syscall(cmd, ptr(0), ptr(1));
+    call(cmd, ptr(0), ptr(1));
     return 0;
 
   case CG_GETSNAPSHOT: // qboolean  CL_GetSnapshot( int32_t snapshotNumber, snapshot_t *snapshot )
-    return syscall(cmd, arg(0), ptr(1));
+    return call(cmd, arg(0), ptr(1));
 
   case CG_GETSERVERCOMMAND: // qboolean CL_GetServerCommand( int32_t serverCommandNumber )
-    return syscall(cmd, arg(0));
+    return call(cmd, arg(0));
 
   case CG_GETCURRENTCMDNUMBER:
-    return syscall(cmd);
+    return call(cmd);
 
   case CG_GETUSERCMD: // qboolean CL_GetUserCmd( int32_t cmdNumber, usercmd_t *ucmd )
-    return syscall(cmd, arg(0), ptr(1));
+    return call(cmd, arg(0), ptr(1));
 
   case CG_SETUSERCMDVALUE: // void CL_SetUserCmdValue( int32_t userCmdValue, float sensitivityScale )
-    syscall(cmd, arg(0), arg(1));
+    call(cmd, arg(0), arg(1));
     return 0;
 
   case CG_MEMORY_REMAINING:
-    return syscall(cmd);
+    return call(cmd);
   case CG_KEY_ISDOWN:
-    return syscall(cmd, arg(0));
+    return call(cmd, arg(0));
   case CG_KEY_GETCATCHER:
-    return syscall(cmd);
+    return call(cmd);
   case CG_KEY_SETCATCHER:
-    syscall(cmd, arg(0));
+    call(cmd, arg(0));
     return 0;
   case CG_KEY_GETKEY:
-    return syscall(cmd, ptr(0));
+    return call(cmd, ptr(0));
   case CG_MEMSET:
-    syscall(cmd, ptr(0), arg(1), arg(2));
+    call(cmd, ptr(0), arg(1), arg(2));
     return 0;
   case CG_MEMCPY:
-    syscall(cmd, ptr(0), ptr(1), arg(2));
+    call(cmd, ptr(0), ptr(1), arg(2));
     return 0;
   case CG_STRNCPY:
-    return syscall(cmd, ptr(0), ptr(1), arg(2));
+    return call(cmd, ptr(0), ptr(1), arg(2));
   case CG_SIN:
-    return syscall(cmd, arg(0));
+    return call(cmd, arg(0));
   case CG_COS:
-    return syscall(cmd, arg(0));
+    return call(cmd, arg(0));
   case CG_ATAN2:
-    return syscall(cmd, arg(0), arg(1));
+    return call(cmd, arg(0), arg(1));
   case CG_SQRT:
-    return syscall(cmd, arg(0));
+    return call(cmd, arg(0));
   case CG_FLOOR:
-    return syscall(cmd, arg(0));
+    return call(cmd, arg(0));
   case CG_CEIL:
-    return syscall(cmd, arg(0));
+    return call(cmd, arg(0));
   case CG_ACOS:
-    return syscall(cmd, arg(0));
+    return call(cmd, arg(0));
 
   case CG_PC_ADD_GLOBAL_DEFINE:
-    return syscall(cmd, ptr(0));
+    return call(cmd, ptr(0));
   case CG_PC_LOAD_SOURCE:
-    return syscall(cmd, ptr(0));
+    return call(cmd, ptr(0));
   case CG_PC_FREE_SOURCE:
-    return syscall(cmd, arg(0));
+    return call(cmd, arg(0));
   case CG_PC_READ_TOKEN:
-    return syscall(cmd, arg(0), ptr(1));
+    return call(cmd, arg(0), ptr(1));
   case CG_PC_SOURCE_FILE_AND_LINE:
-    return syscall(cmd, arg(0), ptr(1), ptr(2));
+    return call(cmd, arg(0), ptr(1), ptr(2));
 
   case CG_S_STOPBACKGROUNDTRACK:
-    syscall(cmd);
+    call(cmd);
     return 0;
 
   case CG_REAL_TIME:
-    return syscall(cmd, ptr(0));
+    return call(cmd, ptr(0));
   case CG_SNAPVECTOR:
-    syscall(cmd, ptr(0));
+    call(cmd, ptr(0));
     return 0;
 
   case CG_CIN_PLAYCINEMATIC:
-    return syscall(cmd, ptr(0), arg(1), arg(2), arg(3), arg(4), arg(5));
+    return call(cmd, ptr(0), arg(1), arg(2), arg(3), arg(4), arg(5));
 
   case CG_CIN_STOPCINEMATIC:
-    return syscall(cmd, arg(0));
+    return call(cmd, arg(0));
 
   case CG_CIN_RUNCINEMATIC:
-    return syscall(cmd, arg(0));
+    return call(cmd, arg(0));
 
   case CG_CIN_DRAWCINEMATIC:
-    syscall(cmd, arg(0));
+    call(cmd, arg(0));
     return 0;
 
   case CG_CIN_SETEXTENTS:
-    syscall(cmd, arg(0), arg(1), arg(2), arg(3), arg(4));
+    call(cmd, arg(0), arg(1), arg(2), arg(3), arg(4));
     return 0;
 
   case CG_R_REMAP_SHADER:
-    syscall(cmd, ptr(0), ptr(1), ptr(2));
+    call(cmd, ptr(0), ptr(1), ptr(2));
     return 0;
 
     /*
@@ -612,11 +727,224 @@ intptr_t QDECL CG_SysCalls(uint8_t* memoryBase, int32_t cmd, int32_t* args)
         return getCameraInfo(args[1), ptr(1), ptr(2));
     */
   case CG_GET_ENTITY_TOKEN:
-    return syscall(cmd, ptr(0), arg(1));
+    return call(cmd, ptr(0), arg(1));
   case CG_R_INPVS:
-    return syscall(cmd, ptr(0), ptr(1));
+    return call(cmd, ptr(0), ptr(1));
 
   default:
     return 0;
   }
 }
+
+char const* syscall_name(intptr_t cmd)
+{
+  switch (cmd)
+  {
+  case CG_PRINT:
+    return "CG_PRINT";
+  case CG_ERROR:
+    return "CG_ERROR";
+  case CG_MILLISECONDS:
+    return "CG_MILLISECONDS";
+  case CG_CVAR_REGISTER:
+    return "CG_CVAR_REGISTER";
+  case CG_CVAR_UPDATE:
+    return "CG_CVAR_UPDATE";
+  case CG_CVAR_SET:
+    return "CG_CVAR_SET";
+  case CG_CVAR_VARIABLESTRINGBUFFER:
+    return "CG_CVAR_VARIABLESTRINGBUFFER";
+  case CG_ARGC:
+    return "CG_ARGC";
+  case CG_ARGV:
+    return "CG_ARGV";
+  case CG_ARGS:
+    return "CG_ARGS";
+  case CG_FS_FOPENFILE:
+    return "CG_FS_FOPENFILE";
+  case CG_FS_READ:
+    return "CG_FS_READ";
+  case CG_FS_WRITE:
+    return "CG_FS_WRITE";
+  case CG_FS_FCLOSEFILE:
+    return "CG_FS_FCLOSEFILE";
+  case CG_SENDCONSOLECOMMAND:
+    return "CG_SENDCONSOLECOMMAND";
+  case CG_ADDCOMMAND:
+    return "CG_ADDCOMMAND";
+  case CG_SENDCLIENTCOMMAND:
+    return "CG_SENDCLIENTCOMMAND";
+  case CG_UPDATESCREEN:
+    return "CG_UPDATESCREEN";
+  case CG_CM_LOADMAP:
+    return "CG_CM_LOADMAP";
+  case CG_CM_NUMINLINEMODELS:
+    return "CG_CM_NUMINLINEMODELS";
+  case CG_CM_INLINEMODEL:
+    return "CG_CM_INLINEMODEL";
+  case CG_CM_LOADMODEL:
+    return "CG_CM_LOADMODEL";
+  case CG_CM_TEMPBOXMODEL:
+    return "CG_CM_TEMPBOXMODEL";
+  case CG_CM_POINTCONTENTS:
+    return "CG_CM_POINTCONTENTS";
+  case CG_CM_TRANSFORMEDPOINTCONTENTS:
+    return "CG_CM_TRANSFORMEDPOINTCONTENTS";
+  case CG_CM_BOXTRACE:
+    return "CG_CM_BOXTRACE";
+  case CG_CM_TRANSFORMEDBOXTRACE:
+    return "CG_CM_TRANSFORMEDBOXTRACE";
+  case CG_CM_MARKFRAGMENTS:
+    return "CG_CM_MARKFRAGMENTS";
+  case CG_S_STARTSOUND:
+    return "CG_S_STARTSOUND";
+  case CG_S_STARTLOCALSOUND:
+    return "CG_S_STARTLOCALSOUND";
+  case CG_S_CLEARLOOPINGSOUNDS:
+    return "CG_S_CLEARLOOPINGSOUNDS";
+  case CG_S_ADDLOOPINGSOUND:
+    return "CG_S_ADDLOOPINGSOUND";
+  case CG_S_UPDATEENTITYPOSITION:
+    return "CG_S_UPDATEENTITYPOSITION";
+  case CG_S_RESPATIALIZE:
+    return "CG_S_RESPATIALIZE";
+  case CG_S_REGISTERSOUND:
+    return "CG_S_REGISTERSOUND";
+  case CG_S_STARTBACKGROUNDTRACK:
+    return "CG_S_STARTBACKGROUNDTRACK";
+  case CG_R_LOADWORLDMAP:
+    return "CG_R_LOADWORLDMAP";
+  case CG_R_REGISTERMODEL:
+    return "CG_R_REGISTERMODEL";
+  case CG_R_REGISTERSKIN:
+    return "CG_R_REGISTERSKIN";
+  case CG_R_REGISTERSHADER:
+    return "CG_R_REGISTERSHADER";
+  case CG_R_CLEARSCENE:
+    return "CG_R_CLEARSCENE";
+  case CG_R_ADDREFENTITYTOSCENE:
+    return "CG_R_ADDREFENTITYTOSCENE";
+  case CG_R_ADDPOLYTOSCENE:
+    return "CG_R_ADDPOLYTOSCENE";
+  case CG_R_ADDLIGHTTOSCENE:
+    return "CG_R_ADDLIGHTTOSCENE";
+  case CG_R_RENDERSCENE:
+    return "CG_R_RENDERSCENE";
+  case CG_R_SETCOLOR:
+    return "CG_R_SETCOLOR";
+  case CG_R_DRAWSTRETCHPIC:
+    return "CG_R_DRAWSTRETCHPIC";
+  case CG_R_MODELBOUNDS:
+    return "CG_R_MODELBOUNDS";
+  case CG_R_LERPTAG:
+    return "CG_R_LERPTAG";
+  case CG_GETGLCONFIG:
+    return "CG_GETGLCONFIG";
+  case CG_GETGAMESTATE:
+    return "CG_GETGAMESTATE";
+  case CG_GETCURRENTSNAPSHOTNUMBER:
+    return "CG_GETCURRENTSNAPSHOTNUMBER";
+  case CG_GETSNAPSHOT:
+    return "CG_GETSNAPSHOT";
+  case CG_GETSERVERCOMMAND:
+    return "CG_GETSERVERCOMMAND";
+  case CG_GETCURRENTCMDNUMBER:
+    return "CG_GETCURRENTCMDNUMBER";
+  case CG_GETUSERCMD:
+    return "CG_GETUSERCMD";
+  case CG_SETUSERCMDVALUE:
+    return "CG_SETUSERCMDVALUE";
+  case CG_R_REGISTERSHADERNOMIP:
+    return "CG_R_REGISTERSHADERNOMIP";
+  case CG_MEMORY_REMAINING:
+    return "CG_MEMORY_REMAINING";
+  case CG_R_REGISTERFONT:
+    return "CG_R_REGISTERFONT";
+  case CG_KEY_ISDOWN:
+    return "CG_KEY_ISDOWN";
+  case CG_KEY_GETCATCHER:
+    return "CG_KEY_GETCATCHER";
+  case CG_KEY_SETCATCHER:
+    return "CG_KEY_SETCATCHER";
+  case CG_KEY_GETKEY:
+    return "CG_KEY_GETKEY";
+  case CG_PC_ADD_GLOBAL_DEFINE:
+    return "CG_PC_ADD_GLOBAL_DEFINE";
+  case CG_PC_LOAD_SOURCE:
+    return "CG_PC_LOAD_SOURCE";
+  case CG_PC_FREE_SOURCE:
+    return "CG_PC_FREE_SOURCE";
+  case CG_PC_READ_TOKEN:
+    return "CG_PC_READ_TOKEN";
+  case CG_PC_SOURCE_FILE_AND_LINE:
+    return "CG_PC_SOURCE_FILE_AND_LINE";
+  case CG_S_STOPBACKGROUNDTRACK:
+    return "CG_S_STOPBACKGROUNDTRACK";
+  case CG_REAL_TIME:
+    return "CG_REAL_TIME";
+  case CG_SNAPVECTOR:
+    return "CG_SNAPVECTOR";
+  case CG_REMOVECOMMAND:
+    return "CG_REMOVECOMMAND";
+  case CG_R_LIGHTFORPOINT:
+    return "CG_R_LIGHTFORPOINT";
+  case CG_CIN_PLAYCINEMATIC:
+    return "CG_CIN_PLAYCINEMATIC";
+  case CG_CIN_STOPCINEMATIC:
+    return "CG_CIN_STOPCINEMATIC";
+  case CG_CIN_RUNCINEMATIC:
+    return "CG_CIN_RUNCINEMATIC";
+  case CG_CIN_DRAWCINEMATIC:
+    return "CG_CIN_DRAWCINEMATIC";
+  case CG_CIN_SETEXTENTS:
+    return "CG_CIN_SETEXTENTS";
+  case CG_R_REMAP_SHADER:
+    return "CG_R_REMAP_SHADER";
+  case CG_S_ADDREALLOOPINGSOUND:
+    return "CG_S_ADDREALLOOPINGSOUND";
+  case CG_S_STOPLOOPINGSOUND:
+    return "CG_S_STOPLOOPINGSOUND";
+  case CG_CM_TEMPCAPSULEMODEL:
+    return "CG_CM_TEMPCAPSULEMODEL";
+  case CG_CM_CAPSULETRACE:
+    return "CG_CM_CAPSULETRACE";
+  case CG_CM_TRANSFORMEDCAPSULETRACE:
+    return "CG_CM_TRANSFORMEDCAPSULETRACE";
+  case CG_R_ADDADDITIVELIGHTTOSCENE:
+    return "CG_R_ADDADDITIVELIGHTTOSCENE";
+  case CG_GET_ENTITY_TOKEN:
+    return "CG_GET_ENTITY_TOKEN";
+  case CG_R_ADDPOLYSTOSCENE:
+    return "CG_R_ADDPOLYSTOSCENE";
+  case CG_R_INPVS:
+    return "CG_R_INPVS";
+  case CG_FS_SEEK:
+    return "CG_FS_SEEK";
+  case CG_MEMSET:
+    return "CG_MEMSET";
+  case CG_MEMCPY:
+    return "CG_MEMCPY";
+  case CG_STRNCPY:
+    return "CG_STRNCPY";
+  case CG_SIN:
+    return "CG_SIN";
+  case CG_COS:
+    return "CG_COS";
+  case CG_ATAN2:
+    return "CG_ATAN2";
+  case CG_SQRT:
+    return "CG_SQRT";
+  case CG_FLOOR:
+    return "CG_FLOOR";
+  case CG_CEIL:
+    return "CG_CEIL";
+  case CG_TESTPRINTINT:
+    return "CG_TESTPRINTINT";
+  case CG_TESTPRINTFLOAT:
+    return "CG_TESTPRINTFLOAT";
+  case CG_ACOS:
+    return "CG_ACOS";
+  default:
+    return "unknown";
+  }
+}
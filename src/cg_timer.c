@@ -2,6 +2,7 @@
 
 #include "cg_cvar.h"
 #include "cg_draw.h"
+#include "cg_entity.h"
 #include "cg_local.h"
 #include "cg_utils.h"
 #include "help.h"
@@ -10,10 +11,6 @@
 #define MAX_GB_TIME 250
 #define MAX_RL_TIME 15000
 
-#define NADE_EXPLODE_TIME 2500
-
-nade_info_t nades[MAX_NADES];
-
 static vmCvar_t timer;
 static vmCvar_t timer_xywh;
 static vmCvar_t timer_item_w;
@@ -81,8 +78,6 @@ void init_timer(void)
 {
   init_cvars(timer_cvars, ARRAY_LEN(timer_cvars));
   init_help(timer_help, ARRAY_LEN(timer_help));
-
-  for (uint8_t i = 0; i < MAX_NADES; ++i) nades[i].id = -1;
 }
 
 void update_timer(void)
@@ -101,12 +96,6 @@ typedef struct
 
 static timer_t timer_;
 
-// XPC32: Also some of the quadratic loops can be simplified in the nade timer and gl trace code
-//        Because of entity state tracking
-//        And I should prolly be memsetting ent states array to 0 and setting just number or cn to -1 or something
-
-static int  find_nade(int nade_id);
-static int  track_nade(int nade_id, int time);
 static void draw_item(float progress, vec4_t const color);
 
 void draw_timer(void)
@@ -138,90 +127,36 @@ void draw_timer(void)
     draw_item(1.f - (float)ps->pm_time / MAX_GB_TIME, timer_.graph_gb_rgba);
   }
 
-  // cull exploded nades to make space
-  // and set valid nades to not seen in snapshot yet
-  for (int i = 0; i < MAX_NADES; ++i)
+  entityList_t const* const rockets = own_rockets();
+  for (int32_t i = 0; i < rockets->count; ++i)
   {
-    if (nades[i].id == -1) continue;
+    entityState_t const* const entity = rockets->entities[i];
 
-    if (nades[i].explode_time - snap->serverTime <= 0)
-      nades[i].id = -1;
-    else
-      nades[i].seen = 0;
-  }
+    trace_t     t;
+    vec3_t      origin;
+    vec3_t      dest;
+    float const elapsed_time = (cg.time - entity->pos.trTime) * .001f;
 
-  // traverse ent list to update nade infos
-  for (int i = 0; i < snap->numEntities; i++)
-  {
-    entityState_t entity = snap->entities[i];
-    if (entity.eType == ET_MISSILE && entity.weapon == WP_GRENADE_LAUNCHER && entity.clientNum == ps->clientNum)
-    {
-      int const nade_index = find_nade(entity.number);
-      if (nade_index == -1) // new nade
-        track_nade(entity.number, snap->serverTime);
-      else
-        nades[nade_index].seen = 1;
-    }
-    else if (entity.eType == ET_MISSILE && entity.weapon == WP_ROCKET_LAUNCHER && entity.clientNum == ps->clientNum)
-    {
-      trace_t     t;
-      vec3_t      origin;
-      vec3_t      dest;
-      float const elapsed_time = (cg.time - entity.pos.trTime) * .001f;
-
-      VectorMA(entity.pos.trBase, elapsed_time, entity.pos.trDelta, origin);
-      VectorMA(entity.pos.trBase, MAX_RL_TIME * .001f, entity.pos.trDelta, dest);
-
-      // a rocket dest should never change (ignoring movers)
-      // trace doesn't need to be recomputed each time
-      trap_CM_BoxTrace(&t, origin, dest, NULL, NULL, 0, CONTENTS_SOLID);
-      float total_time = Distance(entity.pos.trBase, t.endpos) / VectorLength(entity.pos.trDelta);
-      draw_item(elapsed_time / total_time, timer_.graph_item_rgba);
-    }
-  }
-
-  // cull nades not in snapshot (prolly prematurely detonated) and draw the rest
-  for (int i = 0; i < MAX_NADES; i++)
-  {
-    if (nades[i].id == -1) continue;
+    VectorMA(entity->pos.trBase, elapsed_time, entity->pos.trDelta, origin);
+    VectorMA(entity->pos.trBase, MAX_RL_TIME * .001f, entity->pos.trDelta, dest);
 
-    if (!nades[i].seen)
-    {
-      nades[i].id = -1;
-    }
-    else
-    {
-      float progress = 1.f - (float)(nades[i].explode_time - snap->serverTime) / NADE_EXPLODE_TIME;
-      draw_item(progress, timer_.graph_item_rgba);
-    }
+    // a rocket dest should never change (ignoring movers)
+    // trace doesn't need to be recomputed each time
+    trap_CM_BoxTrace(&t, origin, dest, NULL, NULL, 0, CONTENTS_SOLID);
+    float total_time = Distance(entity->pos.trBase, t.endpos) / VectorLength(entity->pos.trDelta);
+    draw_item(elapsed_time / total_time, timer_.graph_item_rgba);
   }
-}
 
-static int find_nade(int nade_id)
-{
-  for (uint8_t i = 0; i < MAX_NADES; ++i)
+  // draw the nades which haven't exploded yet
+  entityList_t const* const grenades = own_grenades();
+  for (int32_t i = 0; i < grenades->count; ++i)
   {
-    if (nades[i].id == nade_id) return i;
-  }
+    int32_t const explode_time = nade_explode_time(grenades->entities[i]->number);
+    if (!explode_time || explode_time - snap->serverTime <= 0) continue;
 
-  return -1;
-}
-
-static int track_nade(int nade_id, int time)
-{
-  for (uint8_t i = 0; i < MAX_NADES; ++i)
-  {
-    if (nades[i].id == -1)
-    {
-      nades[i].id           = nade_id;
-      nades[i].explode_time = time + NADE_EXPLODE_TIME;
-      nades[i].seen         = 1;
-      return 0;
-    }
+    float progress = 1.f - (float)(explode_time - snap->serverTime) / NADE_EXPLODE_TIME;
+    draw_item(progress, timer_.graph_item_rgba);
   }
-
-  // no free space to track the nade
-  return -1;
 }
 
 static inline void draw_item(float progress, vec4_t const color)
@@ -28,15 +28,23 @@
 snapshot_t const* getSnap(void)
 {
   static snapshot_t snapshot;
+  static int32_t    snapNum    = -1;
+  static int32_t    snapTime   = -1;
   int32_t           curSnapNum;
   int32_t           servertime;
   trap_GetCurrentSnapshotNumber(&curSnapNum, &servertime);
-  trap_GetSnapshot(curSnapNum, &snapshot);
+  // only copy the snapshot when the client system has a newer one
+  if (curSnapNum != snapNum || servertime != snapTime)
+  {
+    trap_GetSnapshot(curSnapNum, &snapshot);
+    snapNum  = curSnapNum;
+    snapTime = servertime;
+  }
   return &snapshot;
 }
 
 playerState_t const* getPs(void)
 {
   if (cvar_getInteger("g_synchronousClients")) return &getSnap()->ps;
-  return (playerState_t const*)VM_ArgPtr(defrag()->pps_offset);
+  return (playerState_t const*)VM_ArgPtr(&g_VM, defrag()->pps_offset);
 }
@@ -20,19 +20,41 @@
   Note: mdd client proxymod contains code from Kevin Masterson a.k.a. CyberMind <kevinm@planetquake.com>
     of the QMM - Q3 MultiMod
 */
+#if defined(__unix__) && !defined(_DEFAULT_SOURCE)
+#  define _DEFAULT_SOURCE // MAP_ANONYMOUS, MAP_NORESERVE
+#endif
+
 #include "cg_vm.h"
 
 #include "cg_hud.h"
 #include "cg_local.h"
 #include "cg_syscall.h"
 #include "defrag.h"
+#include "perf.h"
+#include "profile.h"
 #include "q_assert.h"
+#include "quality.h"
+#include "vm_aot.h"
+#include "vm_hook.h"
+#include "vm_sampler.h"
+#include "vm_tos.h"
 
 #include <stdio.h>
 #include <stdlib.h>
 
+#ifdef VM_GUARD_PAGES
+#  include <sys/mman.h>
+#  include <unistd.h>
+#endif
+
 #define DEFAULT_VMPATH "vm/cgame.qvm"
 
+#ifdef _MSC_VER
+#  define VM_THREAD_LOCAL __declspec(thread)
+#else
+#  define VM_THREAD_LOCAL _Thread_local
+#endif
+
 /* VM_Run, VM_Exec, VM_Create, VM_Destroy, and VM_Restart
  * originally from Q3Fusion (http://www.sourceforge.net/projects/q3fusion/)
  */
@@ -42,8 +64,9 @@
 // modified to include real (non-VM) pointer support
 //---
 // vm = pointer to VM
+// instrumented = count the executed instructions and publish the pc for the sampler
 
-static void VM_Run(vm_t* vm)
+static VM_FORCE_INLINE void VM_RunLoop(vm_t* vm, qboolean const instrumented)
 {
   vmOps_t op;
   int32_t param;
@@ -53,16 +76,23 @@ static void VM_Run(vm_t* vm)
   int32_t* opPointer;
 
   // constants /not changed during execution/
-  byte*    dataSegment;
-  uint32_t dataSegmentMask;
+  byte*          dataSegment;
+  uint32_t       dataSegmentMask;
+  uint8_t const* hookFlags;
+
+  uint64_t instructions = 0;
+
+#ifdef VM_SAMPLER
+  int32_t const* volatile        unsampled;
+  int32_t const* volatile* const samplePc = vm->samplePc ? vm->samplePc : &unsampled;
+#endif
 
   opStack   = vm->opStack;
   opPointer = vm->opPointer;
 
   dataSegment     = vm->dataSegment;
   dataSegmentMask = vm->dataSegmentMask;
-
-  defrag_t const* const df = defrag();
+  hookFlags       = vm->hookFlags; // NULL for a vm nobody set up hooks for
 
   // keep going until opPointer is NULL
   // opPointer is set in OP_LEAVE, stored in the function stack
@@ -73,6 +103,14 @@ static void VM_Run(vm_t* vm)
 #endif
   do
   {
+    if (instrumented)
+    {
+      ++instructions;
+#ifdef VM_SAMPLER
+      *samplePc = opPointer;
+#endif
+    }
+
     // fetch opcode
     op = opPointer[0];
     // get the param
@@ -80,12 +118,17 @@ static void VM_Run(vm_t* vm)
     // move to the next opcode
     opPointer += 2;
 
+    // native hooks, see vm_hook.h
+    if (hookFlags && hookFlags[(opPointer - 2 - vm->codeSegment) / 2])
     {
-      intptr_t const offset = (opPointer - 2 - vm->codeSegment) / 2;
-      if (offset == df->cg_draw2d_vanilla || offset == df->cg_draw2d_defrag)
-      {
-        draw_hud();
-      }
+#ifdef VM_SAMPLER
+      if (instrumented) *samplePc = NULL;
+#endif
+      vm->opStack   = opStack;
+      vm->opPointer = opPointer;
+      run_vm_hooks(vm, (int32_t)(opPointer - 2 - vm->codeSegment) / 2, opStack);
+      opStack   = vm->opStack;
+      opPointer = vm->opPointer;
     }
 
     // here's the magic
@@ -157,12 +200,16 @@ static void VM_Run(vm_t* vm)
         // clear hook var
         vm->hook_realfunc = 0;
 
+#ifdef VM_SAMPLER
+        if (instrumented) *samplePc = NULL;
+#endif
+
         args = (int32_t*)(dataSegment + vm->opBase) + 2;
 
         // if a trap function, call our local syscall, which parses each message
         if (param < 0)
         {
-          ret = (int32_t)CG_SysCalls(dataSegment, -param - 1, args);
+          ret = (int32_t)CG_SysCalls(vm, -param - 1, args);
           // otherwise it's a real function call, grab args and call function
         }
         else
@@ -307,7 +354,7 @@ static void VM_Run(vm_t* vm)
       FOP(>=) break;
 
       //
-      // memory I/O: masks protect main memory
+      // memory I/O: masks or guard pages protect main memory
       //
 
     // get value at address stored in opStack[0], store in opStack[0]
@@ -318,7 +365,7 @@ static void VM_Run(vm_t* vm)
       if (opStack[0] >= vm->memorySize)
         opStack[0] = *(byte*)(intptr_t)(opStack[0]);
       else
-        opStack[0] = dataSegment[opStack[0] & dataSegmentMask];
+        opStack[0] = dataSegment[VM_ADDRESS(opStack[0], dataSegmentMask)];
 
       break;
 
@@ -327,7 +374,7 @@ static void VM_Run(vm_t* vm)
       if (opStack[0] >= vm->memorySize)
         opStack[0] = *(uint16_t*)(intptr_t)(opStack[0]);
       else
-        opStack[0] = *(uint16_t*)&dataSegment[opStack[0] & dataSegmentMask];
+        opStack[0] = *(uint16_t*)&dataSegment[VM_ADDRESS(opStack[0], dataSegmentMask)];
 
       break;
 
@@ -336,7 +383,7 @@ static void VM_Run(vm_t* vm)
       if (opStack[0] >= vm->memorySize)
         opStack[0] = *(int32_t*)(intptr_t)(opStack[0]);
       else
-        opStack[0] = *(int32_t*)&dataSegment[opStack[0] & dataSegmentMask];
+        opStack[0] = *(int32_t*)&dataSegment[VM_ADDRESS(opStack[0], dataSegmentMask)];
 
       break;
 
@@ -346,7 +393,7 @@ static void VM_Run(vm_t* vm)
       if (opStack[1] >= vm->memorySize)
         *(byte*)(intptr_t)(opStack[1]) = (byte)(opStack[0] & 0xFF);
       else
-        dataSegment[opStack[1] & dataSegmentMask] = (byte)(opStack[0] & 0xFF);
+        dataSegment[VM_ADDRESS(opStack[1], dataSegmentMask)] = (byte)(opStack[0] & 0xFF);
 
       opStack += 2;
       break;
@@ -355,7 +402,7 @@ static void VM_Run(vm_t* vm)
       if (opStack[1] >= vm->memorySize)
         *(uint16_t*)(intptr_t)(opStack[1]) = (uint16_t)(opStack[0] & 0xFFFF);
       else
-        *(uint16_t*)&dataSegment[opStack[1] & dataSegmentMask] = (uint16_t)(opStack[0] & 0xFFFF);
+        *(uint16_t*)&dataSegment[VM_ADDRESS(opStack[1], dataSegmentMask)] = (uint16_t)(opStack[0] & 0xFFFF);
 
       opStack += 2;
       break;
@@ -364,39 +411,23 @@ static void VM_Run(vm_t* vm)
       if (opStack[1] >= vm->memorySize)
         *(int32_t*)(intptr_t)(opStack[1]) = opStack[0];
       else
-        *(int32_t*)&dataSegment[opStack[1] & dataSegmentMask] = opStack[0];
+        *(int32_t*)&dataSegment[VM_ADDRESS(opStack[1], dataSegmentMask)] = opStack[0];
 
       opStack += 2;
       break;
 
     // set a function-call arg (offset = param) to the value in opStack[0]
     case OP_ARG:
-      *(int32_t*)&dataSegment[(param + vm->opBase) & dataSegmentMask] = opStack[0];
+      *(int32_t*)&dataSegment[VM_ADDRESS(param + vm->opBase, dataSegmentMask)] = opStack[0];
       opStack++;
       break;
 
     // copy mem at address pointed to by opStack[0] to address pointed to by opStack[1]
     // for 'param' number of bytes
     case OP_BLOCK_COPY:
-    {
-      int32_t* from = (int32_t*)&dataSegment[opStack[0] & dataSegmentMask];
-      int32_t* to   = (int32_t*)&dataSegment[opStack[1] & dataSegmentMask];
-
-      if (param & 3)
-      {
-        trap_Error("[QMMVM] VM_Run: OP_BLOCK_COPY not dword aligned");
-      }
-
-      // FIXME: assume pointers don't overlap?
-      param >>= 2;
-      do
-      {
-        *to++ = *from++;
-      } while (--param);
-
+      VM_BlockCopy(vm, opStack[1], opStack[0], param);
       opStack += 2;
-    }
-    break;
+      break;
 
 //
 // arithmetic and logic
@@ -518,12 +549,26 @@ static void VM_Run(vm_t* vm)
     }
   } while ((int32_t)(intptr_t)opPointer);
   ASSERT_EQ(nbfunc, 0);
+#ifdef VM_SAMPLER
+  if (instrumented) *samplePc = NULL;
+#endif
 
   //  vm->opBase = opBase;
   vm->opStack = opStack;
+  if (instrumented && vm->countInstructions) vm->instructionsExecuted += instructions;
   //  vm->opPointer = opPointer;
 }
 
+// the loop is inlined twice so that only the harness, the tests and mdd_vm_sample pay for counting instructions and
+// publishing the pc
+static void VM_Run(vm_t* vm)
+{
+  if (vm->countInstructions || vm->samplePc)
+    VM_RunLoop(vm, qtrue);
+  else
+    VM_RunLoop(vm, qfalse);
+}
+
 // public function to begin the process of executing a VM
 //----
 // stuff args into the VM stack
@@ -581,7 +626,12 @@ intptr_t QDECL VM_Exec(
   vm->opPointer = vm->codeSegment;
 
   // GO!
-  VM_Run(vm);
+  if (vm->aot)
+    vm->opStack = vm->aot->call(vm, 0, vm->opStack);
+  else if (vm->cacheTos)
+    VM_RunTos(vm);
+  else
+    VM_Run(vm);
 
   // restore previous state
   vm->opPointer = vm->codeSegment + args[1];
@@ -596,7 +646,7 @@ intptr_t QDECL VM_Exec(
 crc32_buffer
 ==================
 */
-static uint32_t crc32_reflect(byte const* buf, int32_t len)
+uint32_t crc32_update(uint32_t crc, byte const* buf, int32_t len)
 {
   // clang-format off
   static uint32_t crc32_table[256] = {
@@ -635,11 +685,16 @@ static uint32_t crc32_reflect(byte const* buf, int32_t len)
   };
   // clang-format on
 
-  uint32_t crc = 0xFFFFFFFFUL;
+  crc ^= 0xFFFFFFFFUL;
   while (len--) crc = crc32_table[(crc ^ *buf++) & 0xFF] ^ (crc >> 8);
   return crc ^ 0xFFFFFFFFUL;
 }
 
+uint32_t crc32_reflect(byte const* buf, int32_t len)
+{
+  return crc32_update(0, buf, len);
+}
+
 static void VM_SwapLongs(void* data, size_t length)
 {
   int32_t* const ptr = (int32_t*)data;
@@ -652,28 +707,38 @@ static void VM_SwapLongs(void* data, size_t length)
 VM_ValidateHeader
 =================
 */
-static char const* VM_ValidateHeader(vmHeader_t* header, int32_t fileSize, qboolean* swapped)
+char const* VM_ValidateHeader(vmHeader_t* header, int32_t fileSize, qboolean* swapped)
 {
-  static char errMsg[128];
+  static VM_THREAD_LOCAL char errMsg[128];
 
   // truncated
-  if ((size_t)fileSize < sizeof(vmHeader_t))
+  if (fileSize < VM_HEADER_SIZE_VER1)
   {
     sprintf(errMsg, "truncated image header (%i bytes long)", fileSize);
     return errMsg;
   }
 
   // bad magic
-  if (header->vmMagic != VM_MAGIC && LongSwap(header->vmMagic) != VM_MAGIC)
+  int32_t const magic = header->vmMagic;
+  if (
+    magic != VM_MAGIC && LongSwap(magic) != VM_MAGIC && magic != VM_MAGIC_VER2 && LongSwap(magic) != VM_MAGIC_VER2)
   {
     sprintf(errMsg, "bad file magic %08x", header->vmMagic);
     return errMsg;
   }
 
-  if (header->vmMagic != VM_MAGIC)
+  int32_t const headerSize =
+    magic == VM_MAGIC_VER2 || LongSwap(magic) == VM_MAGIC_VER2 ? (int32_t)sizeof(vmHeader_t) : VM_HEADER_SIZE_VER1;
+  if (fileSize < headerSize)
+  {
+    sprintf(errMsg, "truncated image header (%i bytes long)", fileSize);
+    return errMsg;
+  }
+
+  if (magic != VM_MAGIC && magic != VM_MAGIC_VER2)
   {
     // byte swap the header
-    VM_SwapLongs(header, sizeof(vmHeader_t));
+    VM_SwapLongs(header, headerSize);
     *swapped = qtrue;
   }
 
@@ -685,7 +750,7 @@ static char const* VM_ValidateHeader(vmHeader_t* header, int32_t fileSize, qbool
   }
 
   // bad code offset
-  if (header->codeOffset >= fileSize)
+  if (header->codeOffset < headerSize || header->codeOffset >= fileSize)
   {
     sprintf(errMsg, "bad code segment offset %i", header->codeOffset);
     return errMsg;
@@ -712,8 +777,16 @@ static char const* VM_ValidateHeader(vmHeader_t* header, int32_t fileSize, qbool
     return errMsg;
   }
 
+  // bad jump table length
+  int32_t const jtrgLength = VM_JUMP_TABLE_LENGTH(header);
+  if (jtrgLength < 0 || (jtrgLength & 3) || header->dataOffset + header->dataLength + jtrgLength > fileSize)
+  {
+    sprintf(errMsg, "bad jump table length %i", jtrgLength);
+    return errMsg;
+  }
+
   // bad lit length
-  if (header->dataOffset + header->dataLength + header->litLength != fileSize)
+  if (header->dataOffset + header->dataLength + header->litLength + jtrgLength != fileSize)
   {
     sprintf(errMsg, "bad lit segment length %i", header->litLength);
     return errMsg;
@@ -722,20 +795,249 @@ static char const* VM_ValidateHeader(vmHeader_t* header, int32_t fileSize, qbool
   return NULL;
 }
 
+// size of the parameter following the opcode in the image
+int32_t VM_ParamSize(vmOps_t op)
+{
+  switch (op)
+  {
+  // these ops all have full 4-byte 'param's, which may need to be byteswapped
+  // remaining args are drawn from stack
+  case OP_ENTER:
+  case OP_LEAVE:
+  case OP_CONST:
+  case OP_LOCAL:
+  case OP_EQ:
+  case OP_NE:
+  case OP_LTI:
+  case OP_LEI:
+  case OP_GTI:
+  case OP_GEI:
+  case OP_LTU:
+  case OP_LEU:
+  case OP_GTU:
+  case OP_GEU:
+  case OP_EQF:
+  case OP_NEF:
+  case OP_LTF:
+  case OP_LEF:
+  case OP_GTF:
+  case OP_GEF:
+  case OP_BLOCK_COPY:
+    return 4;
+  // this op has only a single byte 'param' (draws 1 arg from stack)
+  case OP_ARG:
+    return 1;
+  // remaining ops require no 'param' (draw all, if any, args from stack)
+  default:
+    return 0;
+  }
+}
+
+int32_t VM_DecodeInstructions(
+  int32_t*    codeSegment,
+  int32_t     count,
+  byte const* src,
+  int32_t     len,
+  qboolean    swapped,
+  int32_t*    decoded)
+{
+  int32_t* dst = codeSegment;
+  int32_t  pos = 0;
+  int32_t  n   = 0;
+
+  // loop through each instruction that is complete
+  for (; n < count && pos < len; ++n)
+  {
+    vmOps_t const op   = (vmOps_t)src[pos];
+    int32_t const size = VM_ParamSize(op);
+    if (pos + 1 + size > len) break;
+
+    // write opcode (as int32_t) and its param
+    *dst++ = (int32_t)op;
+    if (size == 4)
+    {
+      int32_t param;
+      memcpy(&param, src + pos + 1, sizeof(param));
+      *dst++ = swapped ? LongSwap(param) : param;
+    }
+    else
+    {
+      *dst++ = size ? (int32_t)src[pos + 1] : 0;
+    }
+    pos += 1 + size;
+  }
+
+  *decoded = n;
+  return pos;
+}
+
+qboolean VM_LoadInstructions(int32_t* codeSegment, vmHeader_t const* header, qboolean swapped)
+{
+  int32_t decoded;
+  VM_DecodeInstructions(
+    codeSegment,
+    header->instructionCount,
+    (byte const*)header + header->codeOffset,
+    header->codeLength,
+    swapped,
+    &decoded);
+  return decoded == header->instructionCount;
+}
+
+#define VM_MARK_BLOCK(blocks, i, count)                                                                                \
+  if ((uint32_t)(i) < (uint32_t)(count)) (blocks)[(i) >> 5] |= 1u << ((i)&31)
+
+void VM_FindBlocks(
+  uint32_t*      blocks,
+  int32_t const* codeSegment,
+  int32_t        count,
+  int32_t const* jumpTargets,
+  int32_t        numJumpTargets)
+{
+  VM_MARK_BLOCK(blocks, 0, count);
+  for (int32_t i = 0; i < count; ++i)
+  {
+    int32_t const op    = codeSegment[2 * i];
+    int32_t const param = codeSegment[2 * i + 1];
+    switch (op)
+    {
+    case OP_ENTER: VM_MARK_BLOCK(blocks, i, count); break;
+    case OP_JUMP:
+      // a constant right before a jump is its target
+      if (i && codeSegment[2 * (i - 1)] == OP_CONST) VM_MARK_BLOCK(blocks, codeSegment[2 * (i - 1) + 1], count);
+      // fall through
+    case OP_CALL:
+    case OP_LEAVE: VM_MARK_BLOCK(blocks, i + 1, count); break;
+    default:
+      if (op >= OP_EQ && op <= OP_GEF)
+      {
+        VM_MARK_BLOCK(blocks, param, count);
+        VM_MARK_BLOCK(blocks, i + 1, count);
+      }
+      break;
+    }
+  }
+
+  for (int32_t i = 0; i < numJumpTargets; ++i) VM_MARK_BLOCK(blocks, jumpTargets[i], count);
+}
+
+#ifdef VM_GUARD_PAGES
+// every offset VM_ADDRESS can produce, and a guard page for the 2 and 4 byte accesses starting at the last ones
+#  define VM_RESERVE (((size_t)1 << 32) + (size_t)sysconf(_SC_PAGESIZE))
+
+static size_t VM_CodePages(int32_t codeSegmentSize)
+{
+  size_t const page = (size_t)sysconf(_SC_PAGESIZE);
+  return ((size_t)codeSegmentSize + page - 1) / page * page;
+}
+
+// the code segment ends at a page boundary, the data segment and the stack are fresh zero pages and the rest of the
+// reserve can't be accessed
+static byte* VM_AllocMemory(int32_t codeSegmentSize, int32_t memorySize)
+{
+  size_t const code = VM_CodePages(codeSegmentSize);
+  byte* const  base = mmap(NULL, code + VM_RESERVE, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+  if (base == MAP_FAILED) return NULL;
+  if (mprotect(base, code - codeSegmentSize + memorySize, PROT_READ | PROT_WRITE))
+  {
+    munmap(base, code + VM_RESERVE);
+    return NULL;
+  }
+  return base + code - codeSegmentSize;
+}
+
+static void VM_FreeMemory(vm_t* vm)
+{
+  if (!vm->memory) return;
+  int32_t const codeSegmentSize = vm->codeSegmentLen * sizeof(int32_t) * 2;
+  size_t const  code            = VM_CodePages(codeSegmentSize);
+  munmap(vm->memory - (code - codeSegmentSize), code + VM_RESERVE);
+}
+#else
+static byte* VM_AllocMemory(int32_t codeSegmentSize, int32_t memorySize)
+{
+  (void)codeSegmentSize;
+  return calloc(1, memorySize);
+}
+
+static void VM_FreeMemory(vm_t* vm)
+{
+  free(vm->memory);
+}
+#endif
+
+static void draw2d_hook(vmHookContext_t* ctx)
+{
+  (void)ctx;
+  quality_measure_begin();
+  perf_enter(PERF_PROXY);
+  span_call("draw_hud", draw_hud);
+  perf_leave();
+  quality_measure_end();
+}
+
+#define VM_READ_CHUNK 65536
+
+typedef struct
+{
+  fileHandle_t f;
+  int32_t      offset; // bytes read so far
+  uint32_t     crc32sum;
+} vmStream_t;
+
+// reads the next len bytes of the file to dst and checksums them
+static void VM_StreamRead(vmStream_t* stream, void* dst, int32_t len)
+{
+  trap_FS_Read(dst, len, stream->f);
+  stream->crc32sum = crc32_update(stream->crc32sum, (byte const*)dst, len);
+  stream->offset += len;
+}
+
+// decodes the code segment chunk by chunk, an instruction split between two chunks is carried over to the next one
+static qboolean VM_StreamCode(vm_t* vm, vmStream_t* stream, vmHeader_t const* header, qboolean swapped)
+{
+  byte* const chunk = malloc(VM_READ_CHUNK + 4); // + the start of an instruction
+  if (!chunk) return qfalse;
+
+  // skip to the code
+  while (stream->offset < header->codeOffset)
+  {
+    int32_t const left = header->codeOffset - stream->offset;
+    VM_StreamRead(stream, chunk, left < VM_READ_CHUNK ? left : VM_READ_CHUNK);
+  }
+
+  int32_t decoded = 0;
+  int32_t carry   = 0;
+  for (int32_t left = header->codeLength; left > 0;)
+  {
+    int32_t const len = left < VM_READ_CHUNK ? left : VM_READ_CHUNK;
+    VM_StreamRead(stream, chunk + carry, len);
+    left -= len;
+
+    int32_t       n;
+    int32_t const used = VM_DecodeInstructions(
+      vm->codeSegment + 2 * decoded, header->instructionCount - decoded, chunk, carry + len, swapped, &n);
+    decoded += n;
+    // anything after the last instruction is only checksummed
+    carry = decoded < header->instructionCount ? carry + len - used : 0;
+    memmove(chunk, chunk + used, carry);
+  }
+  free(chunk);
+  return decoded == header->instructionCount;
+}
+
 // load the .qvm into the vm_t
 //---
-// this function opens the .qvm in a file stream, stores in dynamic mem
-// reads header info, and loads vm into memory
+// this function streams the .qvm in chunks: the header is validated first, then the instructions are decoded and
+// the data is read straight into the vm's memory while the file is checksummed for the defrag version
 //----
 // vm = pointer to vm_t to load into
 // path = filename to load
 // oldmem = location to use for VM memory (default NULL)
-qboolean VM_Create(vm_t* vm, char const* path, byte* oldmem)
+// crc32sum = checksum of the whole file
+qboolean VM_Load(vm_t* vm, char const* path, byte* oldmem, uint32_t* crc32sum)
 {
-  vmHeader_t*  header;
-  byte const*  src;
-  int32_t*     dst;
-  vmOps_t      op;
+  vmHeader_t   header;
   int32_t      codeSegmentSize;
   fileHandle_t fvm;
 
@@ -743,46 +1045,34 @@ qboolean VM_Create(vm_t* vm, char const* path, byte* oldmem)
 
   // open VM file (use engine calls so we can easily read into .pk3)
   int32_t const fileSize = trap_FS_FOpenFile(path, &fvm, FS_READ);
-  // allocate memory block the size of the file
-  header = (vmHeader_t*)malloc(fileSize);
-  if (!header)
+  vmStream_t    stream   = { fvm, 0, 0 };
+  if (fileSize >= VM_HEADER_SIZE_VER1) VM_StreamRead(&stream, &header, VM_HEADER_SIZE_VER1);
+  if (
+    fileSize >= (int32_t)sizeof(header) &&
+    (header.vmMagic == VM_MAGIC_VER2 || LongSwap(header.vmMagic) == VM_MAGIC_VER2))
   {
-    memset(vm, 0, sizeof(vm_t));
-    trap_FS_FCloseFile(fvm);
-    return qfalse;
+    VM_StreamRead(&stream, &header.jtrgLength, sizeof(header.jtrgLength));
   }
 
-  // read VM file into memory block
-  trap_FS_Read(header, fileSize, fvm);
-  trap_FS_FCloseFile(fvm);
-
   qboolean    swapped  = qfalse;
-  char const* errorMsg = VM_ValidateHeader(header, fileSize, &swapped);
+  char const* errorMsg = VM_ValidateHeader(&header, fileSize, &swapped);
   if (errorMsg)
   {
-    free(header);
+    trap_FS_FCloseFile(fvm);
     memset(vm, 0, sizeof(vm_t));
     trap_Print(vaf(S_COLOR_RED "%s\n", errorMsg));
     return qfalse;
   }
 
-  // check defrag version
-  uint32_t const crc32sum = crc32_reflect((byte const*)header, fileSize);
-  if (!init_defrag(crc32sum))
-  {
-    free(header);
-    memset(vm, 0, sizeof(vm_t));
-    return qfalse;
-  }
-
   // setup segments
-  vm->codeSegmentLen = header->instructionCount;
-  vm->dataSegmentLen = header->dataLength + header->litLength + header->bssLength;
+  vm->codeSegmentLen  = header.instructionCount;
+  vm->dataSegmentLen  = header.dataLength + header.litLength + header.bssLength;
+  vm->stackSegmentLen = vm_stacksize;
 
   // calculate memory protection mask (including the stack?)
   for (vm->dataSegmentMask = 1;; vm->dataSegmentMask <<= 1)
   {
-    if (vm->dataSegmentMask > vm->dataSegmentLen + vm_stacksize)
+    if (vm->dataSegmentMask > vm->dataSegmentLen + vm->stackSegmentLen)
     {
       vm->dataSegmentMask--;
       break;
@@ -792,19 +1082,17 @@ qboolean VM_Create(vm_t* vm, char const* path, byte* oldmem)
   // each opcode is 2 ints long, calculate total size of opcodes
   codeSegmentSize = vm->codeSegmentLen * sizeof(int32_t) * 2;
 
-  vm->memorySize = codeSegmentSize + vm->dataSegmentLen + vm_stacksize;
+  vm->memorySize = codeSegmentSize + vm->dataSegmentLen + vm->stackSegmentLen;
   // load memory code block (freed in VM_Destroy)
-  // if we are reloading, we should keep the same memory location, otherwise, make more
-  vm->memory = oldmem ? oldmem : (byte*)malloc(vm->memorySize);
+  // if we are reloading, we should keep the same memory location, otherwise, make more (zeroed)
+  vm->memory = oldmem ? oldmem : VM_AllocMemory(codeSegmentSize, vm->memorySize);
   if (!vm->memory)
   {
     // RS_Printf("Unable to allocate VM memory chunk (size=%i)\n", vm->memorySize);
-    free(header);
+    trap_FS_FCloseFile(fvm);
     memset(vm, 0, sizeof(vm_t));
     return qfalse;
   }
-  // clear the memory
-  memset(vm->memory, 0, vm->memorySize);
 
   // set pointers
   vm->codeSegment  = (int32_t*)vm->memory;
@@ -813,77 +1101,79 @@ qboolean VM_Create(vm_t* vm, char const* path, byte* oldmem)
 
   // setup registers
   vm->opPointer = NULL;
-  vm->opStack   = (int32_t*)(vm->stackSegment + vm_stacksize);
-  vm->opBase    = vm->dataSegmentLen + vm_stacksize / 2;
+  vm->opStack   = (int32_t*)(vm->stackSegment + vm->stackSegmentLen);
+  vm->opBase    = vm->dataSegmentLen + vm->stackSegmentLen / 2;
 
   // load instructions from file to memory
-  src = (byte const*)header + header->codeOffset;
-  dst = vm->codeSegment;
+  if (!VM_StreamCode(vm, &stream, &header, swapped))
+  {
+    trap_FS_FCloseFile(fvm);
+    trap_Print(S_COLOR_RED "truncated code segment\n");
+    VM_Destroy(vm);
+    return qfalse;
+  }
 
-  // loop through each instruction
-  for (int32_t n = 0; n < header->instructionCount; ++n)
+  // load the intialized data from file to memory, only the rest needs to be cleared
+  for (int32_t offset = 0; offset < header.dataLength + header.litLength; offset += VM_READ_CHUNK)
   {
-    // get its opcode and move src to the parameter field
-    op = (vmOps_t)*src++;
-    // write opcode (as int32_t) and move dst to next int32_t
-    *dst++ = (int32_t)op;
+    int32_t const left = header.dataLength + header.litLength - offset;
+    VM_StreamRead(&stream, vm->dataSegment + offset, left < VM_READ_CHUNK ? left : VM_READ_CHUNK);
+  }
 
-    switch (op)
+  // keep the jump table (freed in VM_Destroy)
+  if (header.vmMagic == VM_MAGIC_VER2)
+  {
+    vm->numJumpTargets = header.jtrgLength / sizeof(int32_t);
+    vm->jumpTargets    = malloc(header.jtrgLength ? header.jtrgLength : 1);
+    if (!vm->jumpTargets)
     {
-    // these ops all have full 4-byte 'param's, which may need to be byteswapped
-    // remaining args are drawn from stack
-    case OP_ENTER:
-    case OP_LEAVE:
-    case OP_CONST:
-    case OP_LOCAL:
-    case OP_EQ:
-    case OP_NE:
-    case OP_LTI:
-    case OP_LEI:
-    case OP_GTI:
-    case OP_GEI:
-    case OP_LTU:
-    case OP_LEU:
-    case OP_GTU:
-    case OP_GEU:
-    case OP_EQF:
-    case OP_NEF:
-    case OP_LTF:
-    case OP_LEF:
-    case OP_GTF:
-    case OP_GEF:
-    case OP_BLOCK_COPY:
-      *dst = *(int32_t*)src;
-      if (swapped) *dst = LongSwap(*dst);
-      dst++;
-      src += 4;
-      break;
-    // this op has only a single byte 'param' (draws 1 arg from stack)
-    case OP_ARG:
-      *dst++ = (int32_t)*src++;
-      break;
-    // remaining ops require no 'param' (draw all, if any, args from stack)
-    default:
-      *dst++ = 0;
-      break;
+      trap_FS_FCloseFile(fvm);
+      VM_Destroy(vm);
+      return qfalse;
     }
+    VM_StreamRead(&stream, vm->jumpTargets, header.jtrgLength);
+    if (swapped) VM_SwapLongs(vm->jumpTargets, header.jtrgLength);
+  }
+  trap_FS_FCloseFile(fvm);
+  if (oldmem)
+  {
+    memset(vm->dataSegment + header.dataLength + header.litLength, 0, header.bssLength + vm->stackSegmentLen);
   }
-
-  // load data segment from file to memory
-  src = (byte const*)header + header->dataOffset;
-  dst = (int32_t*)vm->dataSegment;
-
-  // copy the intialized data
-  memcpy(dst, src, header->dataLength + header->litLength);
 
   if (swapped)
   {
     // byte swap the longs
-    VM_SwapLongs(dst, header->dataLength);
+    VM_SwapLongs(vm->dataSegment, header.dataLength);
   }
 
-  // free file from memory
-  free(header);
+  *crc32sum = stream.crc32sum;
+  return qtrue;
+}
+
+qboolean VM_Create(vm_t* vm, char const* path, byte* oldmem)
+{
+  uint32_t crc32sum;
+  if (!VM_Load(vm, path, oldmem, &crc32sum)) return qfalse;
+
+  // check defrag version
+  if (!init_defrag(crc32sum))
+  {
+    VM_Destroy(vm);
+    return qfalse;
+  }
+
+  init_vm_hooks(vm);
+  vm->aot      = find_vm_aot(crc32sum);
+  vm->cacheTos = vm_tos_enabled();
+  if (!vm->hookFlags)
+  {
+    VM_Destroy(vm);
+    return qfalse;
+  }
+
+  // the hud is drawn right before defrag's own 2d drawing
+  add_vm_hook(vm, defrag()->cg_draw2d_defrag, draw2d_hook);
+  add_vm_hook(vm, defrag()->cg_draw2d_vanilla, draw2d_hook);
 
   return qtrue;
 }
@@ -891,7 +1181,9 @@ qboolean VM_Create(vm_t* vm, char const* path, byte* oldmem)
 // frees used memory and clears vm_t
 void VM_Destroy(vm_t* vm)
 {
-  if (vm->memory) free(vm->memory);
+  VM_FreeMemory(vm);
+  free_vm_hooks(vm);
+  free(vm->jumpTargets);
   memset(vm, 0, sizeof(vm_t));
 }
 
@@ -916,7 +1208,9 @@ qboolean VM_Restart(vm_t* vm, qboolean savemem)
   if (savemem == qtrue)
     oldmem = vm->memory;
   else
-    free(vm->memory);
+    VM_FreeMemory(vm);
+  free_vm_hooks(vm);
+  free(vm->jumpTargets);
 
   // kill it!
   memset(vm, 0, sizeof(vm_t));
@@ -931,16 +1225,40 @@ qboolean VM_Restart(vm_t* vm, qboolean savemem)
   return qtrue;
 }
 
-void* VM_ArgPtr(int32_t intValue)
+void VM_BlockCopy(vm_t* vm, int32_t to, int32_t from, int32_t n)
+{
+  uint32_t const size = (uint32_t)(vm->dataSegmentLen + vm->stackSegmentLen);
+
+  if (n & 3)
+  {
+    trap_Error("[QMMVM] VM_Run: OP_BLOCK_COPY not dword aligned");
+    return;
+  }
+  if (
+    (uint32_t)to > size || (uint32_t)from > size || (uint32_t)n > size - (uint32_t)to ||
+    (uint32_t)n > size - (uint32_t)from)
+  {
+    trap_Error(vaf("[QMMVM] VM_Run: OP_BLOCK_COPY of %i bytes from %i to %i out of range", n, from, to));
+    return;
+  }
+
+  // forwards an int at a time, like the loop the bytecode would run
+  int32_t*       dst = (int32_t*)(vm->dataSegment + (uint32_t)to);
+  int32_t const* src = (int32_t const*)(vm->dataSegment + (uint32_t)from);
+  for (n >>= 2; n; --n) *dst++ = *src++;
+}
+
+void* VM_ArgPtr(vm_t const* vm, int32_t intValue)
 {
-  ASSERT_LT(intValue, g_VM.dataSegmentMask);
-  return (void*)(g_VM.dataSegment + (intValue & g_VM.dataSegmentMask));
+  ASSERT_LT(intValue, vm->dataSegmentMask);
+  return (void*)(vm->dataSegment + (intValue & vm->dataSegmentMask));
 }
 
-vm_t    g_VM;
-char    vmpath[MAX_QPATH];
-char    vmbase[16];
-int32_t vm_stacksize = 0;
+vm_t     g_VM;
+char     vmpath[MAX_QPATH];
+char     vmbase[16];
+int32_t  vm_stacksize          = 0;
+qboolean vm_count_instructions = qfalse;
 
 /*
 ==========
@@ -965,6 +1283,7 @@ int32_t initVM(void)
     trap_Error(vaf("FATAL ERROR: Unable to load VM \"%s\"\n", vmpath));
     return qfalse;
   }
+  g_VM.countInstructions = vm_count_instructions;
   strncpy(vmbase, vaf("%u", g_VM.dataSegment), sizeof(vmbase) - 1);
   vmbase[sizeof(vmbase) - 1] = '\0';
 
@@ -1002,11 +1321,14 @@ intptr_t callVM(
   int32_t arg10,
   int32_t arg11)
 {
-  if (g_VM.memory)
-  {
-    return VM_Exec(&g_VM, cmd, arg0, arg1, arg2, arg3, arg4, arg5, arg6, arg7, arg8, arg9, arg10, arg11);
-  }
-  return 0; // dunno if this is OK
+  if (!g_VM.memory) return 0; // dunno if this is OK
+
+  span_t const span = span_begin("VM_Run");
+  perf_enter(PERF_QVM);
+  intptr_t const ret = VM_Exec(&g_VM, cmd, arg0, arg1, arg2, arg3, arg4, arg5, arg6, arg7, arg8, arg9, arg10, arg11);
+  perf_leave();
+  span_end(span);
+  return ret;
 }
 
 /*
@@ -1016,6 +1338,7 @@ callVM_Destroy
 */
 intptr_t callVM_Destroy(void)
 {
+  stop_vm_sampler();
   VM_Destroy(&g_VM);
   return 0;
 }
@@ -36,7 +36,7 @@ defrag_t defrag_versions[] = {
     0x00002A09, // cg_draw2d_defrag (0x000029E5)
     0x0001CD2C, // cg_draw2d_vanilla (0x0001CCF1)
   },
-  // 1.91.28 requires VM_MAGIC_VER2 support
+  // 1.91.28 is a VM_MAGIC_VER2 qvm, which loads now, but its offsets are yet to be located (qvmtool locate)
   {
     "1.91.29",  // name
     0xE5F9882A, // crc32sum
@@ -60,14 +60,19 @@ defrag_t defrag_versions[] = {
   },
 };
 
-qboolean init_defrag(uint32_t crc32sum)
+defrag_t const* find_defrag(uint32_t crc32sum)
 {
   for (size_t i = 0, n = ARRAY_LEN(defrag_versions); i < n; ++i)
   {
-    defrag_version = &defrag_versions[i];
-    if (defrag_version->crc32sum == crc32sum) return qtrue;
+    if (defrag_versions[i].crc32sum == crc32sum) return &defrag_versions[i];
   }
-  defrag_version = NULL;
+  return NULL;
+}
+
+qboolean init_defrag(uint32_t crc32sum)
+{
+  defrag_version = find_defrag(crc32sum);
+  if (defrag_version) return qtrue;
 
   // Report error about unsupported defrag version
   static_assert(ARRAY_LEN(defrag_versions) > 0, "");
@@ -17,6 +17,9 @@ typedef struct
 
 qboolean init_defrag(uint32_t crc32sum);
 
+// The supported version with this checksum, NULL if there is none.
+defrag_t const* find_defrag(uint32_t crc32sum);
+
 defrag_t const* defrag(void);
 
 #endif // DEFRAG_H
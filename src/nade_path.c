@@ -0,0 +1,105 @@
+#include "nade_path.h"
+
+#include "bg_public.h"
+#include "cg_local.h"
+#include "q_assert.h"
+
+#define NADE_PATH_MAX_SPAN 32  // longest step, in nb of steps
+#define NADE_PATH_MARGIN   .25f // > SURFACE_CLIP_EPSILON
+
+void trace_nade_path(
+  trajectory_t const*      pos,
+  int32_t                  end_time,
+  int32_t                  step,
+  int32_t                  sample,
+  nadePathVisitor_t const* visitor)
+{
+  trace_t trace;
+  vec3_t  currentOrigin, origin;
+
+  ASSERT_GT(step, 0);
+  ASSERT_EQ(sample % step, 0);
+
+  trajectory_t local_pos = *pos;
+  VectorCopy(local_pos.trBase, currentOrigin);
+
+  int32_t time        = local_pos.trTime;
+  int32_t next_sample = time + step;
+  int32_t span        = step;
+  int32_t calm        = 0; // nb of consecutive steps without contact
+  while (time + step < end_time)
+  {
+    // never go past the last step of the fixed step integration
+    while (span > step && time + span >= end_time) span /= 2;
+    int32_t const leveltime = time + span;
+    BG_EvaluateTrajectory(&local_pos, leveltime, origin);
+
+    if (span > step)
+    {
+      // The path only bends downwards, so all chords of the fixed steps in this span lie on or above the chord of
+      // the span, and at most g*T^2/8 higher. Sweeping a box of that height along the chord covers all of them.
+      float const  t    = span * .001f;
+      float const  sag  = .125f * DEFAULT_GRAVITY * t * t;
+      vec3_t const mins = { -NADE_PATH_MARGIN, -NADE_PATH_MARGIN, -NADE_PATH_MARGIN };
+      vec3_t const maxs = { NADE_PATH_MARGIN, NADE_PATH_MARGIN, sag + NADE_PATH_MARGIN };
+      trap_CM_BoxTrace(&trace, currentOrigin, origin, mins, maxs, 0, MASK_SHOT);
+      if (trace.fraction != 1 || trace.startsolid)
+      {
+        // bisect until the contact is resolved by a single step
+        span /= 2;
+        calm = 0;
+        continue;
+      }
+
+      VectorCopy(origin, currentOrigin);
+      for (; next_sample <= leveltime; next_sample += sample)
+      {
+        vec3_t sample_origin;
+        BG_EvaluateTrajectory(&local_pos, next_sample, sample_origin);
+        visitor->sample(visitor->data, next_sample, sample_origin);
+      }
+      time = leveltime;
+      if (span < NADE_PATH_MAX_SPAN * step) span *= 2;
+      continue;
+    }
+
+    trap_CM_BoxTrace(&trace, currentOrigin, origin, NULL, NULL, 0, MASK_SHOT);
+    VectorCopy(trace.endpos, currentOrigin);
+
+    if (next_sample <= leveltime)
+    {
+      ASSERT_EQ(next_sample, leveltime);
+      visitor->sample(visitor->data, leveltime, origin);
+      next_sample = leveltime + sample;
+    }
+
+    time = leveltime;
+    if (trace.fraction == 1)
+    {
+      // only grow again once clear of the surface
+      if (++calm >= 2) span *= 2;
+      continue;
+    }
+
+    // G_BounceMissile
+    vec3_t velocity;
+    float  dot;
+    int    hitTime;
+
+    // reflect the velocity on the trace plane
+    hitTime = (leveltime - step) + (int)(step * trace.fraction);
+    BG_EvaluateTrajectoryDelta(&local_pos, hitTime, velocity);
+    dot = DotProduct(velocity, trace.plane.normal);
+    VectorMA(velocity, -2 * dot, trace.plane.normal, local_pos.trDelta);
+
+    VectorScale(local_pos.trDelta, .65f, local_pos.trDelta);
+
+    VectorAdd(currentOrigin, trace.plane.normal, currentOrigin);
+    VectorCopy(currentOrigin, local_pos.trBase);
+    local_pos.trTime = leveltime;
+
+    next_sample = leveltime + step;
+    calm        = 0;
+    visitor->bounce(visitor->data, &local_pos);
+  }
+}
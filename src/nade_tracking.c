@@ -0,0 +1,45 @@
+#include "nade_tracking.h"
+
+#include "cg_entity.h"
+#include "cg_utils.h"
+#include "q_assert.h"
+
+// indexed by entity number, so there is no limit on the number of tracked nades
+static int32_t explode_times[MAX_GENTITIES];
+
+static void on_entity_event(entityEvent_t const* event)
+{
+  entityState_t const* const entity = event->state;
+  switch (event->type)
+  {
+  case ENTITY_SPAWNED:
+    if (
+      entity->eType == ET_MISSILE && entity->weapon == WP_GRENADE_LAUNCHER &&
+      entity->clientNum == getSnap()->ps.clientNum)
+    {
+      explode_times[entity->number] = event->serverTime + NADE_EXPLODE_TIME;
+    }
+    break;
+  case ENTITY_CHANGED:
+    // a nade which explodes turns into an event entity before it's freed
+    if (entity->eType != ET_MISSILE) explode_times[entity->number] = 0;
+    break;
+  case ENTITY_REMOVED:
+    // not in snapshot anymore (prolly prematurely detonated)
+    explode_times[entity->number] = 0;
+    break;
+  }
+}
+
+void init_nade_tracking(void)
+{
+  memset(explode_times, 0, sizeof(explode_times));
+  subscribe_entityEvents(on_entity_event);
+}
+
+int32_t nade_explode_time(int32_t number)
+{
+  ASSERT_GE(number, 0);
+  ASSERT_LT(number, MAX_GENTITIES);
+  return explode_times[number];
+}
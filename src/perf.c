@@ -0,0 +1,271 @@
+#include "perf.h"
+
+#include "cg_cvar.h"
+#include "cg_draw.h"
+#include "cg_local.h"
+#include "cg_syscall.h"
+#include "profile.h"
+#include "timing.h"
+
+#include <stdarg.h>
+
+#define PERF_FRAMES 128 // power of 2
+#define PERF_DEPTH  16
+
+// Window of the last PERF_FRAMES values with O(1) average and amortized O(1) min/max (monotonic queues of indices).
+typedef struct
+{
+  float    values[PERF_FRAMES];
+  double   sum;
+  uint32_t count;
+
+  uint32_t minQueue[PERF_FRAMES];
+  uint32_t minHead, minTail;
+  uint32_t maxQueue[PERF_FRAMES];
+  uint32_t maxHead, maxTail;
+} rolling_t;
+
+static vmCvar_t perf;
+static vmCvar_t perf_xywh;
+static vmCvar_t perf_text_h;
+
+static cvarTable_t perf_cvars[] = {
+  { &perf, "mdd_perf", "0", CVAR_ARCHIVE_ND },
+  { &perf_xywh, "mdd_perf_xywh", "4 300 128 48", CVAR_ARCHIVE_ND },
+  { &perf_text_h, "mdd_perf_text_h", "8", CVAR_ARCHIVE_ND },
+};
+
+static vec4_t const perf_colors[PERF_CATEGORIES] = {
+  { 0, 1, 0, .75f },    // proxy
+  { 1, 1, 0, .75f },    // qvm
+  { 1, .25f, 0, .75f }, // syscalls
+};
+
+static char const* const category_names[PERF_CATEGORIES] = { "proxy", "qvm", "syscalls" };
+static char const* const module_names[PERF_MODULES]      = { "cgaz", "snap", "gl", "rl", "timer", "other" };
+
+static intptr_t(QDECL* next_syscall)(intptr_t, ...);
+
+typedef struct
+{
+  qboolean       active;
+  uint64_t       last;
+  perfCategory_t stack[PERF_DEPTH];
+  int32_t        depth;
+  uint64_t       frameStart;
+  uint64_t       categories[PERF_CATEGORIES];
+  uint64_t       modules[PERF_MODULES];
+
+  rolling_t frame;
+  rolling_t categoryMs[PERF_CATEGORIES];
+  rolling_t moduleMs[PERF_MODULES];
+
+  vec4_t xywh;
+} perf_state_t;
+
+static perf_state_t s;
+
+static void rolling_push(rolling_t* r, float value)
+{
+  uint32_t const i = r->count;
+
+  if (i >= PERF_FRAMES) r->sum -= r->values[i % PERF_FRAMES];
+  r->values[i % PERF_FRAMES] = value;
+  r->sum += value;
+
+  // drop indices that left the window, then the ones the new value dominates
+  while (r->minHead != r->minTail && r->minQueue[r->minHead % PERF_FRAMES] + PERF_FRAMES <= i) ++r->minHead;
+  while (r->minHead != r->minTail && r->values[r->minQueue[(r->minTail - 1) % PERF_FRAMES] % PERF_FRAMES] >= value)
+  {
+    --r->minTail;
+  }
+  r->minQueue[r->minTail++ % PERF_FRAMES] = i;
+
+  while (r->maxHead != r->maxTail && r->maxQueue[r->maxHead % PERF_FRAMES] + PERF_FRAMES <= i) ++r->maxHead;
+  while (r->maxHead != r->maxTail && r->values[r->maxQueue[(r->maxTail - 1) % PERF_FRAMES] % PERF_FRAMES] <= value)
+  {
+    --r->maxTail;
+  }
+  r->maxQueue[r->maxTail++ % PERF_FRAMES] = i;
+
+  ++r->count;
+}
+
+static inline uint32_t rolling_size(rolling_t const* r)
+{
+  return r->count < PERF_FRAMES ? r->count : PERF_FRAMES;
+}
+
+static inline float rolling_avg(rolling_t const* r)
+{
+  return r->count ? (float)(r->sum / rolling_size(r)) : 0.f;
+}
+
+static inline float rolling_min(rolling_t const* r)
+{
+  return r->count ? r->values[r->minQueue[r->minHead % PERF_FRAMES] % PERF_FRAMES] : 0.f;
+}
+
+static inline float rolling_max(rolling_t const* r)
+{
+  return r->count ? r->values[r->maxQueue[r->maxHead % PERF_FRAMES] % PERF_FRAMES] : 0.f;
+}
+
+// i = 0 is the oldest value in the window
+static inline float rolling_at(rolling_t const* r, uint32_t i)
+{
+  return r->values[(r->count - rolling_size(r) + i) % PERF_FRAMES];
+}
+
+void init_perf(void)
+{
+  init_cvars(perf_cvars, ARRAY_LEN(perf_cvars));
+
+  memset(&s, 0, sizeof(s));
+}
+
+void update_perf(void)
+{
+  update_cvars(perf_cvars, ARRAY_LEN(perf_cvars));
+}
+
+static void account(void)
+{
+  uint64_t const now = time_ns();
+  s.categories[s.stack[s.depth]] += now - s.last;
+  s.last = now;
+}
+
+void perf_frame_begin(void)
+{
+  s.active = perf.integer ? qtrue : qfalse;
+  measure_syscalls(s.active);
+  if (!s.active) return;
+
+  memset(s.categories, 0, sizeof(s.categories));
+  memset(s.modules, 0, sizeof(s.modules));
+  s.depth      = 0;
+  s.stack[0]   = PERF_PROXY;
+  s.frameStart = time_ns();
+  s.last       = s.frameStart;
+}
+
+void perf_frame_end(void)
+{
+  if (!s.active) return;
+  account();
+  s.active = qfalse;
+
+  rolling_push(&s.frame, (float)(s.last - s.frameStart) / 1e6f);
+  for (int32_t i = 0; i < PERF_CATEGORIES; ++i) rolling_push(&s.categoryMs[i], (float)s.categories[i] / 1e6f);
+  for (int32_t i = 0; i < PERF_MODULES; ++i) rolling_push(&s.moduleMs[i], (float)s.modules[i] / 1e6f);
+}
+
+void perf_enter(perfCategory_t category)
+{
+  if (!s.active || s.depth == PERF_DEPTH - 1) return;
+  account();
+  s.stack[++s.depth] = category;
+}
+
+void perf_leave(void)
+{
+  if (!s.active || !s.depth) return;
+  account();
+  --s.depth;
+}
+
+void perf_call(perfModule_t module, char const* name, void (*draw)(void))
+{
+  span_t const   span  = span_begin(name);
+  uint64_t const start = s.active ? time_ns() : 0;
+  draw();
+  if (s.active) s.modules[module] += time_ns() - start;
+  span_end(span);
+}
+
+void perf_chain(intptr_t(QDECL* next)(intptr_t, ...))
+{
+  next_syscall = next;
+}
+
+intptr_t QDECL perf_syscall(intptr_t cmd, ...)
+{
+  intptr_t args[SYSCALL_ARGS];
+  va_list  ap;
+  va_start(ap, cmd);
+  read_syscall_args(ap, args);
+  va_end(ap);
+
+  perf_enter(PERF_SYSCALLS);
+  intptr_t const ret = forward_syscall(next_syscall, cmd, args);
+  perf_leave();
+  return ret;
+}
+
+void draw_perf(void)
+{
+  if (!perf.integer || !s.frame.count) return;
+
+  ParseVec(perf_xywh.string, s.xywh, 4);
+  float const x = s.xywh[0];
+  float const y = s.xywh[1];
+  float const w = s.xywh[2];
+  float const h = s.xywh[3];
+
+  // stacked bars, scaled to the worst frame in the window
+  float const    scale = h / (rolling_max(&s.frame) > 0 ? rolling_max(&s.frame) : 1.f);
+  uint32_t const size  = rolling_size(&s.frame);
+  float const    bar_w = w / PERF_FRAMES;
+  for (uint32_t i = 0; i < size; ++i)
+  {
+    float bottom = y + h;
+    for (int32_t c = PERF_CATEGORIES - 1; c >= 0; --c)
+    {
+      float const bar_h = rolling_at(&s.categoryMs[c], i) * scale;
+      if (bar_h <= 0) continue;
+      bottom -= bar_h;
+      CG_FillRect(x + (PERF_FRAMES - size + i) * bar_w, bottom, bar_w, bar_h, perf_colors[c]);
+    }
+  }
+
+  vec4_t const white  = { 1, 1, 1, 1 };
+  float const  text_h = perf_text_h.value;
+  float        text_y = y + h + 2;
+  CG_DrawText(x, text_y, text_h, "ms        avg  min  max", white, qfalse, qtrue /*shadow*/);
+  text_y += text_h;
+  CG_DrawText(
+    x,
+    text_y,
+    text_h,
+    vaf("frame    %.2f %.2f %.2f", rolling_avg(&s.frame), rolling_min(&s.frame), rolling_max(&s.frame)),
+    white,
+    qfalse,
+    qtrue /*shadow*/);
+  for (int32_t i = 0; i < PERF_CATEGORIES; ++i)
+  {
+    rolling_t const* const r = &s.categoryMs[i];
+    text_y += text_h;
+    CG_DrawText(
+      x,
+      text_y,
+      text_h,
+      vaf("%-8s %.2f %.2f %.2f", category_names[i], rolling_avg(r), rolling_min(r), rolling_max(r)),
+      perf_colors[i],
+      qfalse,
+      qtrue /*shadow*/);
+  }
+  for (int32_t i = 0; i < PERF_MODULES; ++i)
+  {
+    rolling_t const* const r = &s.moduleMs[i];
+    text_y += text_h;
+    CG_DrawText(
+      x,
+      text_y,
+      text_h,
+      vaf("%-8s %.2f %.2f %.2f", module_names[i], rolling_avg(r), rolling_min(r), rolling_max(r)),
+      white,
+      qfalse,
+      qtrue /*shadow*/);
+  }
+}
@@ -0,0 +1,50 @@
+#ifndef PERF_H
+#define PERF_H
+
+#include "q_shared.h"
+
+#include <stdint.h>
+
+// mdd_perf: rolling graph of the frame time split into proxy, qvm and syscalls, plus the cost of the hud modules.
+typedef enum
+{
+  PERF_PROXY,
+  PERF_QVM,
+  PERF_SYSCALLS,
+  PERF_CATEGORIES
+} perfCategory_t;
+
+typedef enum
+{
+  PERF_CGAZ,
+  PERF_SNAP,
+  PERF_GL,
+  PERF_RL,
+  PERF_TIMER,
+  PERF_OTHER,
+  PERF_MODULES
+} perfModule_t;
+
+void init_perf(void);
+
+void update_perf(void);
+
+void draw_perf(void);
+
+void perf_frame_begin(void);
+
+void perf_frame_end(void);
+
+// Time is attributed to the innermost category entered, outside of these it's proxy time.
+void perf_enter(perfCategory_t category);
+
+void perf_leave(void);
+
+// Draws a hud module, spanned for the profiler and its cost added to module.
+void perf_call(perfModule_t module, char const* name, void (*draw)(void));
+
+void perf_chain(intptr_t(QDECL* next)(intptr_t, ...));
+
+intptr_t QDECL perf_syscall(intptr_t cmd, ...);
+
+#endif // PERF_H
@@ -0,0 +1,203 @@
+#include "profile.h"
+
+#include "cg_cvar.h"
+#include "cg_local.h"
+#include "cg_syscall.h"
+#include "timing.h"
+
+#include <stdarg.h>
+#include <stdlib.h>
+
+#define MAX_SPANS  32768 // power of 2
+#define MAX_FRAMES 1024  // power of 2
+#define SPAN_NONE  UINT32_MAX
+#define SPAN_OPEN  UINT32_MAX
+
+typedef struct
+{
+  char const* name;
+  uint64_t    begin;
+  uint32_t    ns; // SPAN_OPEN until span_end
+} spanEvent_t;
+
+static vmCvar_t profile;
+
+static cvarTable_t profile_cvars[] = {
+  { &profile, "mdd_profile", "0", CVAR_ARCHIVE_ND },
+};
+
+static intptr_t(QDECL* next_syscall)(intptr_t, ...);
+
+static qboolean    profiling;
+static spanEvent_t spans[MAX_SPANS];
+static span_t      spanCount;
+static span_t      frames[MAX_FRAMES]; // first span of each frame
+static uint32_t    frameCount;
+
+void init_profile(void)
+{
+  init_cvars(profile_cvars, ARRAY_LEN(profile_cvars));
+}
+
+void update_profile(void)
+{
+  update_cvars(profile_cvars, ARRAY_LEN(profile_cvars));
+}
+
+void profile_frame(void)
+{
+  profiling = profile.integer ? qtrue : qfalse;
+  profile_syscalls(profiling);
+  if (!profiling) return;
+
+  frames[frameCount++ & (MAX_FRAMES - 1)] = spanCount;
+}
+
+span_t span_begin(char const* name)
+{
+  if (!profiling) return SPAN_NONE;
+
+  spanEvent_t* const e = &spans[spanCount & (MAX_SPANS - 1)];
+  e->name              = name;
+  e->ns                = SPAN_OPEN;
+  e->begin             = time_ns();
+  return spanCount++;
+}
+
+void span_end(span_t span)
+{
+  if (span == SPAN_NONE) return;
+
+  uint64_t const end = time_ns();
+  if (spanCount - span > MAX_SPANS) return; // overwritten meanwhile
+
+  spanEvent_t* const e = &spans[span & (MAX_SPANS - 1)];
+  e->ns                = (uint32_t)(end - e->begin < SPAN_OPEN ? end - e->begin : SPAN_OPEN - 1);
+}
+
+void span_call(char const* name, void (*function)(void))
+{
+  span_t const span = span_begin(name);
+  function();
+  span_end(span);
+}
+
+void profile_chain(intptr_t(QDECL* next)(intptr_t, ...))
+{
+  next_syscall = next;
+}
+
+static qboolean expensive(intptr_t cmd)
+{
+  switch (cmd)
+  {
+  case CG_FS_READ:
+  case CG_CM_BOXTRACE:
+  case CG_CM_TRANSFORMEDBOXTRACE:
+  case CG_CM_CAPSULETRACE:
+  case CG_CM_TRANSFORMEDCAPSULETRACE:
+  case CG_CM_MARKFRAGMENTS:
+  case CG_CM_POINTCONTENTS:
+  case CG_CM_TRANSFORMEDPOINTCONTENTS:
+  case CG_R_RENDERSCENE:
+  case CG_R_REGISTERMODEL:
+  case CG_R_REGISTERSHADER:
+  case CG_R_REGISTERSHADERNOMIP:
+  case CG_S_REGISTERSOUND:
+  case CG_GETGAMESTATE:
+  case CG_GETSNAPSHOT:
+    return qtrue;
+  default:
+    return qfalse;
+  }
+}
+
+intptr_t QDECL profile_syscall(intptr_t cmd, ...)
+{
+  intptr_t args[SYSCALL_ARGS];
+  va_list  ap;
+  va_start(ap, cmd);
+  read_syscall_args(ap, args);
+  va_end(ap);
+
+  span_t const   span = expensive(cmd) ? span_begin(syscall_name(cmd)) : SPAN_NONE;
+  intptr_t const ret  = forward_syscall(next_syscall, cmd, args);
+  span_end(span);
+  return ret;
+}
+
+typedef struct
+{
+  fileHandle_t f;
+  int32_t      used;
+  char         buffer[4096];
+} jsonWriter_t;
+
+static void write_json(jsonWriter_t* w, char const* s)
+{
+  int32_t const len = (int32_t)strlen(s);
+  if (w->used + len > (int32_t)sizeof(w->buffer))
+  {
+    trap_FS_Write(w->buffer, w->used, w->f);
+    w->used = 0;
+  }
+  memcpy(w->buffer + w->used, s, len);
+  w->used += len;
+}
+
+void dump_profile(void)
+{
+  char arg[MAX_QPATH];
+
+  uint32_t n = 60;
+  if (trap_Argc() > 1)
+  {
+    trap_Argv(1, arg, sizeof(arg));
+    n = (uint32_t)atoi(arg);
+  }
+  char path[MAX_QPATH] = "profile.json";
+  if (trap_Argc() > 2) trap_Argv(2, path, sizeof(path));
+
+  if (n > frameCount) n = frameCount;
+  if (n > MAX_FRAMES) n = MAX_FRAMES;
+  if (!n)
+  {
+    trap_Print("usage: mdd_profile_dump [frames] [file], with mdd_profile 1\n");
+    return;
+  }
+
+  // the spans of the frames that are still in the ring buffer
+  span_t const end   = spanCount;
+  span_t       begin = frames[(frameCount - n) & (MAX_FRAMES - 1)];
+  if (end - begin > MAX_SPANS) begin = end - MAX_SPANS;
+
+  static jsonWriter_t w;
+  w.used = 0;
+  trap_FS_FOpenFile(path, &w.f, FS_WRITE);
+  if (!w.f)
+  {
+    trap_Print(vaf("could not open %s\n", path));
+    return;
+  }
+
+  uint64_t const t0    = spans[begin & (MAX_SPANS - 1)].begin;
+  char const*    comma = "";
+  write_json(&w, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+  for (span_t i = begin; i != end; ++i)
+  {
+    spanEvent_t const* const e = &spans[i & (MAX_SPANS - 1)];
+    if (e->ns == SPAN_OPEN) continue;
+    write_json(
+      &w,
+      vaf("%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":%.3f,\"dur\":%.3f}",
+          comma,
+          e->name,
+          (double)(e->begin - t0) / 1e3,
+          (double)e->ns / 1e3));
+    comma = ",\n";
+  }
+  write_json(&w, "\n]}\n");
+  trap_FS_Write(w.buffer, w.used, w.f);
+  trap_FS_FCloseFile(w.f);
+  trap_Print(vaf("wrote %u frames (%u spans) to %s\n", n, end - begin, path));
+}
@@ -0,0 +1,34 @@
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include "q_shared.h"
+
+#include <stdint.h>
+
+// Timeline of the last frames with mdd_profile 1, dumped by mdd_profile_dump as Chrome/Perfetto trace-event JSON.
+// Spans are stored in a preallocated ring buffer, nothing is recorded when profiling is off.
+typedef uint32_t span_t;
+
+void init_profile(void);
+
+void update_profile(void);
+
+// Marks the start of a frame and enables or disables profiling for it.
+void profile_frame(void);
+
+// name must outlive the dump, i.e. be a string literal.
+span_t span_begin(char const* name);
+
+void span_end(span_t span);
+
+void span_call(char const* name, void (*function)(void));
+
+void profile_chain(intptr_t(QDECL* next)(intptr_t, ...));
+
+// Spans the expensive syscalls (traces, snapshots, rendering, file reads).
+intptr_t QDECL profile_syscall(intptr_t cmd, ...);
+
+// mdd_profile_dump [frames] [file]
+void dump_profile(void);
+
+#endif // PROFILE_H
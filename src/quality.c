@@ -0,0 +1,154 @@
+#include "quality.h"
+
+#include "cg_cvar.h"
+#include "cg_draw.h"
+#include "cg_local.h"
+#include "cg_utils.h"
+#include "help.h"
+#include "timing.h"
+
+static vmCvar_t quality_budget;
+static vmCvar_t quality_max;
+static vmCvar_t quality_draw;
+static vmCvar_t quality_text_xyh;
+static vmCvar_t quality_text_rgba;
+
+static cvarTable_t quality_cvars[] = {
+  { &quality_budget, "mdd_quality_budget", "0", CVAR_ARCHIVE_ND },
+  { &quality_max, "mdd_quality_max", "3", CVAR_ARCHIVE_ND },
+  { &quality_draw, "mdd_quality_draw", "0", CVAR_ARCHIVE_ND },
+  { &quality_text_xyh, "mdd_quality_text_xyh", "4 464 8", CVAR_ARCHIVE_ND },
+  { &quality_text_rgba, "mdd_quality_text_rgba", "1 1 1 1", CVAR_ARCHIVE_ND },
+};
+
+static help_t quality_help[] = {
+  {
+    quality_cvars + 3,
+    X | Y | H,
+    {
+      "mdd_quality_text_xyh X X X",
+    },
+  },
+  {
+    quality_cvars + 4,
+    RGBA,
+    {
+      "mdd_quality_text_rgba X X X X",
+    },
+  },
+};
+
+// Ordered from full to lowest quality.
+static quality_t const quality_levels[] = {
+  { 8, 32, 4, 128 },
+  { 8, 64, 3, 64 },
+  { 16, 64, 2, 32 },
+  { 32, 128, 1, 16 },
+};
+
+// Nb of frames to wait after a level change before decreasing or increasing the quality again.
+#define QUALITY_DECREASE_HOLD 15
+#define QUALITY_INCREASE_HOLD 120
+
+typedef struct
+{
+  uint64_t start;
+  uint64_t frame_ns;
+
+  float   avg_ms; // exponential moving average of the measured cost per frame
+  int32_t level;
+  int32_t hold;
+
+  vec3_t text_xyh;
+  vec4_t text_rgba;
+} quality_state_t;
+
+static quality_state_t s;
+
+void init_quality(void)
+{
+  init_cvars(quality_cvars, ARRAY_LEN(quality_cvars));
+  init_help(quality_help, ARRAY_LEN(quality_help));
+
+  memset(&s, 0, sizeof(s));
+}
+
+void update_quality(void)
+{
+  update_cvars(quality_cvars, ARRAY_LEN(quality_cvars));
+
+  // Called once per frame, so this closes the measurement of the previous frame.
+  float const cost_ms = (float)s.frame_ns / 1e6f;
+  s.frame_ns          = 0;
+  s.avg_ms += (cost_ms - s.avg_ms) * .1f;
+
+  int32_t max_level = quality_max.integer;
+  if (max_level < 0) max_level = 0;
+  if (max_level > (int32_t)ARRAY_LEN(quality_levels) - 1) max_level = (int32_t)ARRAY_LEN(quality_levels) - 1;
+  if (quality_budget.value <= 0)
+  {
+    s.level = 0;
+    s.hold  = 0;
+    return;
+  }
+
+  ++s.hold;
+  if (s.avg_ms > quality_budget.value && s.level < max_level && s.hold >= QUALITY_DECREASE_HOLD)
+  {
+    ++s.level;
+    s.hold = 0;
+  }
+  else if (s.avg_ms < .5f * quality_budget.value && s.level > 0 && s.hold >= QUALITY_INCREASE_HOLD)
+  {
+    --s.level;
+    s.hold = 0;
+  }
+  if (s.level > max_level) s.level = max_level;
+}
+
+void draw_quality(void)
+{
+  if (!quality_draw.integer) return;
+
+  ParseVec(quality_text_xyh.string, s.text_xyh, 3);
+  ParseVec(quality_text_rgba.string, s.text_rgba, 4);
+
+  CG_DrawText(
+    s.text_xyh[0],
+    s.text_xyh[1],
+    s.text_xyh[2],
+    vaf("quality %i (%.2f/%.2fms)", s.level, s.avg_ms, quality_budget.value),
+    s.text_rgba,
+    qfalse,
+    qtrue /*shadow*/);
+}
+
+void quality_measure_begin(void)
+{
+  s.start = time_ns();
+}
+
+void quality_measure_end(void)
+{
+  quality_measure(time_ns() - s.start);
+}
+
+void quality_measure(uint64_t ns)
+{
+  s.frame_ns += ns;
+}
+
+quality_t const* quality(void)
+{
+  return &quality_levels[s.level];
+}
+
+int32_t quality_level_count(void)
+{
+  return (int32_t)ARRAY_LEN(quality_levels);
+}
+
+quality_t const* quality_level(int32_t level)
+{
+  return &quality_levels[level];
+}
@@ -0,0 +1,35 @@
+#ifndef QUALITY_H
+#define QUALITY_H
+
+#include <stdint.h>
+
+typedef struct
+{
+  int32_t gl_path_step;   // ms between two traces of a grenade path
+  int32_t gl_path_sample; // ms between two drawn segments of a grenade path
+  int32_t snap_layers;    // max nb of Snap-HUD layers drawn
+  int32_t mark_fragments; // max nb of fragments of a rocket mark
+} quality_t;
+
+void init_quality(void);
+
+void update_quality(void);
+
+void draw_quality(void);
+
+// Everything between begin and end counts towards the frame budget.
+void quality_measure_begin(void);
+
+void quality_measure_end(void);
+
+// Adds ns to the cost of the current frame, quality_measure_end adds the time since quality_measure_begin.
+void quality_measure(uint64_t ns);
+
+quality_t const* quality(void);
+
+// The levels the budget picks from, 0 being full quality.
+int32_t quality_level_count(void);
+
+quality_t const* quality_level(int32_t level);
+
+#endif // QUALITY_H
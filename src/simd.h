@@ -0,0 +1,295 @@
+#ifndef SIMD_H
+#define SIMD_H
+
+// SIMD_WIDTH floats at a time: AVX2 when compiled for it, else SSE2 on x86 and NEON on ARM, one at a time with
+// SIMD_NONE or on anything else. Configure with -DSIMD=AVX2, NEON (which 32-bit ARM needs a flag for) or NONE.
+// Loads and stores are unaligned.
+#if defined(SIMD_NONE)
+#elif defined(__AVX2__)
+#  define SIMD_AVX2
+#  include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#  define SIMD_SSE2
+#  include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#  define SIMD_NEON
+#  include <arm_neon.h>
+#endif
+
+#include <math.h>
+
+#if defined(SIMD_AVX2)
+#  define SIMD_WIDTH 8
+typedef __m256 vf_t;
+
+static inline vf_t vf_set1(float a)
+{
+  return _mm256_set1_ps(a);
+}
+
+static inline vf_t vf_load(float const* p)
+{
+  return _mm256_loadu_ps(p);
+}
+
+static inline void vf_store(float* p, vf_t a)
+{
+  _mm256_storeu_ps(p, a);
+}
+
+static inline vf_t vf_add(vf_t a, vf_t b)
+{
+  return _mm256_add_ps(a, b);
+}
+
+static inline vf_t vf_sub(vf_t a, vf_t b)
+{
+  return _mm256_sub_ps(a, b);
+}
+
+static inline vf_t vf_mul(vf_t a, vf_t b)
+{
+  return _mm256_mul_ps(a, b);
+}
+
+static inline vf_t vf_div(vf_t a, vf_t b)
+{
+  return _mm256_div_ps(a, b);
+}
+
+static inline vf_t vf_min(vf_t a, vf_t b)
+{
+  return _mm256_min_ps(a, b);
+}
+
+static inline vf_t vf_max(vf_t a, vf_t b)
+{
+  return _mm256_max_ps(a, b);
+}
+
+static inline vf_t vf_sqrt(vf_t a)
+{
+  return _mm256_sqrt_ps(a);
+}
+#elif defined(SIMD_SSE2)
+#  define SIMD_WIDTH 4
+typedef __m128 vf_t;
+
+static inline vf_t vf_set1(float a)
+{
+  return _mm_set1_ps(a);
+}
+
+static inline vf_t vf_load(float const* p)
+{
+  return _mm_loadu_ps(p);
+}
+
+static inline void vf_store(float* p, vf_t a)
+{
+  _mm_storeu_ps(p, a);
+}
+
+static inline vf_t vf_add(vf_t a, vf_t b)
+{
+  return _mm_add_ps(a, b);
+}
+
+static inline vf_t vf_sub(vf_t a, vf_t b)
+{
+  return _mm_sub_ps(a, b);
+}
+
+static inline vf_t vf_mul(vf_t a, vf_t b)
+{
+  return _mm_mul_ps(a, b);
+}
+
+static inline vf_t vf_div(vf_t a, vf_t b)
+{
+  return _mm_div_ps(a, b);
+}
+
+static inline vf_t vf_min(vf_t a, vf_t b)
+{
+  return _mm_min_ps(a, b);
+}
+
+static inline vf_t vf_max(vf_t a, vf_t b)
+{
+  return _mm_max_ps(a, b);
+}
+
+static inline vf_t vf_sqrt(vf_t a)
+{
+  return _mm_sqrt_ps(a);
+}
+#elif defined(SIMD_NEON)
+#  define SIMD_WIDTH 4
+typedef float32x4_t vf_t;
+
+static inline vf_t vf_set1(float a)
+{
+  return vdupq_n_f32(a);
+}
+
+static inline vf_t vf_load(float const* p)
+{
+  return vld1q_f32(p);
+}
+
+static inline void vf_store(float* p, vf_t a)
+{
+  vst1q_f32(p, a);
+}
+
+static inline vf_t vf_add(vf_t a, vf_t b)
+{
+  return vaddq_f32(a, b);
+}
+
+static inline vf_t vf_sub(vf_t a, vf_t b)
+{
+  return vsubq_f32(a, b);
+}
+
+static inline vf_t vf_mul(vf_t a, vf_t b)
+{
+  return vmulq_f32(a, b);
+}
+
+static inline vf_t vf_min(vf_t a, vf_t b)
+{
+  return vminq_f32(a, b);
+}
+
+static inline vf_t vf_max(vf_t a, vf_t b)
+{
+  return vmaxq_f32(a, b);
+}
+#  if defined(__aarch64__)
+static inline vf_t vf_div(vf_t a, vf_t b)
+{
+  return vdivq_f32(a, b);
+}
+
+static inline vf_t vf_sqrt(vf_t a)
+{
+  return vsqrtq_f32(a);
+}
+#  else
+// ARMv7 only has estimates, refined by 2 Newton-Raphson steps each.
+static inline vf_t vf_div(vf_t a, vf_t b)
+{
+  float32x4_t r = vrecpeq_f32(b);
+  r             = vmulq_f32(r, vrecpsq_f32(b, r));
+  r             = vmulq_f32(r, vrecpsq_f32(b, r));
+  return vmulq_f32(a, r);
+}
+
+static inline vf_t vf_sqrt(vf_t a)
+{
+  float32x4_t r = vrsqrteq_f32(a);
+  r             = vmulq_f32(r, vrsqrtsq_f32(vmulq_f32(a, r), r));
+  r             = vmulq_f32(r, vrsqrtsq_f32(vmulq_f32(a, r), r));
+  return vbslq_f32(vceqq_f32(a, vdupq_n_f32(0)), a, vmulq_f32(a, r)); // 1 / sqrt(0) is infinite
+}
+#  endif
+#else
+#  define SIMD_WIDTH 1
+typedef float vf_t;
+
+static inline vf_t vf_set1(float a)
+{
+  return a;
+}
+
+static inline vf_t vf_load(float const* p)
+{
+  return *p;
+}
+
+static inline void vf_store(float* p, vf_t a)
+{
+  *p = a;
+}
+
+static inline vf_t vf_add(vf_t a, vf_t b)
+{
+  return a + b;
+}
+
+static inline vf_t vf_sub(vf_t a, vf_t b)
+{
+  return a - b;
+}
+
+static inline vf_t vf_mul(vf_t a, vf_t b)
+{
+  return a * b;
+}
+
+static inline vf_t vf_div(vf_t a, vf_t b)
+{
+  return a / b;
+}
+
+static inline vf_t vf_min(vf_t a, vf_t b)
+{
+  return fminf(a, b);
+}
+
+static inline vf_t vf_max(vf_t a, vf_t b)
+{
+  return fmaxf(a, b);
+}
+
+static inline vf_t vf_sqrt(vf_t a)
+{
+  return sqrtf(a);
+}
+#endif
+
+// n rounded up to a whole nb of vectors
+#define SIMD_ROUND_UP(n) (((n) + SIMD_WIDTH - 1) / SIMD_WIDTH * SIMD_WIDTH)
+
+// base, base + 1, ..., base + SIMD_WIDTH - 1
+static inline vf_t vf_iota(float base)
+{
+  static float const iota[8] = { 0, 1, 2, 3, 4, 5, 6, 7 };
+  return vf_add(vf_set1(base), vf_load(iota));
+}
+
+static inline float vf_hmin(vf_t a)
+{
+  float lanes[SIMD_WIDTH];
+  vf_store(lanes, a);
+  float m = lanes[0];
+  for (int i = 1; i < SIMD_WIDTH; ++i) m = lanes[i] < m ? lanes[i] : m;
+  return m;
+}
+
+static inline float vf_hmax(vf_t a)
+{
+  float lanes[SIMD_WIDTH];
+  vf_store(lanes, a);
+  float m = lanes[0];
+  for (int i = 1; i < SIMD_WIDTH; ++i) m = lanes[i] > m ? lanes[i] : m;
+  return m;
+}
+
+// acos of x in [0, 1], within 2e-8 before rounding to float (Abramowitz and Stegun 4.4.46).
+static inline vf_t vf_acos(vf_t x)
+{
+  vf_t p = vf_set1(-.0012624911f);
+  p      = vf_add(vf_mul(p, x), vf_set1(.0066700901f));
+  p      = vf_add(vf_mul(p, x), vf_set1(-.0170881256f));
+  p      = vf_add(vf_mul(p, x), vf_set1(.0308918810f));
+  p      = vf_add(vf_mul(p, x), vf_set1(-.0501743046f));
+  p      = vf_add(vf_mul(p, x), vf_set1(.0889789874f));
+  p      = vf_add(vf_mul(p, x), vf_set1(-.2145988016f));
+  p      = vf_add(vf_mul(p, x), vf_set1(1.5707963050f));
+  return vf_mul(vf_sqrt(vf_sub(vf_set1(1), x)), p);
+}
+
+#endif // SIMD_H
@@ -0,0 +1,267 @@
+#include "syscall_log.h"
+
+#include "cg_local.h"
+#include "cg_syscall.h"
+
+#include <stdarg.h>
+#include <stddef.h>
+
+#define SYSCALL_LOG_BUFFER 65536
+
+static intptr_t(QDECL* engine_syscall)(intptr_t, ...);
+static intptr_t(QDECL* next_syscall)(intptr_t, ...);
+
+static fileHandle_t log_file;
+static byte         log_buffer[SYSCALL_LOG_BUFFER];
+static int32_t      log_used;
+
+static void flush(void)
+{
+  if (log_used) engine_syscall(CG_FS_WRITE, log_buffer, log_used, log_file);
+  log_used = 0;
+}
+
+static void put(void const* data, int32_t len)
+{
+  if (log_used + len > SYSCALL_LOG_BUFFER) flush();
+  if (len > SYSCALL_LOG_BUFFER)
+  {
+    engine_syscall(CG_FS_WRITE, data, len, log_file);
+    return;
+  }
+  memcpy(log_buffer + log_used, data, len);
+  log_used += len;
+}
+
+static void put_u8(uint8_t x)
+{
+  put(&x, 1);
+}
+
+static void put_u32(uint32_t x)
+{
+  uint8_t const b[4] = { (uint8_t)x, (uint8_t)(x >> 8), (uint8_t)(x >> 16), (uint8_t)(x >> 24) };
+  put(b, sizeof(b));
+}
+
+static void put_varint(uint64_t x)
+{
+  uint8_t b[10];
+  int32_t n = 0;
+  for (; x >= 0x80; x >>= 7) b[n++] = (uint8_t)(x | 0x80);
+  b[n++] = (uint8_t)x;
+  put(b, n);
+}
+
+static void put_svarint(int64_t x)
+{
+  put_varint(((uint64_t)x << 1) ^ (uint64_t)(x >> 63));
+}
+
+int32_t syscall_outputs(intptr_t cmd, intptr_t const* args, intptr_t ret, syscallOutput_t* outputs)
+{
+#define OUTPUT_UPTO(ptr, length, bufsize)                                                                              \
+  (outputs[n].data = (void*)(ptr), outputs[n].len = (int32_t)(length), outputs[n].size = (int32_t)(bufsize), ++n)
+#define OUTPUT(ptr, size) OUTPUT_UPTO(ptr, size, size)
+  int32_t n = 0;
+  switch (cmd)
+  {
+  case CG_CVAR_REGISTER:
+  case CG_CVAR_UPDATE:
+    if (args[0]) OUTPUT(args[0], sizeof(vmCvar_t));
+    break;
+
+  case CG_CVAR_VARIABLESTRINGBUFFER:
+  case CG_ARGV:
+    OUTPUT(args[1], args[2]);
+    break;
+
+  case CG_ARGS:
+  case CG_GET_ENTITY_TOKEN:
+    OUTPUT(args[0], args[1]);
+    break;
+
+  case CG_FS_FOPENFILE:
+    if (args[1]) OUTPUT(args[1], sizeof(fileHandle_t));
+    break;
+
+  case CG_FS_READ:
+    OUTPUT(args[0], args[1]);
+    break;
+
+  case CG_CM_BOXTRACE:
+  case CG_CM_CAPSULETRACE:
+  case CG_CM_TRANSFORMEDBOXTRACE:
+  case CG_CM_TRANSFORMEDCAPSULETRACE:
+    OUTPUT(args[0], sizeof(trace_t));
+    break;
+
+  case CG_CM_MARKFRAGMENTS:
+  {
+    // only the fragments returned and the points they use
+    markFragment_t const* fragments = (markFragment_t const*)args[6];
+    int32_t const         returned  = (int32_t)(ret < args[5] ? ret : args[5]);
+    int32_t               points    = 0;
+    for (int32_t i = 0; i < returned; ++i)
+    {
+      if (fragments[i].firstPoint + fragments[i].numPoints > points)
+      {
+        points = fragments[i].firstPoint + fragments[i].numPoints;
+      }
+    }
+    OUTPUT_UPTO(args[6], returned * sizeof(markFragment_t), args[5] * sizeof(markFragment_t));
+    OUTPUT_UPTO(args[4], points * sizeof(vec3_t), args[3] * sizeof(vec3_t));
+    break;
+  }
+
+  case CG_R_REGISTERFONT:
+    OUTPUT(args[2], sizeof(fontInfo_t));
+    break;
+
+  case CG_R_LIGHTFORPOINT:
+    OUTPUT(args[1], sizeof(vec3_t));
+    OUTPUT(args[2], sizeof(vec3_t));
+    OUTPUT(args[3], sizeof(vec3_t));
+    break;
+
+  case CG_R_MODELBOUNDS:
+    OUTPUT(args[1], sizeof(vec3_t));
+    OUTPUT(args[2], sizeof(vec3_t));
+    break;
+
+  case CG_R_LERPTAG:
+    OUTPUT(args[0], 4 * sizeof(vec3_t)); // orientation_t
+    break;
+
+  case CG_GETGLCONFIG:
+    OUTPUT(args[0], sizeof(glconfig_t));
+    break;
+
+  case CG_GETGAMESTATE:
+    OUTPUT(args[0], sizeof(gameState_t));
+    break;
+
+  case CG_GETCURRENTSNAPSHOTNUMBER:
+    OUTPUT(args[0], sizeof(int32_t));
+    OUTPUT(args[1], sizeof(int32_t));
+    break;
+
+  case CG_GETSNAPSHOT:
+    if (ret)
+    {
+      // only the entities in the snapshot
+      snapshot_t const* snap = (snapshot_t const*)args[1];
+      OUTPUT_UPTO(
+        snap,
+        offsetof(snapshot_t, entities) + snap->numEntities * sizeof(entityState_t),
+        offsetof(snapshot_t, numServerCommands));
+      OUTPUT(&snap->numServerCommands, sizeof(*snap) - offsetof(snapshot_t, numServerCommands));
+    }
+    break;
+
+  case CG_GETUSERCMD:
+    OUTPUT(args[1], sizeof(usercmd_t));
+    break;
+
+  case CG_PC_READ_TOKEN:
+    OUTPUT(args[1], sizeof(pc_token_t));
+    break;
+
+  case CG_PC_SOURCE_FILE_AND_LINE:
+    OUTPUT(args[1], 128);
+    OUTPUT(args[2], sizeof(int32_t));
+    break;
+
+  case CG_REAL_TIME:
+    OUTPUT(args[0], sizeof(qtime_t));
+    break;
+
+  case CG_SNAPVECTOR:
+    OUTPUT(args[0], sizeof(vec3_t));
+    break;
+  }
+  return n;
+#undef OUTPUT
+#undef OUTPUT_UPTO
+}
+
+qboolean syscall_log_start(intptr_t(QDECL* engine)(intptr_t, ...))
+{
+  char path[MAX_QPATH];
+
+  // still recording when CG_INIT comes again without a CG_SHUTDOWN in between
+  if (log_file) return qtrue;
+
+  engine_syscall = engine;
+  next_syscall   = engine;
+  engine_syscall(CG_CVAR_VARIABLESTRINGBUFFER, SYSCALL_LOG_CVAR, path, sizeof(path));
+  if (!path[0]) return qfalse;
+
+  log_used = 0;
+  engine_syscall(CG_FS_FOPENFILE, path, &log_file, FS_APPEND);
+  if (!log_file)
+  {
+    engine_syscall(CG_PRINT, vaf("^3Warning: could not open %s for recording\n", path));
+    return qfalse;
+  }
+
+  put_u32(SYSCALL_LOG_MAGIC);
+  put_u32(SYSCALL_LOG_VERSION);
+  return qtrue;
+}
+
+void syscall_log_stop(void)
+{
+  if (!log_file) return;
+  flush();
+  engine_syscall(CG_FS_FCLOSEFILE, log_file);
+  log_file = 0;
+}
+
+void syscall_log_chain(intptr_t(QDECL* next)(intptr_t, ...))
+{
+  next_syscall = next;
+}
+
+void syscall_log_call(int32_t cmd, int32_t arg0, int32_t arg1, int32_t arg2)
+{
+  if (!log_file) return;
+  put_u8(SYSCALL_LOG_CALL);
+  put_svarint(cmd);
+  put_svarint(arg0);
+  put_svarint(arg1);
+  put_svarint(arg2);
+}
+
+intptr_t QDECL syscall_log_record(intptr_t cmd, ...)
+{
+  intptr_t args[SYSCALL_ARGS];
+  va_list  ap;
+  va_start(ap, cmd);
+  read_syscall_args(ap, args);
+  va_end(ap);
+
+  if (cmd == CG_ERROR && log_file)
+  {
+    // doesn't return
+    put_u8((uint8_t)cmd);
+    put_svarint(0);
+    put_u8(0);
+    syscall_log_stop();
+  }
+
+  intptr_t const ret = forward_syscall(next_syscall, cmd, args);
+  if (!log_file) return ret;
+
+  syscallOutput_t outputs[MAX_SYSCALL_OUTPUTS];
+  int32_t const   n = syscall_outputs(cmd, args, ret, outputs);
+  put_u8((uint8_t)cmd);
+  put_svarint(ret);
+  put_u8((uint8_t)n);
+  for (int32_t i = 0; i < n; ++i)
+  {
+    put_varint((uint32_t)outputs[i].len);
+    put(outputs[i].data, outputs[i].len);
+  }
+  return ret;
+}
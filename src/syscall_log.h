@@ -0,0 +1,49 @@
+#ifndef SYSCALL_LOG_H
+#define SYSCALL_LOG_H
+
+#include "q_shared.h"
+
+#include <stdint.h>
+
+// Records every engine syscall (from the proxy and from the qvm through CG_SysCalls) together with its return value
+// and the buffers the engine wrote to, so the harness can replay a session bit-exactly without an engine.
+//
+// Recording starts on CG_INIT when the cvar names a file (e.g. +set mdd_record rec/run.mddrec) and stops on
+// CG_SHUTDOWN. Every session (map load, vid_restart, ...) is appended to the file with its own header, so delete it
+// to start over. The cvar lookup itself is not part of the log.
+//
+// Layout, little-endian, varint = LEB128, svarint = zigzag varint:
+//   header:  u32 SYSCALL_LOG_MAGIC, u32 SYSCALL_LOG_VERSION
+//   call:    u8 SYSCALL_LOG_CALL, svarint cmd, svarint arg0, svarint arg1, svarint arg2   (vmMain from the engine)
+//   syscall: u8 cmd, svarint return value, u8 n, n * (varint len, len bytes)          (in syscall_outputs order)
+#define SYSCALL_LOG_CVAR    "mdd_record"
+#define SYSCALL_LOG_MAGIC   0x5244444d // "MDDR"
+#define SYSCALL_LOG_VERSION 2 // 2: the qvm is read in chunks
+#define SYSCALL_LOG_CALL    0xff
+
+#define MAX_SYSCALL_OUTPUTS 3
+
+typedef struct
+{
+  void*   data;
+  int32_t len;
+  int32_t size; // of the buffer, len is at most that
+} syscallOutput_t;
+
+// Fills outputs with the buffers the engine wrote to when handling cmd, returns how many. The lengths may depend on
+// what the engine wrote (e.g. numEntities of a snapshot), so a replay takes them from the log instead and only
+// relies on the sizes, which depend on the arguments alone.
+int32_t syscall_outputs(intptr_t cmd, intptr_t const* args, intptr_t ret, syscallOutput_t* outputs);
+
+qboolean syscall_log_start(intptr_t(QDECL* engine)(intptr_t, ...));
+
+void syscall_log_stop(void);
+
+// Where recorded syscalls are forwarded to, the engine unless something else is chained in between.
+void syscall_log_chain(intptr_t(QDECL* next)(intptr_t, ...));
+
+void syscall_log_call(int32_t cmd, int32_t arg0, int32_t arg1, int32_t arg2);
+
+intptr_t QDECL syscall_log_record(intptr_t cmd, ...);
+
+#endif // SYSCALL_LOG_H
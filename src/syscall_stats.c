@@ -0,0 +1,149 @@
+#include "syscall_stats.h"
+
+#include "cg_cvar.h"
+#include "cg_local.h"
+#include "cg_syscall.h"
+#include "timing.h"
+
+#include <stdarg.h>
+
+#define MAX_SYSCALLS      128
+#define HISTOGRAM_BUCKETS 32 // bucket i counts calls that took [2^i, 2^(i+1)) ns
+
+typedef struct
+{
+  uint32_t calls;
+  uint32_t vmCalls;
+  uint64_t ns;
+  uint64_t maxNs;
+  uint32_t histogram[HISTOGRAM_BUCKETS];
+} syscallStats_t;
+
+static vmCvar_t syscall_stats_sample;
+
+static cvarTable_t syscall_stats_cvars[] = {
+  { &syscall_stats_sample, "mdd_syscall_stats_sample", "0", CVAR_ARCHIVE_ND },
+};
+
+static intptr_t(QDECL* next_syscall)(intptr_t, ...);
+
+static syscallStats_t stats[MAX_SYSCALLS];
+static uint32_t       frames;
+static uint32_t       sampledFrames;
+
+void init_syscall_stats(void)
+{
+  init_cvars(syscall_stats_cvars, ARRAY_LEN(syscall_stats_cvars));
+}
+
+void update_syscall_stats(void)
+{
+  update_cvars(syscall_stats_cvars, ARRAY_LEN(syscall_stats_cvars));
+}
+
+void sample_syscall_stats(void)
+{
+  qboolean const sample = syscall_stats_sample.integer > 0 && frames++ % syscall_stats_sample.integer == 0;
+  if (sample) ++sampledFrames;
+  sample_syscalls(sample);
+}
+
+void syscall_stats_vm(int32_t cmd)
+{
+  if (cmd >= 0 && cmd < MAX_SYSCALLS) ++stats[cmd].vmCalls;
+}
+
+void syscall_stats_chain(intptr_t(QDECL* next)(intptr_t, ...))
+{
+  next_syscall = next;
+}
+
+static inline uint8_t bucket(uint64_t ns)
+{
+  uint8_t i = 0;
+  while (ns >>= 1) ++i;
+  return i < HISTOGRAM_BUCKETS ? i : HISTOGRAM_BUCKETS - 1;
+}
+
+intptr_t QDECL syscall_stats_record(intptr_t cmd, ...)
+{
+  intptr_t args[SYSCALL_ARGS];
+  va_list  ap;
+  va_start(ap, cmd);
+  read_syscall_args(ap, args);
+  va_end(ap);
+
+  uint64_t const start = time_ns();
+  intptr_t const ret   = forward_syscall(next_syscall, cmd, args);
+  uint64_t const ns = time_ns() - start;
+
+  if (cmd >= 0 && cmd < MAX_SYSCALLS)
+  {
+    syscallStats_t* const s = &stats[cmd];
+    ++s->calls;
+    s->ns += ns;
+    if (ns > s->maxNs) s->maxNs = ns;
+    ++s->histogram[bucket(ns)];
+  }
+  return ret;
+}
+
+static char const* duration(uint64_t ns)
+{
+  if (ns < 1000) return vaf("%uns", (uint32_t)ns);
+  if (ns < 1000000) return vaf("%uus", (uint32_t)(ns / 1000));
+  return vaf("%ums", (uint32_t)(ns / 1000000));
+}
+
+void print_syscall_stats(void)
+{
+  if (!sampledFrames)
+  {
+    trap_Print("no frames sampled, see mdd_syscall_stats_sample\n");
+    return;
+  }
+
+  // copy, so the prints below don't show up in the statistics
+  static syscallStats_t sorted[MAX_SYSCALLS];
+  int32_t               cmds[MAX_SYSCALLS];
+  int32_t               n       = 0;
+  uint32_t const        sampled = sampledFrames;
+  memcpy(sorted, stats, sizeof(stats));
+  memset(stats, 0, sizeof(stats));
+  sampledFrames = 0;
+
+  for (int32_t cmd = 0; cmd < MAX_SYSCALLS; ++cmd)
+  {
+    if (!sorted[cmd].calls && !sorted[cmd].vmCalls) continue;
+    // insertion sort by total time
+    int32_t i = n++;
+    for (; i > 0 && sorted[cmds[i - 1]].ns < sorted[cmd].ns; --i) cmds[i] = cmds[i - 1];
+    cmds[i] = cmd;
+  }
+
+  trap_Print(vaf("%u sampled frames\n", sampled));
+  trap_Print("syscall                           calls    qvm   /frame  total ms   avg us   max us  histogram\n");
+  for (int32_t i = 0; i < n; ++i)
+  {
+    syscallStats_t const* const s = &sorted[cmds[i]];
+
+    char   histogram[HISTOGRAM_BUCKETS * 16] = "";
+    size_t len                                = 0;
+    for (uint8_t b = 0; b < HISTOGRAM_BUCKETS && len < sizeof(histogram); ++b)
+    {
+      if (!s->histogram[b]) continue;
+      len += snprintf(histogram + len, sizeof(histogram) - len, " <%s:%u", duration(2ull << b), s->histogram[b]);
+    }
+
+    trap_Print(vaf(
+      "%-32s %6u %6u %8.2f %9.3f %8.2f %8.2f %s\n",
+      syscall_name(cmds[i]),
+      s->calls,
+      s->vmCalls,
+      (double)s->calls / sampled,
+      (double)s->ns / 1e6,
+      s->calls ? (double)s->ns / s->calls / 1e3 : 0.,
+      (double)s->maxNs / 1e3,
+      histogram));
+  }
+}
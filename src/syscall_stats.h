@@ -0,0 +1,27 @@
+#ifndef SYSCALL_STATS_H
+#define SYSCALL_STATS_H
+
+#include "q_shared.h"
+
+#include <stdint.h>
+
+// Per-syscall call counts and log2 latency histograms, sampled every mdd_syscall_stats_sample-th frame (0 = off).
+// Only sampled frames go through syscall_stats_record, so the other frames don't pay for it.
+void init_syscall_stats(void);
+
+void update_syscall_stats(void);
+
+// Decides whether the frame that is about to start is sampled.
+void sample_syscall_stats(void);
+
+// Counts a syscall made by the qvm, these include the ones the proxy handles itself (CG_MEMSET, CG_SQRT, ...).
+void syscall_stats_vm(int32_t cmd);
+
+void syscall_stats_chain(intptr_t(QDECL* next)(intptr_t, ...));
+
+intptr_t QDECL syscall_stats_record(intptr_t cmd, ...);
+
+// Prints the statistics of the sampled frames so far and starts over.
+void print_syscall_stats(void);
+
+#endif // SYSCALL_STATS_H
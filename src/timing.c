@@ -0,0 +1,33 @@
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#  define _POSIX_C_SOURCE 199309L // clock_gettime
+#endif
+
+#include "timing.h"
+
+#ifdef _WIN32
+#  define WIN32_LEAN_AND_MEAN
+#  include <windows.h>
+#else
+#  include <time.h>
+#endif
+
+#ifdef _WIN32
+uint64_t time_ns(void)
+{
+  static LARGE_INTEGER frequency;
+  LARGE_INTEGER        counter;
+  if (!frequency.QuadPart) QueryPerformanceFrequency(&frequency);
+  QueryPerformanceCounter(&counter);
+  // split to avoid overflowing the multiplication for large counter values
+  uint64_t const seconds = (uint64_t)(counter.QuadPart / frequency.QuadPart);
+  uint64_t const rest    = (uint64_t)(counter.QuadPart % frequency.QuadPart);
+  return seconds * 1000000000 + rest * 1000000000 / (uint64_t)frequency.QuadPart;
+}
+#else
+uint64_t time_ns(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000 + (uint64_t)ts.tv_nsec;
+}
+#endif
@@ -0,0 +1,9 @@
+#ifndef TIMING_H
+#define TIMING_H
+
+#include <stdint.h>
+
+// Monotonic high-resolution clock in nanoseconds, only meaningful as a difference between two calls.
+uint64_t time_ns(void);
+
+#endif // TIMING_H
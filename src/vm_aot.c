@@ -0,0 +1,68 @@
+#include "vm_aot.h"
+
+#include "cg_local.h"
+#include "cg_syscall.h"
+#include "vm_hook.h"
+
+vmAot_t const* find_vm_aot(uint32_t crc32sum)
+{
+  for (vmAot_t const* const* aot = vm_aot_table; *aot; ++aot)
+  {
+    if ((*aot)->crc32sum == crc32sum) return *aot;
+  }
+  return NULL;
+}
+
+// OP_CALL of VM_Run, for the calls that aren't known to be a translated function
+int32_t* vm_aot_call(vm_t* vm, int32_t* opStack, int32_t returnAddress)
+{
+  int32_t const address = opStack[0];
+
+  if (address >= 0 && address < vm->memorySize)
+  {
+    opStack[0] = returnAddress;
+    return vm->aot->call(vm, address, opStack);
+  }
+
+  // system trap or real system function
+  int32_t        ret  = 0;
+  int32_t* const args = (int32_t*)(vm->dataSegment + vm->opBase) + 2;
+  vm->opStack         = opStack;
+  vm->hook_realfunc   = 0;
+  if (address < 0)
+  {
+    ret = (int32_t)CG_SysCalls(vm, -address - 1, args);
+  }
+  else
+  {
+    typedef uint32_t (*pfn_t)(
+      int32_t, int32_t, int32_t, int32_t, int32_t, int32_t, int32_t, int32_t, int32_t, int32_t, int32_t, int32_t);
+    ret = ((pfn_t)(intptr_t)address)(
+      args[0], args[1], args[2], args[3], args[4], args[5], args[6], args[7], args[8], args[9], args[10], args[11]);
+  }
+  opStack = vm->opStack;
+
+  // the hook asked for the real VM function
+  if (vm->hook_realfunc && address >= vm->memorySize)
+  {
+    opStack[0] = returnAddress;
+    return vm->aot->call(vm, vm->hook_realfunc, opStack);
+  }
+  opStack[0] = ret;
+  return opStack;
+}
+
+int32_t* vm_aot_hooks(vm_t* vm, int32_t address, int32_t* opStack)
+{
+  vm->opStack = opStack;
+  run_vm_hooks(vm, address, opStack);
+  return vm->opStack;
+}
+
+// a call or computed jump to where the translation has no code, the interpreter would run off into garbage
+int32_t* vm_aot_bad_address(vm_t* vm, int32_t address, int32_t* opStack)
+{
+  (void)vm;
+  trap_Error(vaf("ERROR: VM_Run: bad code address 0x%08x", address));
+  return opStack;
+}
@@ -0,0 +1,101 @@
+#ifndef VM_AOT_H
+#define VM_AOT_H
+
+#include "cg_vm.h"
+
+#include <stdint.h>
+
+// Ahead-of-time translations of supported qvms to C, generated at build time by qvmtool (see QVM_AOT_DIR in
+// src/CMakeLists.txt) and picked by checksum in VM_Create. Each qvm function becomes a C function taking and
+// returning the operand stack, the program stack and memory stay in the vm's data segment so that everything outside
+// (syscalls, hooks, VM_ArgPtr) sees the same state as with the interpreter. Hooks only fire on OP_ENTER,
+// OP_LEAVE and the defrag_t code offsets, and neither the instruction count nor mdd_vm_sample see translated code.
+typedef struct vmAot_s
+{
+  uint32_t crc32sum;
+  // runs the function starting at address, like VM_Run from its OP_ENTER to its OP_LEAVE
+  int32_t* (*call)(vm_t* vm, int32_t address, int32_t* opStack);
+} vmAot_t;
+
+// The translations compiled in, NULL terminated. Generated, qvmtool defines an empty one.
+extern vmAot_t const* const vm_aot_table[];
+
+vmAot_t const* find_vm_aot(uint32_t crc32sum);
+
+// Runtime of the generated code, for what's too big to inline.
+int32_t* vm_aot_call(vm_t* vm, int32_t* opStack, int32_t returnAddress);
+int32_t* vm_aot_hooks(vm_t* vm, int32_t address, int32_t* opStack);
+int32_t* vm_aot_bad_address(vm_t* vm, int32_t address, int32_t* opStack);
+
+// The instructions, as in VM_Run. The generated functions have vm, opStack, data (the data segment) and mask (its
+// mask) in scope.
+#define AOT_HOOK(address)                                                                                              \
+  if (vm->hookFlags[address]) opStack = vm_aot_hooks(vm, address, opStack)
+
+#define AOT_ENTER(param)                                                                                               \
+  vm->opBase -= (param);                                                                                               \
+  *((int32_t*)(data + vm->opBase) + 1) = *opStack++
+
+#define AOT_LEAVE(param)                                                                                               \
+  vm->opBase += (param);                                                                                               \
+  return opStack
+
+#define AOT_PUSH()       *--opStack = 0
+#define AOT_POP()        ++opStack
+#define AOT_CONST(value) *--opStack = (value)
+#define AOT_LOCAL(param) *--opStack = (param) + vm->opBase
+
+// calls to qvm functions known at translation time go straight to their translation
+#define AOT_CALL(returnAddress) opStack = vm_aot_call(vm, opStack, returnAddress)
+#define AOT_CALL_DIRECT(function, returnAddress)                                                                       \
+  opStack[0] = (returnAddress);                                                                                        \
+  opStack    = function(vm, opStack)
+
+#define AOT_JUMP(label)                                                                                                \
+  ++opStack;                                                                                                           \
+  goto label
+
+#define AOT_IF(condition, label)                                                                                       \
+  {                                                                                                                    \
+    int const taken = (condition);                                                                                     \
+    opStack += 2;                                                                                                      \
+    if (taken) goto label;                                                                                             \
+  }
+#define AOT_SOP(operation, label) AOT_IF(opStack[1] operation opStack[0], label)
+#define AOT_UOP(operation, label) AOT_IF(*(uint32_t*)&opStack[1] operation * (uint32_t*)&opStack[0], label)
+#define AOT_FOP(operation, label) AOT_IF(*(float*)&opStack[1] operation * (float*)&opStack[0], label)
+
+#define AOT_LOAD(type)                                                                                                 \
+  if (opStack[0] >= vm->memorySize)                                                                                    \
+    opStack[0] = *(type*)(intptr_t)(opStack[0]);                                                                       \
+  else                                                                                                                 \
+    opStack[0] = *(type*)&data[VM_ADDRESS(opStack[0], mask)]
+
+#define AOT_STORE(type, valueMask)                                                                                     \
+  if (opStack[1] >= vm->memorySize)                                                                                    \
+    *(type*)(intptr_t)(opStack[1]) = (type)(opStack[0] & (valueMask));                                                 \
+  else                                                                                                                 \
+    *(type*)&data[VM_ADDRESS(opStack[1], mask)] = (type)(opStack[0] & (valueMask));                                    \
+  opStack += 2
+
+#define AOT_ARG(param)                                                                                                 \
+  *(int32_t*)&data[VM_ADDRESS((param) + vm->opBase, mask)] = opStack[0];                                               \
+  ++opStack
+
+#define AOT_BLOCK_COPY(param)                                                                                          \
+  VM_BlockCopy(vm, opStack[1], opStack[0], param);                                                                     \
+  opStack += 2
+
+#define AOT_BINARY(operation) opStack[1] operation opStack[0], ++opStack
+#define AOT_UBINARY(operation) *(uint32_t*)&opStack[1] operation * (uint32_t*)&opStack[0], ++opStack
+#define AOT_FBINARY(operation) *(float*)&opStack[1] operation * (float*)&opStack[0], ++opStack
+
+#define AOT_SEX8()  if (opStack[0] & 0x80) opStack[0] |= 0xFFFFFF00
+#define AOT_SEX16() if (opStack[0] & 0x8000) opStack[0] |= 0xFFFF0000
+#define AOT_NEGI()  opStack[0] = -opStack[0]
+#define AOT_BCOM()  opStack[0] = ~opStack[0]
+#define AOT_NEGF()  *(float*)&opStack[0] = -*(float*)&opStack[0]
+#define AOT_CVIF()  *(float*)&opStack[0] = (float)opStack[0]
+#define AOT_CVFI()  opStack[0] = (int32_t)(*(float*)&opStack[0])
+
+#endif // VM_AOT_H
@@ -0,0 +1,95 @@
+#include "vm_hook.h"
+
+#include "cg_local.h"
+
+#include <stdlib.h>
+
+typedef struct
+{
+  int32_t  address;
+  vmHook_t fn;
+  qboolean post;
+} vmHookEntry_t;
+
+struct vmHooks_s
+{
+  vmHookEntry_t entries[MAX_VM_HOOKS];
+  int32_t       count;
+};
+
+void init_vm_hooks(vm_t* vm)
+{
+  vm->hookFlags = calloc(vm->codeSegmentLen, sizeof(*vm->hookFlags));
+  vm->hooks     = calloc(1, sizeof(*vm->hooks));
+  if (vm->hookFlags && vm->hooks) return;
+  free_vm_hooks(vm);
+}
+
+void free_vm_hooks(vm_t* vm)
+{
+  free(vm->hookFlags);
+  free(vm->hooks);
+  vm->hookFlags = NULL;
+  vm->hooks     = NULL;
+}
+
+static qboolean add(vm_t* vm, int32_t address, vmHook_t fn, qboolean post)
+{
+  if (!vm->hookFlags || address < 0 || address >= vm->codeSegmentLen) return qfalse;
+  if (vm->hooks->count == MAX_VM_HOOKS)
+  {
+    trap_Print("^3Warning: too many vm hooks\n");
+    return qfalse;
+  }
+
+  vmHookEntry_t* const hook = &vm->hooks->entries[vm->hooks->count++];
+  hook->address             = address;
+  hook->fn                  = fn;
+  hook->post                = post;
+  vm->hookFlags[address]    = 1;
+  return qtrue;
+}
+
+qboolean add_vm_hook(vm_t* vm, int32_t address, vmHook_t fn)
+{
+  return add(vm, address, fn, qfalse);
+}
+
+qboolean add_vm_function_hooks(vm_t* vm, int32_t address, vmHook_t pre, vmHook_t post)
+{
+  if (address < 0 || address >= vm->codeSegmentLen || vm->codeSegment[2 * address] != OP_ENTER) return qfalse;
+  if (pre && !add(vm, address, pre, qfalse)) return qfalse;
+  if (!post) return qtrue;
+
+  // the function ends at the next OP_ENTER
+  for (int32_t i = address + 1; i < vm->codeSegmentLen && vm->codeSegment[2 * i] != OP_ENTER; ++i)
+  {
+    if (vm->codeSegment[2 * i] == OP_LEAVE && !add(vm, i, post, qtrue)) return qfalse;
+  }
+  return qtrue;
+}
+
+void run_vm_hooks(vm_t* vm, int32_t address, int32_t* opStack)
+{
+  vmHookContext_t ctx;
+  ctx.vm      = vm;
+  ctx.address = address;
+
+  // before OP_ENTER the frame is still the caller's, before OP_LEAVE it's the callee's of size param
+  int32_t const op    = vm->codeSegment[2 * address];
+  int32_t const param = vm->codeSegment[2 * address + 1];
+  if (op == OP_ENTER)
+    ctx.args = (int32_t const*)(vm->dataSegment + vm->opBase) + 2;
+  else if (op == OP_LEAVE)
+    ctx.args = (int32_t const*)(vm->dataSegment + vm->opBase + param) + 2;
+  else
+    ctx.args = NULL;
+
+  for (int32_t i = 0; i < vm->hooks->count; ++i)
+  {
+    vmHookEntry_t const* const hook = &vm->hooks->entries[i];
+    if (hook->address != address) continue;
+    ctx.ret = hook->post ? opStack : NULL;
+    hook->fn(&ctx);
+  }
+}
@@ -0,0 +1,40 @@
+#ifndef VM_HOOK_H
+#define VM_HOOK_H
+
+#include "cg_vm.h"
+
+#include <stdint.h>
+
+#define MAX_VM_HOOKS 64
+
+typedef struct
+{
+  vm_t*          vm;
+  int32_t        address; // instruction the hook fired at
+  int32_t const* args;    // arguments of the hooked function, NULL for hooks on other instructions
+  int32_t*       ret;     // return value of the hooked function, post hooks only, may be changed
+} vmHookContext_t;
+
+typedef void (*vmHook_t)(vmHookContext_t* ctx);
+
+// Hooks are native callbacks VM_Run makes before executing the instruction they are attached to. A byte per
+// instruction in vm->hookFlags tells whether there are any, so unhooked code only pays for that test. Translated
+// qvms (vm_aot.h) only test it on OP_ENTER, OP_LEAVE and the defrag_t offsets.
+//
+// Allocates vm->hookFlags and vm->hooks without any hooks, called by VM_Create. Both stay NULL when out of memory.
+void init_vm_hooks(vm_t* vm);
+
+// Frees them, called by VM_Destroy.
+void free_vm_hooks(vm_t* vm);
+
+// Calls fn before the instruction at address executes.
+qboolean add_vm_hook(vm_t* vm, int32_t address, vmHook_t fn);
+
+// Calls pre on entry of the function starting at address (its OP_ENTER) and post at each of its OP_LEAVEs, either
+// may be NULL.
+qboolean add_vm_function_hooks(vm_t* vm, int32_t address, vmHook_t pre, vmHook_t post);
+
+// Runs the hooks attached to address, opStack as in VM_Run.
+void run_vm_hooks(vm_t* vm, int32_t address, int32_t* opStack);
+
+#endif // VM_HOOK_H
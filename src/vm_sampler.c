@@ -0,0 +1,293 @@
+#if defined(__linux__) && !defined(_XOPEN_SOURCE)
+#  define _XOPEN_SOURCE 700 // sigaction, setitimer
+#endif
+
+#include "vm_sampler.h"
+
+#include "cg_local.h"
+#include "cg_vm.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifdef VM_SAMPLER
+#  include <errno.h>
+#  include <signal.h>
+#  include <string.h>
+#  include <sys/time.h>
+
+// g_VM.samplePc while sampling: written by the interpreter before each instruction, NULL while outside qvm code
+static int32_t const* volatile vm_sample_pc;
+
+typedef struct
+{
+  int32_t  start; // instruction index of its OP_ENTER
+  uint32_t hits;
+  int32_t  hottest;
+} sampledFunction_t;
+
+typedef struct
+{
+  int32_t value;
+  char    name[64];
+} mapSymbol_t;
+
+// set before the timer is armed, read by the handler
+static int32_t const*        code;
+static volatile int32_t      codeLen;
+static uint32_t*             hits;
+static volatile sig_atomic_t misses;
+static volatile sig_atomic_t samples;
+
+static struct sigaction oldAction;
+
+static void on_sigprof(int sig)
+{
+  (void)sig;
+  int32_t const* const pc = vm_sample_pc;
+  if (pc >= code && pc < code + 2 * codeLen)
+    ++hits[(pc - code) / 2];
+  else
+    ++misses;
+  ++samples;
+}
+
+static void start(int32_t hz)
+{
+  if (hits)
+  {
+    trap_Print("^3already sampling\n");
+    return;
+  }
+  if (!g_VM.codeSegment)
+  {
+    trap_Print("^3no qvm loaded\n");
+    return;
+  }
+  if (hz <= 0 || hz > 10000) hz = 1000;
+
+  hits = calloc(g_VM.codeSegmentLen, sizeof(*hits));
+  if (!hits)
+  {
+    trap_Print("^3out of memory\n");
+    return;
+  }
+  code    = g_VM.codeSegment;
+  codeLen = g_VM.codeSegmentLen;
+  misses  = 0;
+  samples = 0;
+
+  struct sigaction action;
+  memset(&action, 0, sizeof(action));
+  action.sa_handler = on_sigprof;
+  action.sa_flags   = SA_RESTART;
+  sigemptyset(&action.sa_mask);
+  if (sigaction(SIGPROF, &action, &oldAction))
+  {
+    trap_Print(vaf("^3could not install the SIGPROF handler: %s\n", strerror(errno)));
+    free(hits);
+    hits = NULL;
+    return;
+  }
+  g_VM.samplePc = &vm_sample_pc;
+
+  // tv_usec must stay below a second
+  struct itimerval timer;
+  timer.it_interval.tv_sec  = 1 / hz;
+  timer.it_interval.tv_usec = 1000000 / hz % 1000000;
+  timer.it_value            = timer.it_interval;
+  if (setitimer(ITIMER_PROF, &timer, NULL))
+  {
+    trap_Print(vaf("^3could not start the profiling timer: %s\n", strerror(errno)));
+    stop_vm_sampler();
+    return;
+  }
+  trap_Print(vaf("sampling the qvm at %i Hz\n", hz));
+}
+
+void stop_vm_sampler(void)
+{
+  if (!hits) return;
+
+  struct itimerval timer;
+  memset(&timer, 0, sizeof(timer));
+  setitimer(ITIMER_PROF, &timer, NULL);
+  g_VM.samplePc = NULL;
+  vm_sample_pc  = NULL;
+  codeLen       = 0;
+  sigaction(SIGPROF, &oldAction, NULL);
+
+  free(hits);
+  hits = NULL;
+}
+
+static int compare_hits(void const* a, void const* b)
+{
+  uint32_t const x = ((sampledFunction_t const*)a)->hits;
+  uint32_t const y = ((sampledFunction_t const*)b)->hits;
+  return (x < y) - (x > y);
+}
+
+static int compare_values(void const* a, void const* b)
+{
+  int32_t const x = ((mapSymbol_t const*)a)->value;
+  int32_t const y = ((mapSymbol_t const*)b)->value;
+  return (x > y) - (x < y);
+}
+
+// Reads the code symbols ("0 value name" lines) of a q3asm .map file, sorted by instruction index.
+static mapSymbol_t* read_map(char const* path, int32_t* count)
+{
+  fileHandle_t  f;
+  int32_t const len = trap_FS_FOpenFile(path, &f, FS_READ);
+  *count            = 0;
+  if (!f)
+  {
+    trap_Print(vaf("^3could not open %s\n", path));
+    return NULL;
+  }
+
+  char*        text    = malloc(len + 1);
+  int32_t      lines   = 1;
+  mapSymbol_t* symbols = NULL;
+  if (text)
+  {
+    trap_FS_Read(text, len, f);
+    text[len] = '\0';
+    for (int32_t i = 0; i < len; ++i) lines += text[i] == '\n';
+    symbols = malloc(lines * sizeof(*symbols));
+  }
+  trap_FS_FCloseFile(f);
+  if (!symbols)
+  {
+    free(text);
+    return NULL;
+  }
+
+  for (char* line = text; line; line = strchr(line, '\n'))
+  {
+    int32_t  segment;
+    uint32_t value;
+    if (*line == '\n') ++line;
+    if (*count < lines && sscanf(line, "%d %x %63s", &segment, &value, symbols[*count].name) == 3 && segment == 0)
+    {
+      symbols[(*count)++].value = (int32_t)value;
+    }
+  }
+  free(text);
+
+  qsort(symbols, *count, sizeof(*symbols), compare_values);
+  return symbols;
+}
+
+static void symbol_name(mapSymbol_t const* symbols, int32_t count, int32_t value, char* name, size_t size)
+{
+  // last symbol at or before value
+  int32_t lo = 0, hi = count;
+  while (lo < hi)
+  {
+    int32_t const mid = (lo + hi) / 2;
+    if (symbols[mid].value <= value)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  if (!lo)
+    snprintf(name, size, "%x", value);
+  else if (symbols[lo - 1].value == value)
+    snprintf(name, size, "%s", symbols[lo - 1].name);
+  else
+    snprintf(name, size, "%s+%x", symbols[lo - 1].name, value - symbols[lo - 1].value);
+}
+
+static void report(int32_t top, char const* mapPath)
+{
+  if (!hits)
+  {
+    trap_Print("usage: mdd_vm_sample start [hz] first\n");
+    return;
+  }
+
+  // functions start at OP_ENTER, everything before the first one is attributed to it as well
+  int32_t functionCount = 0;
+  for (int32_t i = 0; i < codeLen; ++i) functionCount += code[2 * i] == OP_ENTER;
+  sampledFunction_t* functions = calloc(functionCount + 1, sizeof(*functions));
+  if (!functions) return;
+
+  int32_t  n   = 0;
+  uint32_t max = 0;
+  for (int32_t i = 0; i < codeLen; ++i)
+  {
+    if (code[2 * i] == OP_ENTER && (i || n))
+    {
+      ++n;
+      functions[n].start = i;
+      max                = 0;
+    }
+    uint32_t const h = hits[i];
+    functions[n].hits += h;
+    if (h > max)
+    {
+      max                  = h;
+      functions[n].hottest = i;
+    }
+  }
+  ++n;
+  qsort(functions, n, sizeof(*functions), compare_hits);
+
+  int32_t      symbolCount = 0;
+  mapSymbol_t* symbols     = mapPath[0] ? read_map(mapPath, &symbolCount) : NULL;
+
+  uint32_t const total = (uint32_t)samples;
+  uint32_t const inVM  = total - (uint32_t)misses;
+  trap_Print(vaf("%u samples, %u in the qvm (%.1f%%)\n", total, inVM, total ? 100. * inVM / total : 0.));
+  trap_Print("     %      hits  function                          hottest\n");
+  for (int32_t i = 0; i < n && i < top && functions[i].hits; ++i)
+  {
+    char name[64 + 16], hottest[64 + 16];
+    symbol_name(symbols, symbolCount, functions[i].start, name, sizeof(name));
+    symbol_name(symbols, symbolCount, functions[i].hottest, hottest, sizeof(hottest));
+    trap_Print(vaf(
+      "%6.2f %9u  %-32s  %s\n", inVM ? 100. * functions[i].hits / inVM : 0., functions[i].hits, name, hottest));
+  }
+
+  free(symbols);
+  free(functions);
+}
+
+void vm_sample(void)
+{
+  char arg[MAX_QPATH];
+  trap_Argv(1, arg, sizeof(arg));
+
+  if (!Q_stricmp(arg, "start"))
+  {
+    trap_Argv(2, arg, sizeof(arg));
+    start(atoi(arg));
+  }
+  else if (!Q_stricmp(arg, "stop"))
+  {
+    stop_vm_sampler();
+  }
+  else if (!Q_stricmp(arg, "report"))
+  {
+    char mapPath[MAX_QPATH];
+    trap_Argv(2, arg, sizeof(arg));
+    trap_Argv(3, mapPath, sizeof(mapPath));
+    report(arg[0] ? atoi(arg) : 20, mapPath);
+  }
+  else
+  {
+    trap_Print("usage: mdd_vm_sample start [hz] | stop | report [functions] [mapfile]\n");
+  }
+}
+#else
+void vm_sample(void)
+{
+  trap_Print("mdd_vm_sample is only supported on Linux\n");
+}
+
+void stop_vm_sampler(void)
+{
+}
+#endif
@@ -0,0 +1,20 @@
+#ifndef VM_SAMPLER_H
+#define VM_SAMPLER_H
+
+#include <stdint.h>
+
+// Statistical profiler for the qvm: SIGPROF fires every 1/hz seconds of process cpu time and the handler counts the
+// instruction the interpreter is at, or a miss when it is not running qvm code (proxy, syscalls and the engine).
+// The report sums the hits per qvm function, the functions being delimited by OP_ENTER, and names them with an
+// optional q3asm .map file. Linux only, elsewhere the command just says so.
+#ifdef __linux__
+#  define VM_SAMPLER
+#endif
+
+// mdd_vm_sample start [hz] | stop | report [functions] [mapfile]
+void vm_sample(void);
+
+// Stops sampling and drops the histogram, which is only valid for the code segment it was started on.
+void stop_vm_sampler(void);
+
+#endif // VM_SAMPLER_H
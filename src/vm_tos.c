@@ -0,0 +1,393 @@
+#include "vm_tos.h"
+
+#include "cg_cvar.h"
+#include "cg_local.h"
+#include "cg_syscall.h"
+#include "vm_hook.h"
+#include "vm_sampler.h"
+
+static vmCvar_t vm_tos;
+
+static cvarTable_t vm_tos_cvars[] = {
+  { &vm_tos, "mdd_vm_tos", "1", CVAR_ARCHIVE_ND },
+};
+
+void init_vm_tos(void)
+{
+  init_cvars(vm_tos_cvars, ARRAY_LEN(vm_tos_cvars));
+}
+
+void update_vm_tos(void)
+{
+  update_cvars(vm_tos_cvars, ARRAY_LEN(vm_tos_cvars));
+  g_VM.cacheTos = vm_tos_enabled();
+}
+
+qboolean vm_tos_enabled(void)
+{
+  return vm_tos.integer != 0;
+}
+
+// Added to the opcode while the top of the stack is cached, every case label is the handler for one opcode in one of
+// the two states. The stack in memory (opStack[0] being its top) is the rest of the operand stack.
+#define CACHED 64
+
+static VM_FORCE_INLINE void VM_RunTosLoop(vm_t* vm, qboolean const instrumented)
+{
+  vmOps_t op;
+  int32_t param;
+  int32_t state = 0;
+
+  union
+  {
+    int32_t  i;
+    uint32_t u;
+    float    f;
+  } tos = { 0 };
+
+  // local registers
+  int32_t* opStack   = vm->opStack;
+  int32_t* opPointer = vm->opPointer;
+
+  // constants /not changed during execution/
+  byte* const          dataSegment     = vm->dataSegment;
+  uint32_t const       dataSegmentMask = vm->dataSegmentMask;
+  int32_t const        memorySize      = vm->memorySize;
+  uint8_t const* const hookFlags       = vm->hookFlags; // NULL for a vm nobody set up hooks for
+
+  uint64_t instructions = 0;
+
+#ifdef VM_SAMPLER
+  int32_t const* volatile        unsampled;
+  int32_t const* volatile* const samplePc = vm->samplePc ? vm->samplePc : &unsampled;
+#endif
+
+#define GOTO(x) opPointer = vm->codeSegment + (x)*2
+#define SPILL()                                                                                                        \
+  if (state)                                                                                                           \
+  {                                                                                                                    \
+    *--opStack = tos.i;                                                                                                \
+    state      = 0;                                                                                                    \
+  }
+
+  do
+  {
+    if (instrumented)
+    {
+      ++instructions;
+#ifdef VM_SAMPLER
+      *samplePc = opPointer;
+#endif
+    }
+
+    op    = opPointer[0];
+    param = opPointer[1];
+    opPointer += 2;
+
+    // native hooks, see vm_hook.h
+    if (hookFlags && hookFlags[(opPointer - 2 - vm->codeSegment) / 2])
+    {
+#ifdef VM_SAMPLER
+      if (instrumented) *samplePc = NULL;
+#endif
+      SPILL()
+      vm->opStack   = opStack;
+      vm->opPointer = opPointer;
+      run_vm_hooks(vm, (int32_t)(opPointer - 2 - vm->codeSegment) / 2, opStack);
+      opStack   = vm->opStack;
+      opPointer = vm->opPointer;
+    }
+
+    // past OP_CVFI the opcode would alias the handlers of the cached state
+    if ((uint32_t)op > OP_CVFI)
+    {
+      trap_Error(vaf("ERROR: VM_Run: Unhandled opcode(%i)", op));
+      continue;
+    }
+
+  dispatch:
+    switch (op + state)
+    {
+    // every instruction but the pushes and OP_LEAVE needs the top of the stack, fetch it and dispatch again
+    default:
+      if (!state && op > OP_BREAK)
+      {
+        tos.i = *opStack++;
+        state = CACHED;
+        goto dispatch;
+      }
+      trap_Error(vaf("ERROR: VM_Run: Unhandled opcode(%i)", op));
+      break;
+
+    //
+    // subroutines
+    //
+    case CACHED + OP_ENTER:
+      vm->opBase -= param;
+      *((int32_t*)(dataSegment + vm->opBase) + 1) = tos.i;
+      state                                       = 0;
+      break;
+
+    case OP_LEAVE:
+    case CACHED + OP_LEAVE:
+      opPointer = vm->codeSegment + *((int32_t*)(dataSegment + vm->opBase) + 1);
+      vm->opBase += param;
+      break;
+
+    // calls of qvm functions keep the return address cached for their OP_ENTER, anything else is called like VM_Run
+    // does with the stack in memory
+    case CACHED + OP_CALL:
+      if ((uint32_t)tos.i < (uint32_t)memorySize)
+      {
+        param = tos.i;
+        tos.i = (int32_t)(opPointer - vm->codeSegment);
+        GOTO(param);
+        break;
+      }
+      SPILL()
+      // fall through
+    case OP_CALL:
+      param = opStack[0];
+
+      if (param < 0 || param >= memorySize)
+      {
+        int32_t ret = 0;
+
+        vm->opStack       = opStack;
+        vm->opPointer     = opPointer;
+        vm->hook_realfunc = 0;
+#ifdef VM_SAMPLER
+        if (instrumented) *samplePc = NULL;
+#endif
+
+        int32_t* const args = (int32_t*)(dataSegment + vm->opBase) + 2;
+        if (param < 0)
+        {
+          ret = (int32_t)CG_SysCalls(vm, -param - 1, args);
+        }
+        else
+        {
+          typedef uint32_t (*pfn_t)(
+            int32_t, int32_t, int32_t, int32_t, int32_t, int32_t, int32_t, int32_t, int32_t, int32_t, int32_t, int32_t);
+          ret = ((pfn_t)(intptr_t)param)(
+            args[0],
+            args[1],
+            args[2],
+            args[3],
+            args[4],
+            args[5],
+            args[6],
+            args[7],
+            args[8],
+            args[9],
+            args[10],
+            args[11]);
+        }
+
+        opStack   = vm->opStack;
+        opPointer = vm->opPointer;
+
+        // the hook asked for the real VM function
+        if (vm->hook_realfunc && param >= memorySize)
+        {
+          opStack[0] = (int32_t)(opPointer - vm->codeSegment);
+          GOTO(vm->hook_realfunc);
+        }
+        else
+        {
+          opStack[0] = ret;
+        }
+        break;
+      }
+      opStack[0] = (int32_t)(opPointer - vm->codeSegment);
+      GOTO(param);
+      break;
+
+    //
+    // stack
+    //
+#define PUSH(operation, value)                                                                                         \
+  case operation:                                                                                                      \
+    tos.i = (value);                                                                                                   \
+    state = CACHED;                                                                                                    \
+    break;                                                                                                             \
+  case CACHED + operation:                                                                                             \
+    *--opStack = tos.i;                                                                                                \
+    tos.i      = (value);                                                                                              \
+    break;
+
+      PUSH(OP_PUSH, 0)
+      PUSH(OP_CONST, param)
+      PUSH(OP_LOCAL, param + vm->opBase)
+
+    case OP_POP:
+      opStack++;
+      break;
+    case CACHED + OP_POP:
+      state = 0;
+      break;
+
+    //
+    // branching
+    //
+#define BRANCH(operation, condition)                                                                                   \
+  case CACHED + operation:                                                                                             \
+    if (condition) GOTO(param);                                                                                        \
+    opStack++;                                                                                                         \
+    state = 0;                                                                                                         \
+    break;
+#define SOP(operation, x) BRANCH(operation, opStack[0] x tos.i)
+#define UOP(operation, x) BRANCH(operation, *(uint32_t*)&opStack[0] x tos.u)
+#define FOP(operation, x) BRANCH(operation, *(float*)&opStack[0] x tos.f)
+
+    case CACHED + OP_JUMP:
+      GOTO(tos.i);
+      state = 0;
+      break;
+
+      SOP(OP_EQ, ==)
+      SOP(OP_NE, !=)
+      SOP(OP_LTI, <)
+      SOP(OP_LEI, <=)
+      SOP(OP_GTI, >)
+      SOP(OP_GEI, >=)
+      UOP(OP_LTU, <)
+      UOP(OP_LEU, <=)
+      UOP(OP_GTU, >)
+      UOP(OP_GEU, >=)
+      FOP(OP_EQF, ==)
+      FOP(OP_NEF, !=)
+      FOP(OP_LTF, <)
+      FOP(OP_LEF, <=)
+      FOP(OP_GTF, >)
+      FOP(OP_GEF, >=)
+
+    //
+    // memory I/O: masks or guard pages protect main memory
+    //
+#define LOAD(operation, type)                                                                                          \
+  case CACHED + operation:                                                                                             \
+    if (tos.i >= memorySize)                                                                                           \
+      tos.i = *(type*)(intptr_t)tos.i;                                                                                 \
+    else                                                                                                               \
+      tos.i = *(type*)&dataSegment[VM_ADDRESS(tos.i, dataSegmentMask)];                                                \
+    break;
+#define STORE(operation, type, mask)                                                                                   \
+  case CACHED + operation:                                                                                             \
+    if (opStack[0] >= memorySize)                                                                                      \
+      *(type*)(intptr_t)opStack[0] = (type)(tos.i & (mask));                                                           \
+    else                                                                                                               \
+      *(type*)&dataSegment[VM_ADDRESS(opStack[0], dataSegmentMask)] = (type)(tos.i & (mask));                          \
+    opStack++;                                                                                                         \
+    state = 0;                                                                                                         \
+    break;
+
+      LOAD(OP_LOAD1, byte)
+      LOAD(OP_LOAD2, uint16_t)
+      LOAD(OP_LOAD4, int32_t)
+      STORE(OP_STORE1, byte, 0xFF)
+      STORE(OP_STORE2, uint16_t, 0xFFFF)
+      STORE(OP_STORE4, int32_t, -1)
+
+    case CACHED + OP_ARG:
+      *(int32_t*)&dataSegment[VM_ADDRESS(param + vm->opBase, dataSegmentMask)] = tos.i;
+      state                                                                    = 0;
+      break;
+
+    case CACHED + OP_BLOCK_COPY:
+      VM_BlockCopy(vm, opStack[0], tos.i, param);
+      opStack++;
+      state = 0;
+      break;
+
+    //
+    // arithmetic and logic, the second operand is opStack[0]
+    //
+#undef SOP
+#undef UOP
+#undef FOP
+#define SOP(operation, x)                                                                                              \
+  case CACHED + operation:                                                                                             \
+    tos.i = *opStack++ x tos.i;                                                                                        \
+    break;
+#define UOP(operation, x)                                                                                              \
+  case CACHED + operation:                                                                                             \
+    tos.u = *(uint32_t*)opStack++ x tos.u;                                                                             \
+    break;
+#define FOP(operation, x)                                                                                              \
+  case CACHED + operation:                                                                                             \
+    tos.f = *(float*)opStack++ x tos.f;                                                                                \
+    break;
+
+    case CACHED + OP_SEX8:
+      if (tos.i & 0x80) tos.i |= 0xFFFFFF00;
+      break;
+    case CACHED + OP_SEX16:
+      if (tos.i & 0x8000) tos.i |= 0xFFFF0000;
+      break;
+    case CACHED + OP_NEGI:
+      tos.i = -tos.i;
+      break;
+    case CACHED + OP_BCOM:
+      tos.i = ~tos.i;
+      break;
+    case CACHED + OP_NEGF:
+      tos.f = -tos.f;
+      break;
+
+      SOP(OP_ADD, +)
+      SOP(OP_SUB, -)
+      SOP(OP_DIVI, /)
+      UOP(OP_DIVU, /)
+      SOP(OP_MODI, %)
+      UOP(OP_MODU, %)
+      SOP(OP_MULI, *)
+      UOP(OP_MULU, *)
+      SOP(OP_BAND, &)
+      SOP(OP_BOR, |)
+      SOP(OP_BXOR, ^)
+      UOP(OP_LSH, <<)
+      SOP(OP_RSHI, >>)
+      UOP(OP_RSHU, >>)
+      FOP(OP_ADDF, +)
+      FOP(OP_SUBF, -)
+      FOP(OP_DIVF, /)
+      FOP(OP_MULF, *)
+
+    //
+    // format conversion
+    //
+    case CACHED + OP_CVIF:
+      tos.f = (float)tos.i;
+      break;
+    case CACHED + OP_CVFI:
+      tos.i = (int32_t)tos.f;
+      break;
+    }
+  } while ((int32_t)(intptr_t)opPointer);
+#ifdef VM_SAMPLER
+  if (instrumented) *samplePc = NULL;
+#endif
+
+  SPILL()
+  vm->opStack = opStack;
+  if (instrumented && vm->countInstructions) vm->instructionsExecuted += instructions;
+
+#undef GOTO
+#undef SPILL
+#undef PUSH
+#undef BRANCH
+#undef SOP
+#undef UOP
+#undef FOP
+#undef LOAD
+#undef STORE
+}
+
+void VM_RunTos(vm_t* vm)
+{
+  if (vm->countInstructions || vm->samplePc)
+    VM_RunTosLoop(vm, qtrue);
+  else
+    VM_RunTosLoop(vm, qfalse);
+}
@@ -0,0 +1,23 @@
+#ifndef VM_TOS_H
+#define VM_TOS_H
+
+#include "cg_vm.h"
+
+// Variant of VM_Run that keeps the top of the operand stack in a local instead of opStack[0]. Whether it is cached
+// is part of the state the instructions are dispatched on, so pushes onto an empty cache and the operations on the
+// cached value don't touch the stack in memory. The cache is spilled at calls leaving the interpreted code (syscalls,
+// real pointers) and before hooks, everything outside sees the same stack as with VM_Run.
+//
+// mdd_vm_tos: 1 runs it instead of VM_Run when vm->aot is NULL, 0 runs VM_Run.
+void init_vm_tos(void);
+
+// Applies mdd_vm_tos to g_VM.
+void update_vm_tos(void);
+
+// For VM_Create, the hud is initialized before the vm.
+qboolean vm_tos_enabled(void);
+
+// Called by VM_Exec when vm->cacheTos is set.
+void VM_RunTos(vm_t* vm);
+
+#endif // VM_TOS_H
@@ -0,0 +1,339 @@
+#include "syscalls_client_fake.hpp"
+#include "syscalls_cvar_fake.hpp"
+#include "syscalls_mock.hpp"
+
+extern "C"
+{
+#include <bg_public.h>
+#include <cg_cgaz.h>
+#include <cg_cvar.h>
+#include <cg_draw.h>
+#include <cg_local.h>
+#include <cg_snap.h>
+#include <cg_vm.h>
+#include <defrag.h>
+#include <vm_hook.h>
+}
+
+#include <benchmark/benchmark.h>
+
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+namespace
+{
+// Hand assembled bytecode, laid out in memory like VM_Create does.
+class SyntheticVm
+{
+public:
+  SyntheticVm(std::vector<std::int32_t> const& code, bool cacheTos)
+    : memory_(code.size() * sizeof(std::int32_t) + dataLen + stackLen)
+  {
+    static bool const defrag = init_defrag(0xF9C2764A); // 1.91.24, the hud offsets are never reached
+    (void)defrag;
+
+    std::memcpy(memory_.data(), code.data(), code.size() * sizeof(std::int32_t));
+
+    vm_                 = {};
+    vm_.codeSegment     = reinterpret_cast<std::int32_t*>(memory_.data());
+    vm_.dataSegment     = memory_.data() + code.size() * sizeof(std::int32_t);
+    vm_.stackSegment    = vm_.dataSegment + dataLen;
+    vm_.codeSegmentLen  = static_cast<std::int32_t>(code.size() / 2);
+    vm_.dataSegmentLen  = dataLen;
+    vm_.stackSegmentLen = stackLen;
+    for (vm_.dataSegmentMask = 1; vm_.dataSegmentMask <= dataLen + stackLen; vm_.dataSegmentMask <<= 1)
+    {
+    }
+    --vm_.dataSegmentMask;
+    vm_.memorySize        = static_cast<std::int32_t>(memory_.size());
+    vm_.memory            = memory_.data();
+    vm_.opStack           = reinterpret_cast<std::int32_t*>(vm_.stackSegment + stackLen);
+    vm_.opBase            = dataLen + stackLen / 2;
+    vm_.cacheTos          = cacheTos ? qtrue : qfalse;
+    vm_.countInstructions = qtrue;
+    init_vm_hooks(&vm_);
+  }
+
+  SyntheticVm(SyntheticVm const&) = delete;
+  SyntheticVm& operator=(SyntheticVm const&) = delete;
+
+  ~SyntheticVm()
+  {
+    free_vm_hooks(&vm_);
+  }
+
+  std::int32_t exec(std::int32_t command)
+  {
+    return static_cast<std::int32_t>(VM_Exec(&vm_, command, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0));
+  }
+
+  std::uint64_t instructions() const
+  {
+    return vm_.instructionsExecuted;
+  }
+
+private:
+  static constexpr std::int32_t dataLen  = 1024;
+  static constexpr std::int32_t stackLen = 64 * 1024;
+
+  std::vector<byte> memory_;
+  vm_t              vm_;
+};
+
+class Assembler
+{
+public:
+  std::int32_t emit(vmOps_t op, std::int32_t param = 0)
+  {
+    code_.push_back(op);
+    code_.push_back(param);
+    return here() - 1;
+  }
+
+  std::int32_t here() const
+  {
+    return static_cast<std::int32_t>(code_.size() / 2);
+  }
+
+  void patch(std::int32_t instruction, std::int32_t param)
+  {
+    code_[2 * instruction + 1] = param;
+  }
+
+  std::vector<std::int32_t> const& code() const
+  {
+    return code_;
+  }
+
+private:
+  std::vector<std::int32_t> code_;
+};
+
+// int vmMain(int n) { int i, sum = 0; for (i = 0; i < n; ++i) sum += i; return sum; }
+std::vector<std::int32_t> loopProgram()
+{
+  Assembler a;
+  a.emit(OP_ENTER, 16);
+  a.emit(OP_LOCAL, 8);
+  a.emit(OP_CONST, 0);
+  a.emit(OP_STORE4);
+  a.emit(OP_LOCAL, 12);
+  a.emit(OP_CONST, 0);
+  a.emit(OP_STORE4);
+  std::int32_t const toCond = a.emit(OP_CONST);
+  a.emit(OP_JUMP);
+  std::int32_t const body = a.here();
+  a.emit(OP_LOCAL, 12);
+  a.emit(OP_LOCAL, 12);
+  a.emit(OP_LOAD4);
+  a.emit(OP_LOCAL, 8);
+  a.emit(OP_LOAD4);
+  a.emit(OP_ADD);
+  a.emit(OP_STORE4);
+  a.emit(OP_LOCAL, 8);
+  a.emit(OP_LOCAL, 8);
+  a.emit(OP_LOAD4);
+  a.emit(OP_CONST, 1);
+  a.emit(OP_ADD);
+  a.emit(OP_STORE4);
+  a.patch(toCond, a.here());
+  a.emit(OP_LOCAL, 8);
+  a.emit(OP_LOAD4);
+  a.emit(OP_LOCAL, 24);
+  a.emit(OP_LOAD4);
+  a.emit(OP_LTI, body);
+  a.emit(OP_LOCAL, 12);
+  a.emit(OP_LOAD4);
+  a.emit(OP_LEAVE, 16);
+  return a.code();
+}
+
+// int f(int i) { return i << 1; }
+// int vmMain(int n) { int i, sum = 0; for (i = 0; i < n; ++i) sum += f(i); return sum; }
+std::vector<std::int32_t> callProgram()
+{
+  Assembler a;
+  a.emit(OP_ENTER, 24);
+  a.emit(OP_LOCAL, 12);
+  a.emit(OP_CONST, 0);
+  a.emit(OP_STORE4);
+  a.emit(OP_LOCAL, 16);
+  a.emit(OP_CONST, 0);
+  a.emit(OP_STORE4);
+  std::int32_t const toCond = a.emit(OP_CONST);
+  a.emit(OP_JUMP);
+  std::int32_t const body = a.here();
+  a.emit(OP_LOCAL, 12);
+  a.emit(OP_LOAD4);
+  a.emit(OP_ARG, 8);
+  a.emit(OP_LOCAL, 16);
+  a.emit(OP_LOCAL, 16);
+  a.emit(OP_LOAD4);
+  std::int32_t const toF = a.emit(OP_CONST);
+  a.emit(OP_CALL);
+  a.emit(OP_ADD);
+  a.emit(OP_STORE4);
+  a.emit(OP_LOCAL, 12);
+  a.emit(OP_LOCAL, 12);
+  a.emit(OP_LOAD4);
+  a.emit(OP_CONST, 1);
+  a.emit(OP_ADD);
+  a.emit(OP_STORE4);
+  a.patch(toCond, a.here());
+  a.emit(OP_LOCAL, 12);
+  a.emit(OP_LOAD4);
+  a.emit(OP_LOCAL, 32);
+  a.emit(OP_LOAD4);
+  a.emit(OP_LTI, body);
+  a.emit(OP_LOCAL, 16);
+  a.emit(OP_LOAD4);
+  a.emit(OP_LEAVE, 24);
+  a.patch(toF, a.here());
+  a.emit(OP_ENTER, 8);
+  a.emit(OP_LOCAL, 16);
+  a.emit(OP_LOAD4);
+  a.emit(OP_CONST, 1);
+  a.emit(OP_LSH);
+  a.emit(OP_LEAVE, 8);
+  return a.code();
+}
+
+class HudFixture : public benchmark::Fixture
+{
+public:
+  void SetUp(benchmark::State const&) override
+  {
+    // fixtures outlive the benchmarks, so the mock can't be a plain member
+    mock_       = std::make_unique<testing::NiceMock<SyscallsMock>>();
+    cvarFake_   = std::make_unique<SyscallsCvarFake>();
+    clientFake_ = std::make_unique<SyscallsClientFake>();
+    mock_->delegateTo(*cvarFake_);
+    mock_->delegateTo(*clientFake_);
+
+    cgs.screenWidth  = 640;
+    cgs.screenHeight = 480;
+    cgs.screenXScale = 1;
+    cg.refdef.fov_x  = DEG2RAD(120.f);
+    cg.refdef.fov_y  = DEG2RAD(90.f);
+  }
+
+  void TearDown(benchmark::State const&) override
+  {
+    clientFake_.reset();
+    cvarFake_.reset();
+    mock_.reset();
+  }
+
+private:
+  std::unique_ptr<testing::NiceMock<SyscallsMock>> mock_;
+  std::unique_ptr<SyscallsCvarFake>                cvarFake_;
+  std::unique_ptr<SyscallsClientFake>              clientFake_;
+};
+} // namespace
+
+static void BM_VM_Run_Loop(benchmark::State& state)
+{
+  SyntheticVm        vm(loopProgram(), state.range(1) != 0);
+  std::int32_t const n = static_cast<std::int32_t>(state.range(0));
+  if (vm.exec(n) != n * (n - 1) / 2) state.SkipWithError("wrong result");
+  for (auto _ : state) benchmark::DoNotOptimize(vm.exec(n));
+  state.SetItemsProcessed(state.iterations() * n);
+  state.counters["instructions"] =
+    benchmark::Counter(static_cast<double>(vm.instructions()), benchmark::Counter::kIsRate);
+}
+BENCHMARK(BM_VM_Run_Loop)->ArgNames({"n", "tos"})->Args({1000, 0})->Args({1000, 1});
+
+static void BM_VM_Run_Call(benchmark::State& state)
+{
+  SyntheticVm        vm(callProgram(), state.range(1) != 0);
+  std::int32_t const n = static_cast<std::int32_t>(state.range(0));
+  if (vm.exec(n) != n * (n - 1)) state.SkipWithError("wrong result");
+  for (auto _ : state) benchmark::DoNotOptimize(vm.exec(n));
+  state.SetItemsProcessed(state.iterations() * n);
+  state.counters["instructions"] =
+    benchmark::Counter(static_cast<double>(vm.instructions()), benchmark::Counter::kIsRate);
+}
+BENCHMARK(BM_VM_Run_Call)->ArgNames({"n", "tos"})->Args({1000, 0})->Args({1000, 1});
+
+// Argument is the acceleration in 1/100 ups per frame.
+static void BM_update_snap_zones(benchmark::State& state)
+{
+  float const a = static_cast<float>(state.range(0)) / 100;
+  snapZones_t z;
+  for (auto _ : state)
+  {
+    update_snap_zones(&z, a);
+    benchmark::DoNotOptimize(z);
+  }
+}
+BENCHMARK(BM_update_snap_zones)->Arg(256)->Arg(1024)->Arg(2560)->Arg(5000);
+
+// Switching between ground, air, CPM and haste.
+static void BM_snap_zones(benchmark::State& state)
+{
+  float const a[] = { 25.6f, 2.56f, 38.4f, 33.28f };
+  std::size_t i   = 0;
+  for (auto _ : state)
+  {
+    benchmark::DoNotOptimize(snap_zones(a[i]));
+    i = (i + 1) % 4;
+  }
+}
+BENCHMARK(BM_snap_zones);
+
+// Argument is the horizontal speed.
+static void BM_update_cgaz_zones(benchmark::State& state)
+{
+  float const vf = static_cast<float>(state.range(0));
+  float const v  = vf + 1;
+  cgazZones_t z;
+  for (auto _ : state)
+  {
+    update_cgaz_zones(&z, v * v, vf * vf, 320, 2.56f, 0);
+    benchmark::DoNotOptimize(z);
+  }
+}
+BENCHMARK(BM_update_cgaz_zones)->Arg(320)->Arg(600)->Arg(1200)->Arg(5000);
+
+BENCHMARK_F(HudFixture, BM_CG_FillAngleYaw)(benchmark::State& state)
+{
+  vec4_t const color = { 1, 1, 1, 1 };
+  float        yaw   = 0;
+  for (auto _ : state)
+  {
+    CG_FillAngleYaw(-.5f, .5f, yaw, 180, 8, color);
+    yaw = AngleNormalizePI(yaw + .01f);
+  }
+}
+
+static void BM_ParseVec(benchmark::State& state)
+{
+  vec4_t vec;
+  for (auto _ : state)
+  {
+    ParseVec(".05 .5 .25 1", vec, 4);
+    benchmark::DoNotOptimize(vec);
+  }
+}
+BENCHMARK(BM_ParseVec);
+
+static void BM_BG_EvaluateTrajectory(benchmark::State& state)
+{
+  trajectory_t tr = {};
+  tr.trType       = TR_GRAVITY;
+  VectorSet(tr.trBase, 0, 0, 64);
+  VectorSet(tr.trDelta, 700, 0, 200);
+  vec3_t       result;
+  std::int32_t atTime = 0;
+  for (auto _ : state)
+  {
+    BG_EvaluateTrajectory(&tr, atTime, result);
+    benchmark::DoNotOptimize(result);
+    atTime = (atTime + 8) & 4095;
+  }
+}
+BENCHMARK(BM_BG_EvaluateTrajectory);
+
+BENCHMARK_MAIN();
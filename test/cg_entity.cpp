@@ -0,0 +1,208 @@
+#include "syscalls_client_fake.hpp"
+#include "syscalls_cvar_fake.hpp"
+#include "syscalls_mock.hpp"
+
+extern "C"
+{
+#include <bg_public.h>
+#include <cg_entity.h>
+#include <cg_local.h>
+}
+
+#include <vector>
+
+namespace
+{
+entityState_t& addEntity(
+  snapshot_t&  snap,
+  std::int32_t number,
+  std::int32_t eType,
+  std::int32_t weapon,
+  std::int32_t clientNum)
+{
+  auto& entity     = snap.entities[snap.numEntities++];
+  entity           = {};
+  entity.number    = number;
+  entity.eType     = eType;
+  entity.weapon    = weapon;
+  entity.clientNum = clientNum;
+  return entity;
+}
+} // namespace
+
+TEST(EntityIndex, Lists)
+{
+  testing::NiceMock<SyscallsMock> mock;
+  SyscallsCvarFake                cvarFake;
+  SyscallsClientFake              clientFake;
+  mock.delegateTo(cvarFake);
+  mock.delegateTo(clientFake);
+
+  auto& snap        = clientFake.getSnapshot();
+  snap.serverTime   = 1000;
+  snap.ps.clientNum = 3;
+  addEntity(snap, 64, ET_MISSILE, WP_GRENADE_LAUNCHER, 3);
+  addEntity(snap, 65, ET_MISSILE, WP_ROCKET_LAUNCHER, 3);
+  addEntity(snap, 66, ET_MISSILE, WP_GRENADE_LAUNCHER, 4);
+  addEntity(snap, 4, ET_PLAYER, WP_ROCKET_LAUNCHER, 4);
+
+  init_entityStates();
+  ASSERT_EQ(own_grenades()->count, 1);
+  EXPECT_EQ(own_grenades()->entities[0]->number, 64);
+  ASSERT_EQ(own_rockets()->count, 1);
+  EXPECT_EQ(own_rockets()->entities[0]->number, 65);
+  EXPECT_EQ(all_missiles()->count, 3);
+
+  ASSERT_TRUE(entity_by_number(66));
+  EXPECT_EQ(entity_by_number(66)->clientNum, 4);
+  EXPECT_FALSE(entity_by_number(5));
+}
+
+TEST(EntityIndex, RebuiltOnNewSnapshot)
+{
+  testing::NiceMock<SyscallsMock> mock;
+  SyscallsCvarFake                cvarFake;
+  SyscallsClientFake              clientFake;
+  mock.delegateTo(cvarFake);
+  mock.delegateTo(clientFake);
+
+  auto& snap      = clientFake.getSnapshot();
+  snap.serverTime = 2000;
+  addEntity(snap, 64, ET_MISSILE, WP_GRENADE_LAUNCHER, 0);
+
+  init_entityStates();
+  EXPECT_TRUE(entity_by_number(64));
+
+  // same snapshot, the index is not rebuilt
+  snap.numEntities = 0;
+  EXPECT_TRUE(entity_by_number(64));
+
+  snap.serverTime = 2008;
+  EXPECT_FALSE(entity_by_number(64));
+  EXPECT_EQ(own_grenades()->count, 0);
+}
+
+namespace
+{
+std::vector<entityEvent_t> events;
+
+void recordEvent(entityEvent_t const* event)
+{
+  events.push_back(*event);
+}
+} // namespace
+
+TEST(EntityEvents, Lifecycle)
+{
+  testing::NiceMock<SyscallsMock> mock;
+  SyscallsCvarFake                cvarFake;
+  SyscallsClientFake              clientFake;
+  mock.delegateTo(cvarFake);
+  mock.delegateTo(clientFake);
+
+  init_entityStates();
+  subscribe_entityEvents(&recordEvent);
+  events.clear();
+
+  auto& snap      = clientFake.getSnapshot();
+  snap.serverTime = 3000;
+  addEntity(snap, 64, ET_MISSILE, WP_GRENADE_LAUNCHER, 0);
+  addEntity(snap, 65, ET_MISSILE, WP_GRENADE_LAUNCHER, 0);
+  update_entityStates();
+  ASSERT_EQ(events.size(), 2u);
+  EXPECT_EQ(events[0].type, ENTITY_SPAWNED);
+  EXPECT_EQ(ENTITY_HANDLE_NUMBER(events[0].handle), 64);
+  EXPECT_EQ(events[0].serverTime, 3000);
+  EXPECT_EQ(events[1].type, ENTITY_SPAWNED);
+  entityHandle_t const handle = entity_handle(64);
+
+  // unchanged entities don't emit events
+  events.clear();
+  snap.serverTime            = 3008;
+  snap.entities[1].pos.trTime = 3008;
+  update_entityStates();
+  ASSERT_EQ(events.size(), 1u);
+  EXPECT_EQ(events[0].type, ENTITY_CHANGED);
+  EXPECT_EQ(ENTITY_HANDLE_NUMBER(events[0].handle), 65);
+
+  events.clear();
+  snap.serverTime  = 3016;
+  snap.numEntities = 1;
+  update_entityStates();
+  ASSERT_EQ(events.size(), 1u);
+  EXPECT_EQ(events[0].type, ENTITY_REMOVED);
+  EXPECT_EQ(ENTITY_HANDLE_NUMBER(events[0].handle), 65);
+  EXPECT_EQ(events[0].state->pos.trTime, 3008);
+
+  // a respawned entity number gets a new handle
+  events.clear();
+  snap.serverTime  = 3024;
+  snap.numEntities = 0;
+  update_entityStates();
+  snap.serverTime = 3032;
+  addEntity(snap, 64, ET_MISSILE, WP_GRENADE_LAUNCHER, 0);
+  update_entityStates();
+  ASSERT_EQ(events.size(), 2u);
+  EXPECT_EQ(events[0].type, ENTITY_REMOVED);
+  EXPECT_EQ(events[0].handle, handle);
+  EXPECT_EQ(events[1].type, ENTITY_SPAWNED);
+  EXPECT_NE(events[1].handle, handle);
+  EXPECT_EQ(ENTITY_HANDLE_NUMBER(events[1].handle), 64);
+}
+
+TEST(EntityEvents, UnsubscribedOnShutdown)
+{
+  testing::NiceMock<SyscallsMock> mock;
+  SyscallsCvarFake                cvarFake;
+  SyscallsClientFake              clientFake;
+  mock.delegateTo(cvarFake);
+  mock.delegateTo(clientFake);
+
+  init_entityStates();
+  subscribe_entityEvents(&recordEvent);
+  del_entityStates();
+  events.clear();
+
+  auto& snap      = clientFake.getSnapshot();
+  snap.serverTime = 3500;
+  addEntity(snap, 64, ET_MISSILE, WP_GRENADE_LAUNCHER, 0);
+  update_entityStates();
+  EXPECT_TRUE(events.empty());
+}
+
+TEST(EntityOwners, FilterSound)
+{
+  testing::NiceMock<SyscallsMock> mock;
+  SyscallsCvarFake                cvarFake;
+  SyscallsClientFake              clientFake;
+  mock.delegateTo(cvarFake);
+  mock.delegateTo(clientFake);
+
+  init_entityStates();
+  trap_Cvar_Set("mdd_sound_local_only", "1");
+
+  auto& snap        = clientFake.getSnapshot();
+  snap.serverTime   = 4000;
+  snap.ps.clientNum = 0;
+  addEntity(snap, 64, ET_MISSILE, WP_ROCKET_LAUNCHER, 0);
+  addEntity(snap, 65, ET_MISSILE, WP_ROCKET_LAUNCHER, 1);
+  update_entityStates();
+  EXPECT_EQ(should_filter_sound(64, 0), 0);
+  EXPECT_EQ(should_filter_sound(65, 0), 1);
+  EXPECT_EQ(should_filter_sound(66, 0), 0); // never seen
+  EXPECT_EQ(should_filter_sound(ENTITYNUM_WORLD, 0), 1);
+  EXPECT_EQ(should_filter_sound(ENTITYNUM_WORLD, 1), 0);
+
+  // the last seen owner is kept after the entity left the snapshot
+  snap.serverTime  = 4008;
+  snap.numEntities = 0;
+  update_entityStates();
+  EXPECT_EQ(should_filter_sound(65, 0), 1);
+
+  // owners are only looked up once per snapshot
+  snap.serverTime = 4016;
+  addEntity(snap, 66, ET_MISSILE, WP_ROCKET_LAUNCHER, 1);
+  EXPECT_EQ(should_filter_sound(66, 0), 0);
+  update_entityStates();
+  EXPECT_EQ(should_filter_sound(66, 0), 1);
+}
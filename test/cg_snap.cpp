@@ -0,0 +1,138 @@
+#include <gtest/gtest.h>
+
+extern "C"
+{
+#include <cg_snap.h>
+}
+
+#include <algorithm>
+#include <cmath>
+#include <set>
+#include <vector>
+
+namespace
+{
+double const pi = 3.14159265358979323846;
+
+// Every acceleration from air strafing to CPM with haste.
+std::vector<float> accelerations()
+{
+  std::vector<float> a;
+  for (int i = 3; i <= 200; ++i) a.push_back(static_cast<float>(i) / 4);
+  return a;
+}
+
+void expectSame(snapZones_t const& z, snapZones_t const& expected, float a)
+{
+  ASSERT_EQ(z.maxAccel, expected.maxAccel) << a;
+  for (int i = 0; i <= 2 * z.maxAccel; ++i)
+  {
+    EXPECT_EQ(z.zones[i], expected.zones[i]) << a << " zone " << i;
+    EXPECT_EQ(z.xAccel[i], expected.xAccel[i]) << a << " zone " << i;
+    EXPECT_EQ(z.yAccel[i], expected.yAccel[i]) << a << " zone " << i;
+    EXPECT_EQ(z.absAccel[i], expected.absAccel[i]) << a << " zone " << i;
+  }
+  EXPECT_EQ(z.minAbsAccel, expected.minAbsAccel) << a;
+  EXPECT_EQ(z.maxAbsAccel, expected.maxAbsAccel) << a;
+}
+
+void expectSame(snapZones_t const& z, float a)
+{
+  snapZones_t expected;
+  update_snap_zones(&expected, a);
+  expectSame(z, expected, a);
+}
+} // namespace
+
+TEST(SnapZones, SpanTheQuadrant)
+{
+  for (float const a : accelerations())
+  {
+    snapZones_t z;
+    update_snap_zones(&z, a);
+    int const n = 2 * z.maxAccel;
+    ASSERT_EQ(z.maxAccel, std::lround(a));
+    for (int i = 0; i < n; ++i) EXPECT_LE(z.zones[i], z.zones[i + 1]) << a;
+    EXPECT_GE(z.zones[0], 0) << a;
+    EXPECT_LE(z.zones[n - 1], static_cast<float>(pi / 2)) << a;
+    EXPECT_NEAR(z.zones[n] - z.zones[0], pi / 2, 1e-6) << a;
+  }
+}
+
+TEST(SnapZones, EdgesWhereTheAccelRounds)
+{
+  for (float const a : accelerations())
+  {
+    snapZones_t z;
+    update_snap_zones(&z, a);
+
+    // the x accel rounds differently at acos((i + .5) / a), the y accel at asin((i + .5) / a)
+    std::vector<double> edges;
+    for (int i = 0; i < z.maxAccel; ++i)
+    {
+      edges.push_back(std::acos((i + .5) / a));
+      edges.push_back(std::asin((i + .5) / a));
+    }
+    std::sort(edges.begin(), edges.end());
+    for (int i = 0; i < 2 * z.maxAccel; ++i) EXPECT_NEAR(z.zones[i], edges[i], 1e-6) << a << " edge " << i;
+  }
+}
+
+TEST(SnapZones, AccelOfEachZone)
+{
+  for (float const a : accelerations())
+  {
+    snapZones_t z;
+    update_snap_zones(&z, a);
+    float minAbsAccel = 2 * a;
+    float maxAbsAccel = 0;
+    for (int i = 0; i < 2 * z.maxAccel; ++i)
+    {
+      minAbsAccel = std::min(minAbsAccel, z.absAccel[i + 1]);
+      maxAbsAccel = std::max(maxAbsAccel, z.absAccel[i + 1]);
+      if (z.zones[i + 1] - z.zones[i] < 1e-5f) continue; // both components round at once
+
+      double const yaw = (z.zones[i] + z.zones[i + 1]) / 2.;
+      EXPECT_EQ(z.xAccel[i + 1], std::lround(a * std::cos(yaw))) << a << " zone " << i + 1;
+      EXPECT_EQ(z.yAccel[i + 1], std::lround(a * std::sin(yaw))) << a << " zone " << i + 1;
+      EXPECT_FLOAT_EQ(z.absAccel[i + 1], std::hypot(z.xAccel[i + 1], z.yAccel[i + 1])) << a << " zone " << i + 1;
+    }
+    EXPECT_EQ(z.minAbsAccel, minAbsAccel) << a;
+    EXPECT_EQ(z.maxAbsAccel, maxAbsAccel) << a;
+  }
+}
+
+TEST(SnapZonesCache, SameAsUpdated)
+{
+  for (float const a : accelerations())
+  {
+    auto const* const z = snap_zones(a);
+    expectSame(*z, a);
+    EXPECT_EQ(snap_zones(a), z) << a; // a hit returns the same slot
+  }
+}
+
+TEST(SnapZonesCache, ReplacesTheOldest)
+{
+  // none of them are accelerations() so the cache starts without them, whatever ran before
+  std::vector<float> a;
+  for (int i = 0; i <= SNAP_ZONES_CACHED; ++i) a.push_back(30.1f + static_cast<float>(i) / 8);
+
+  std::vector<snapZones_t const*> z;
+  for (int i = 0; i < SNAP_ZONES_CACHED; ++i) z.push_back(snap_zones(a[i]));
+  EXPECT_EQ(std::set<snapZones_t const*>(z.cbegin(), z.cend()).size(), SNAP_ZONES_CACHED);
+  for (int i = 0; i < SNAP_ZONES_CACHED; ++i) EXPECT_EQ(snap_zones(a[i]), z[i]) << a[i];
+
+  // one more replaces the first, hits don't make the others any younger
+  EXPECT_EQ(snap_zones(a[SNAP_ZONES_CACHED]), z[0]);
+  expectSame(*z[0], a[SNAP_ZONES_CACHED]);
+  for (int i = 1; i < SNAP_ZONES_CACHED; ++i)
+  {
+    EXPECT_EQ(snap_zones(a[i]), z[i]) << a[i];
+    expectSame(*z[i], a[i]);
+  }
+
+  // and the first comes back in place of the second
+  EXPECT_EQ(snap_zones(a[0]), z[1]);
+  expectSame(*z[1], a[0]);
+}
@@ -0,0 +1,207 @@
+// Headless harness: loads a real cgame.qvm through the proxymod, fed by a fake engine, and reports how long the frames
+// take, how many VM instructions they execute and which syscalls they make.
+//
+// usage: Harness <basepath> [--frames N] [--msec N] [--cs index=value]... [--verbose]
+//        Harness --replay <file> [--verbose]
+//
+// <basepath> is the directory vm/cgame.qvm (and anything else the qvm opens) is read from, e.g. an extracted
+// defrag/zz-defrag.pk3. A replay instead re-runs a session recorded with mdd_record (see syscall_log.h), answering
+// every syscall from the log.
+#include "harness_engine.hpp"
+#include "harness_replay.hpp"
+
+extern "C"
+{
+#include <cg_main.h>
+#include <cg_syscall.h>
+#include <cg_vm.h>
+#include <timing.h>
+}
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace
+{
+// Times the frames and splits the syscall counts and the executed instructions into init and frames.
+class Session
+{
+public:
+  explicit Session(Engine& engine) : syscallCounts_(engine.callCounts())
+  {
+    vm_count_instructions = qtrue;
+  }
+
+  void Call(std::int32_t cmd, std::int32_t arg0 = 0, std::int32_t arg1 = 0, std::int32_t arg2 = 0)
+  {
+    if (cmd == CG_DRAW_ACTIVE_FRAME && latencies_.empty())
+    {
+      initSyscalls_ = syscallCounts_;
+      syscallCounts_.clear();
+      initInstructions_ = g_VM.instructionsExecuted;
+    }
+
+    std::uint64_t const start = time_ns();
+    vmMain(cmd, arg0, arg1, arg2, 0, 0, 0, 0, 0, 0, 0, 0, 0);
+    std::uint64_t const elapsed = time_ns() - start;
+
+    if (cmd == CG_INIT) initTime_ += elapsed;
+    if (cmd == CG_DRAW_ACTIVE_FRAME)
+    {
+      latencies_.push_back(elapsed);
+      instructions_ = g_VM.instructionsExecuted - initInstructions_;
+    }
+  }
+
+  int Report()
+  {
+    if (latencies_.empty())
+    {
+      std::fprintf(stderr, "Harness: no frames were run\n");
+      return EXIT_FAILURE;
+    }
+
+    auto const    frames = static_cast<double>(latencies_.size());
+    std::uint64_t total  = 0;
+    for (auto const latency : latencies_) total += latency;
+    std::sort(latencies_.begin(), latencies_.end());
+
+    std::printf(
+      "init:         %.3f ms, %" PRIu64 " instructions\n", static_cast<double>(initTime_) / 1e6, initInstructions_);
+    std::printf("frames:       %zu, %.3f ms total\n", latencies_.size(), static_cast<double>(total) / 1e6);
+    std::printf(
+      "latency (us): p50 %.1f, p90 %.1f, p99 %.1f, p99.9 %.1f, max %.1f\n",
+      Percentile(.5),
+      Percentile(.9),
+      Percentile(.99),
+      Percentile(.999),
+      static_cast<double>(latencies_.back()) / 1000.);
+    std::printf(
+      "instructions: %" PRIu64 " total, %.0f per frame\n", instructions_, static_cast<double>(instructions_) / frames);
+
+    std::vector<std::pair<std::intptr_t, std::uint64_t>> counts(syscallCounts_.begin(), syscallCounts_.end());
+    std::sort(counts.begin(), counts.end(), [](auto const& a, auto const& b) { return a.second > b.second; });
+    std::printf("syscalls per frame (init):\n");
+    for (auto const& [cmd, count] : counts)
+    {
+      auto const          it   = initSyscalls_.find(cmd);
+      std::uint64_t const init = it == initSyscalls_.end() ? 0 : it->second;
+      std::printf("  %-32s %10.2f (%" PRIu64 ")\n", syscall_name(cmd), static_cast<double>(count) / frames, init);
+    }
+    for (auto const& [cmd, count] : initSyscalls_)
+    {
+      if (!syscallCounts_.count(cmd)) std::printf("  %-32s %10.2f (%" PRIu64 ")\n", syscall_name(cmd), 0., count);
+    }
+    return EXIT_SUCCESS;
+  }
+
+private:
+  double Percentile(double p) const
+  {
+    auto const i = static_cast<std::size_t>(p * static_cast<double>(latencies_.size() - 1) + .5);
+    return static_cast<double>(latencies_[i]) / 1000.;
+  }
+
+  std::map<std::intptr_t, std::uint64_t>& syscallCounts_;
+  std::vector<std::uint64_t>             latencies_;
+  std::map<std::intptr_t, std::uint64_t> initSyscalls_;
+  std::uint64_t                          initTime_         = 0;
+  std::uint64_t                          initInstructions_ = 0;
+  std::uint64_t                          instructions_     = 0;
+};
+
+int usage()
+{
+  std::fprintf(
+    stderr,
+    "usage: Harness <basepath> [--frames N] [--msec N] [--cs index=value]... [--verbose]\n"
+    "       Harness --replay <file> [--verbose]\n");
+  return EXIT_FAILURE;
+}
+
+int replay(int argc, char** argv)
+{
+  if (argc < 3) return usage();
+
+  ReplayEngine log(argv[2]);
+  if (!log.Valid())
+  {
+    std::fprintf(stderr, "Harness: %s is not a syscall log\n", argv[2]);
+    return EXIT_FAILURE;
+  }
+  for (int i = 3; i < argc; ++i)
+  {
+    if (std::strcmp(argv[i], "--verbose")) return usage();
+    log.verbose = true;
+  }
+
+  Session      session(log);
+  std::int32_t cmd;
+  std::int32_t args[3];
+  while (log.NextCall(cmd, args)) session.Call(cmd, args[0], args[1], args[2]);
+
+  if (!log.Done())
+  {
+    std::fprintf(stderr, "Harness: replay diverged from the log\n");
+    return EXIT_FAILURE;
+  }
+  return session.Report();
+}
+} // namespace
+
+int main(int argc, char** argv)
+{
+  if (argc < 2) return usage();
+  if (!std::strcmp(argv[1], "--replay")) return replay(argc, argv);
+
+  FakeEngine fake(argv[1]);
+
+  std::int32_t frames = 5000;
+  std::int32_t msec   = 8;
+  for (int i = 2; i < argc; ++i)
+  {
+    if (!std::strcmp(argv[i], "--frames") && i + 1 < argc)
+    {
+      frames = std::max(1, std::atoi(argv[++i]));
+    }
+    else if (!std::strcmp(argv[i], "--msec") && i + 1 < argc)
+    {
+      msec = std::max(1, std::atoi(argv[++i]));
+    }
+    else if (!std::strcmp(argv[i], "--cs") && i + 1 < argc)
+    {
+      char const* const value = std::strchr(argv[++i], '=');
+      if (!value) return usage();
+      fake.SetConfigString(std::atoi(argv[i]), value + 1);
+    }
+    else if (!std::strcmp(argv[i], "--verbose"))
+    {
+      fake.verbose = true;
+    }
+    else
+    {
+      return usage();
+    }
+  }
+
+  Session session(fake);
+  session.Call(CG_INIT, 0, 0, 0);
+  if (!g_VM.codeSegment)
+  {
+    std::fprintf(stderr, "Harness: no VM loaded from %s\n", argv[1]);
+    return EXIT_FAILURE;
+  }
+  for (std::int32_t i = 0; i < frames; ++i)
+  {
+    session.Call(CG_DRAW_ACTIVE_FRAME, fake.Frame(msec), 0 /* STEREO_CENTER */, qfalse);
+  }
+  session.Call(CG_SHUTDOWN);
+
+  return session.Report();
+}
@@ -0,0 +1,449 @@
+#include "harness_engine.hpp"
+
+extern "C"
+{
+#include <bg_public.h>
+#include <surfaceflags.h>
+}
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <utility>
+
+namespace
+{
+constexpr std::int32_t kServerInfo   = 0;   // CS_SERVERINFO
+constexpr std::int32_t kSystemInfo   = 1;   // CS_SYSTEMINFO
+constexpr std::int32_t kPlayers      = 544; // CS_PLAYERS
+constexpr std::int32_t kMaxClients   = 64;  // MAX_CLIENTS
+constexpr std::int32_t kPacketBackup = 32;
+
+constexpr std::int32_t kStartTime    = 1000;
+constexpr std::int32_t kSnapshotMsec = 8;
+constexpr std::int32_t kGrenadeMsec  = 2500;
+constexpr std::int32_t kRocketMsec   = 2000;
+
+// radius and angular speed of the circle the player strafes along
+constexpr float kRadius = 600.f;
+constexpr float kOmega  = 1.f;
+
+template <typename T>
+T* ptr(std::intptr_t x)
+{
+  return reinterpret_cast<T*>(x);
+}
+
+std::int32_t arg(std::intptr_t x)
+{
+  return static_cast<std::int32_t>(x);
+}
+
+void copyString(char* buffer, std::int32_t bufsize, std::string const& value)
+{
+  if (bufsize <= 0) return;
+  auto const len = std::min(value.size(), static_cast<std::size_t>(bufsize - 1));
+  std::memcpy(buffer, value.data(), len);
+  buffer[len] = '\0';
+}
+
+void playerOrigin(std::int32_t time, vec3_t origin)
+{
+  float const t = kOmega * static_cast<float>(time) / 1000.f;
+  origin[0]     = kRadius * std::cos(t);
+  origin[1]     = kRadius * std::sin(t);
+  origin[2]     = 24.f;
+}
+
+void playerVelocity(std::int32_t time, vec3_t velocity)
+{
+  float const t = kOmega * static_cast<float>(time) / 1000.f;
+  velocity[0]   = -kRadius * kOmega * std::sin(t);
+  velocity[1]   = kRadius * kOmega * std::cos(t);
+  velocity[2]   = 0.f;
+}
+
+float playerYaw(std::int32_t time)
+{
+  float const t = kOmega * static_cast<float>(time) / 1000.f;
+  return t * 180.f / static_cast<float>(M_PI) + 90.f + 20.f; // heading plus a strafe angle
+}
+} // namespace
+
+FakeEngine::FakeEngine(std::string basepath) : basepath_(std::move(basepath)), client_(false), time_(kStartTime)
+{
+  configStrings_[kServerInfo] =
+    "\\g_gametype\\0\\mapname\\harness\\sv_hostname\\harness\\sv_fps\\125\\df_promode\\0\\defrag_gametype\\0";
+  configStrings_[kSystemInfo]         = "\\sv_serverid\\1\\sv_pure\\0";
+  configStrings_[CS_LEVEL_START_TIME] = std::to_string(kStartTime);
+  configStrings_[CS_MODELS + 1]       = "maps/harness.bsp";
+  configStrings_[kPlayers]            = "n\\harness\\t\\0\\model\\sarge\\hmodel\\sarge";
+
+  cvars_.Cvar_Register(nullptr, "fs_game", "defrag", 0);
+  cvars_.Cvar_Register(nullptr, "com_maxfps", "125", 0);
+
+  Snapshot(kStartTime, &client_.getSnapshot(0));
+}
+
+FakeEngine::~FakeEngine()
+{
+  for (auto* file : files_)
+  {
+    if (file) std::fclose(file);
+  }
+}
+
+void FakeEngine::SetConfigString(std::int32_t index, std::string value)
+{
+  configStrings_[index] = std::move(value);
+}
+
+std::int32_t FakeEngine::Frame(std::int32_t msec)
+{
+  time_ += msec;
+  ++frames_;
+  for (auto const latest = (time_ - kStartTime) / kSnapshotMsec; client_.snapshotNumber_ < latest;)
+  {
+    auto const number = ++client_.snapshotNumber_;
+    Snapshot(kStartTime + number * kSnapshotMsec, &client_.getSnapshot(number));
+  }
+  return time_ - kSnapshotMsec; // interpolate between the two latest snapshots
+}
+
+void FakeEngine::Cvar_Register(vmCvar_t* vmCvar, char const* varName, char const* defaultValue, std::int32_t flags)
+{
+  cvars_.Cvar_Register(vmCvar, varName, defaultValue, flags);
+}
+
+void FakeEngine::Cvar_Update(vmCvar_t* vmCvar)
+{
+  cvars_.Cvar_Update(vmCvar);
+}
+
+void FakeEngine::Cvar_SetSafe(char const* var_name, char const* value)
+{
+  cvars_.Cvar_SetSafe(var_name, value);
+}
+
+void FakeEngine::Cvar_VariableStringBufferSafe(
+  char const*  var_name,
+  char*        buffer,
+  std::int32_t bufsize,
+  std::int32_t flag)
+{
+  cvars_.Cvar_VariableStringBufferSafe(var_name, buffer, bufsize, flag);
+}
+
+void FakeEngine::CL_GetCurrentSnapshotNumber(std::int32_t* snapshotNumber, std::int32_t* serverTime)
+{
+  client_.CL_GetCurrentSnapshotNumber(snapshotNumber, serverTime);
+}
+
+qboolean FakeEngine::CL_GetSnapshot(std::int32_t snapshotNumber, snapshot_t* snapshot)
+{
+  return client_.CL_GetSnapshot(snapshotNumber, snapshot);
+}
+
+void FakeEngine::R_SetColor(float const* /*rgba*/)
+{
+}
+
+void FakeEngine::R_DrawStretchPic(
+  float /*x*/,
+  float /*y*/,
+  float /*w*/,
+  float /*h*/,
+  float /*s1*/,
+  float /*t1*/,
+  float /*s2*/,
+  float /*t2*/,
+  qhandle_t /*hShader*/)
+{
+}
+
+std::intptr_t FakeEngine::CL_OtherSystemCalls(std::intptr_t cmd, std::intptr_t* args)
+{
+  switch (cmd)
+  {
+  case CG_PRINT:
+    if (verbose) std::fputs(ptr<char const>(args[0]), stdout);
+    return 0;
+  case CG_ERROR:
+    std::fprintf(stderr, "CG_ERROR: %s", ptr<char const>(args[0]));
+    std::exit(EXIT_FAILURE);
+  case CG_MILLISECONDS:
+    return time_;
+
+  case CG_ARGC:
+    return 0;
+  case CG_ARGV:
+    copyString(ptr<char>(args[1]), arg(args[2]), "");
+    return 0;
+  case CG_ARGS:
+    copyString(ptr<char>(args[0]), arg(args[1]), "");
+    return 0;
+
+  case CG_FS_FOPENFILE:
+    return FS_FOpenFile(ptr<char const>(args[0]), ptr<fileHandle_t>(args[1]), static_cast<fsMode_t>(args[2]));
+  case CG_FS_READ:
+    FS_Read(ptr<void>(args[0]), arg(args[1]), arg(args[2]));
+    return 0;
+  case CG_FS_WRITE:
+    FS_Write(ptr<void const>(args[0]), arg(args[1]), arg(args[2]));
+    return 0;
+  case CG_FS_FCLOSEFILE:
+    FS_FCloseFile(arg(args[0]));
+    return 0;
+  case CG_FS_SEEK:
+    return FS_Seek(arg(args[0]), arg(args[1]), arg(args[2]));
+
+  case CG_CM_NUMINLINEMODELS:
+    return 1;
+  case CG_CM_TEMPBOXMODEL:
+  case CG_CM_TEMPCAPSULEMODEL:
+    return 1;
+  case CG_CM_POINTCONTENTS:
+  case CG_CM_TRANSFORMEDPOINTCONTENTS:
+    return ptr<float const>(args[0])[2] < 0.f ? CONTENTS_SOLID : 0;
+  case CG_CM_TRANSFORMEDBOXTRACE:
+  case CG_CM_CAPSULETRACE:
+  case CG_CM_TRANSFORMEDCAPSULETRACE:
+    CM_BoxTrace(
+      ptr<trace_t>(args[0]),
+      ptr<float const>(args[1]),
+      ptr<float const>(args[2]),
+      ptr<float const>(args[3]),
+      ptr<float const>(args[4]),
+      arg(args[5]),
+      arg(args[6]));
+    return 0;
+
+  case CG_R_REGISTERMODEL:
+  case CG_R_REGISTERSKIN:
+  case CG_R_REGISTERSHADER:
+  case CG_R_REGISTERSHADERNOMIP:
+  case CG_S_REGISTERSOUND:
+    return ++handles_;
+  case CG_R_REGISTERFONT:
+    std::memset(ptr<fontInfo_t>(args[2]), 0, sizeof(fontInfo_t));
+    return 0;
+  case CG_R_MODELBOUNDS:
+    VectorSet(ptr<float>(args[1]), -16.f, -16.f, -16.f);
+    VectorSet(ptr<float>(args[2]), 16.f, 16.f, 16.f);
+    return 0;
+  case CG_R_LERPTAG:
+  {
+    // orientation_t: origin followed by the axis
+    auto* const tag = ptr<float>(args[0]);
+    std::memset(tag, 0, 12 * sizeof(float));
+    tag[3] = tag[7] = tag[11] = 1.f;
+    return 1;
+  }
+  case CG_R_INPVS:
+    return qtrue;
+  case CG_GETGLCONFIG:
+  {
+    auto* const glconfig = ptr<glconfig_t>(args[0]);
+    std::memset(glconfig, 0, sizeof(*glconfig));
+    glconfig->vidWidth    = 1920;
+    glconfig->vidHeight   = 1080;
+    glconfig->colorBits   = 32;
+    glconfig->depthBits   = 24;
+    glconfig->stencilBits = 8;
+    return 0;
+  }
+
+  case CG_GETGAMESTATE:
+    CL_GetGameState(ptr<gameState_t>(args[0]));
+    return 0;
+  case CG_GETCURRENTCMDNUMBER:
+    return frames_;
+  case CG_GETUSERCMD:
+  {
+    auto* const usercmd = ptr<usercmd_t>(args[1]);
+    std::memset(usercmd, 0, sizeof(*usercmd));
+    usercmd->serverTime  = time_;
+    usercmd->angles[YAW] = static_cast<std::int32_t>(playerYaw(time_) * 65536 / 360) & 65535; // ANGLE2SHORT
+    usercmd->weapon      = WP_GRENADE_LAUNCHER;
+    usercmd->forwardmove = 127;
+    usercmd->rightmove   = 127;
+    return qtrue;
+  }
+  case CG_REAL_TIME:
+    std::memset(ptr<qtime_t>(args[0]), 0, sizeof(qtime_t));
+    return 0;
+  case CG_SNAPVECTOR:
+  {
+    auto* const v = ptr<float>(args[0]);
+    for (std::int32_t i = 0; i < 3; ++i) v[i] = std::round(v[i]);
+    return 0;
+  }
+  case CG_MEMORY_REMAINING:
+    return 8 << 20;
+  }
+  // everything else is fire and forget (rendering, sound, key catchers, ...) or may fail (qfalse, 0 handles)
+  return 0;
+}
+
+std::int32_t FakeEngine::FS_FOpenFile(char const* qpath, fileHandle_t* f, fsMode_t mode)
+{
+  if (mode != FS_READ)
+  {
+    // writes are discarded, the harness must not touch the installation it reads from
+    if (f)
+    {
+      files_.push_back(nullptr);
+      *f = static_cast<fileHandle_t>(files_.size());
+    }
+    return 0;
+  }
+
+  auto* const file = std::fopen((basepath_ + '/' + qpath).c_str(), "rb");
+  if (!file)
+  {
+    if (f) *f = 0;
+    return -1;
+  }
+  std::fseek(file, 0, SEEK_END);
+  auto const len = static_cast<std::int32_t>(std::ftell(file));
+  std::fseek(file, 0, SEEK_SET);
+  if (!f)
+  {
+    std::fclose(file);
+    return len;
+  }
+  files_.push_back(file);
+  *f = static_cast<fileHandle_t>(files_.size());
+  return len;
+}
+
+void FakeEngine::FS_Read(void* buffer, std::int32_t len, fileHandle_t f)
+{
+  if (f <= 0 || f > static_cast<fileHandle_t>(files_.size()) || !files_[f - 1]) return;
+  auto const read = std::fread(buffer, 1, static_cast<std::size_t>(len), files_[f - 1]);
+  (void)read;
+}
+
+void FakeEngine::FS_Write(void const* /*buffer*/, std::int32_t /*len*/, fileHandle_t /*f*/)
+{
+}
+
+void FakeEngine::FS_FCloseFile(fileHandle_t f)
+{
+  if (f <= 0 || f > static_cast<fileHandle_t>(files_.size())) return;
+  if (files_[f - 1]) std::fclose(files_[f - 1]);
+  files_[f - 1] = nullptr;
+}
+
+std::int32_t FakeEngine::FS_Seek(fileHandle_t f, std::int32_t offset, std::int32_t origin)
+{
+  if (f <= 0 || f > static_cast<fileHandle_t>(files_.size()) || !files_[f - 1]) return -1;
+  int const whence = origin == FS_SEEK_CUR ? SEEK_CUR : origin == FS_SEEK_END ? SEEK_END : SEEK_SET;
+  return std::fseek(files_[f - 1], offset, whence);
+}
+
+void FakeEngine::CM_BoxTrace(
+  trace_t*     results,
+  float const* start,
+  float const* end,
+  float const* mins,
+  float const* /*maxs*/,
+  clipHandle_t /*model*/,
+  std::int32_t brushmask)
+{
+  std::memset(results, 0, sizeof(*results));
+  results->fraction  = 1.f;
+  results->entityNum = ENTITYNUM_NONE;
+  VectorCopy(end, results->endpos);
+  if (!(brushmask & CONTENTS_SOLID)) return;
+
+  float const bottom = mins ? mins[2] : 0.f;
+  float const s      = start[2] + bottom;
+  float const e      = end[2] + bottom;
+  if (s < 0.f)
+  {
+    results->startsolid = qtrue;
+    results->allsolid   = e < 0.f ? qtrue : qfalse;
+    results->fraction   = 0.f;
+    VectorCopy(start, results->endpos);
+  }
+  else if (e < 0.f)
+  {
+    results->fraction = std::max(0.f, (s - .125f) / (s - e)); // SURFACE_CLIP_EPSILON
+    for (std::int32_t i = 0; i < 3; ++i) results->endpos[i] = start[i] + results->fraction * (end[i] - start[i]);
+  }
+  else
+  {
+    return;
+  }
+  VectorSet(results->plane.normal, 0.f, 0.f, 1.f);
+  results->plane.type = 2; // PLANE_Z
+  results->contents   = CONTENTS_SOLID;
+  results->entityNum  = ENTITYNUM_WORLD;
+}
+
+void FakeEngine::CL_GetGameState(gameState_t* gs) const
+{
+  std::memset(gs, 0, sizeof(*gs));
+  gs->dataCount = 1; // leave a 0 at the beginning for uninitialized configstrings
+  for (auto const& [index, value] : configStrings_)
+  {
+    auto const len = static_cast<std::int32_t>(value.size()) + 1;
+    if (index < 0 || index >= MAX_CONFIGSTRINGS || gs->dataCount + len > MAX_GAMESTATE_CHARS) continue;
+    gs->stringOffsets[index] = gs->dataCount;
+    std::memcpy(gs->stringData + gs->dataCount, value.c_str(), static_cast<std::size_t>(len));
+    gs->dataCount += len;
+  }
+}
+
+void FakeEngine::Snapshot(std::int32_t serverTime, snapshot_t* snapshot) const
+{
+  std::memset(snapshot, 0, sizeof(*snapshot));
+  snapshot->serverTime = serverTime;
+
+  auto& ps = snapshot->ps;
+  ps.commandTime        = serverTime;
+  ps.pm_type            = PM_NORMAL;
+  ps.gravity            = DEFAULT_GRAVITY;
+  ps.speed              = 320;
+  ps.groundEntityNum    = ENTITYNUM_WORLD;
+  ps.weapon             = WP_GRENADE_LAUNCHER;
+  ps.clientNum          = 0;
+  ps.stats[STAT_HEALTH] = 100;
+  playerOrigin(serverTime, ps.origin);
+  playerVelocity(serverTime, ps.velocity);
+  ps.viewangles[YAW] = playerYaw(serverTime);
+
+  // own grenade, refired every kGrenadeMsec
+  {
+    auto& es         = snapshot->entities[snapshot->numEntities++];
+    auto const fired = serverTime - serverTime % kGrenadeMsec;
+    es.number        = kMaxClients;
+    es.eType         = ET_MISSILE;
+    es.weapon        = WP_GRENADE_LAUNCHER;
+    es.clientNum     = ps.clientNum;
+    es.pos.trType    = TR_GRAVITY;
+    es.pos.trTime    = fired;
+    playerOrigin(fired, es.pos.trBase);
+    es.pos.trBase[2] += 14.f;
+    playerVelocity(fired, es.pos.trDelta);
+    float const yaw = playerYaw(fired) * static_cast<float>(M_PI) / 180.f;
+    es.pos.trDelta[0] += 700.f * std::cos(yaw);
+    es.pos.trDelta[1] += 700.f * std::sin(yaw);
+    es.pos.trDelta[2] += 200.f;
+  }
+
+  // someone else's rocket, crossing the circle every kRocketMsec
+  {
+    auto& es         = snapshot->entities[snapshot->numEntities++];
+    es.number        = kMaxClients + 1;
+    es.eType         = ET_MISSILE;
+    es.weapon        = WP_ROCKET_LAUNCHER;
+    es.clientNum     = 1;
+    es.pos.trType    = TR_LINEAR;
+    es.pos.trTime    = serverTime - serverTime % kRocketMsec;
+    VectorSet(es.pos.trBase, -kRadius, 0.f, 64.f);
+    VectorSet(es.pos.trDelta, 900.f, 0.f, 0.f);
+  }
+}
@@ -0,0 +1,83 @@
+#ifndef HARNESS_ENGINE_HPP
+#define HARNESS_ENGINE_HPP
+
+#include "syscalls.hpp"
+#include "syscalls_client_fake.hpp"
+#include "syscalls_cvar_fake.hpp"
+
+extern "C"
+{
+#include <cg_local.h>
+}
+
+#include <cstdint>
+#include <cstdio>
+#include <map>
+#include <string>
+#include <vector>
+
+// Headless stand-in for the client, built on the unit tests' fakes: their cvar store and snapshots, plus a file
+// system rooted at a basepath, a flat floor as the world and a canned gamestate with a stream of snapshots of a player
+// strafing over it while firing grenades.
+class FakeEngine : public Syscalls
+{
+public:
+  explicit FakeEngine(std::string basepath);
+  ~FakeEngine() override;
+
+  void Cvar_Register(vmCvar_t* vmCvar, char const* varName, char const* defaultValue, std::int32_t flags) override;
+  void Cvar_Update(vmCvar_t* vmCvar) override;
+  void Cvar_SetSafe(char const* var_name, char const* value) override;
+  void Cvar_VariableStringBufferSafe(char const* var_name, char* buffer, std::int32_t bufsize, std::int32_t flag)
+    override;
+
+  void     CL_GetCurrentSnapshotNumber(std::int32_t* snapshotNumber, std::int32_t* serverTime) override;
+  qboolean CL_GetSnapshot(std::int32_t snapshotNumber, snapshot_t* snapshot) override;
+
+  // The world is a solid floor at z = 0.
+  void CM_BoxTrace(
+    trace_t*     results,
+    float const* start,
+    float const* end,
+    float const* mins,
+    float const* maxs,
+    clipHandle_t model,
+    std::int32_t brushmask) override;
+
+  void R_SetColor(float const* rgba) override;
+  void R_DrawStretchPic(float x, float y, float w, float h, float s1, float t1, float s2, float t2, qhandle_t hShader)
+    override;
+
+  std::intptr_t CL_OtherSystemCalls(std::intptr_t cmd, std::intptr_t* args) override;
+
+  // Overrides (or adds) a configstring of the canned gamestate.
+  void SetConfigString(std::int32_t index, std::string value);
+
+  // Advances the client clock by msec and returns the server time the cgame should render.
+  std::int32_t Frame(std::int32_t msec);
+
+  bool verbose = false;
+
+private:
+  std::int32_t FS_FOpenFile(char const* qpath, fileHandle_t* f, fsMode_t mode);
+  void         FS_Read(void* buffer, std::int32_t len, fileHandle_t f);
+  void         FS_Write(void const* buffer, std::int32_t len, fileHandle_t f);
+  void         FS_FCloseFile(fileHandle_t f);
+  std::int32_t FS_Seek(fileHandle_t f, std::int32_t offset, std::int32_t origin);
+
+  void CL_GetGameState(gameState_t* gs) const;
+  void Snapshot(std::int32_t serverTime, snapshot_t* snapshot) const;
+
+  std::string basepath_;
+
+  SyscallsCvarFake::Impl   cvars_;
+  SyscallsClientFake::Impl client_;
+
+  std::vector<std::FILE*>             files_;
+  std::map<std::int32_t, std::string> configStrings_;
+  std::int32_t                        time_    = 0;
+  std::int32_t                        frames_  = 0;
+  std::int32_t                        handles_ = 0;
+};
+
+#endif // HARNESS_ENGINE_HPP
@@ -0,0 +1,131 @@
+#include "harness_replay.hpp"
+
+extern "C"
+{
+#include <syscall_log.h>
+}
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <utility>
+
+namespace
+{
+std::vector<std::uint8_t> read(char const* path)
+{
+  std::ifstream file(path, std::ios::binary);
+  if (!file) return {};
+  return { std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>() };
+}
+} // namespace
+
+ReplayEngine::ReplayEngine(char const* path) : ReplayEngine(read(path))
+{
+}
+
+ReplayEngine::ReplayEngine(std::vector<std::uint8_t> log) : log_(std::move(log))
+{
+  valid_ = Header();
+}
+
+bool ReplayEngine::Header()
+{
+  return log_.size() - pos_ >= 8 && U32() == SYSCALL_LOG_MAGIC && U32() == SYSCALL_LOG_VERSION;
+}
+
+bool ReplayEngine::Valid() const
+{
+  return valid_;
+}
+
+bool ReplayEngine::Done() const
+{
+  return pos_ == log_.size();
+}
+
+bool ReplayEngine::NextCall(std::int32_t& cmd, std::int32_t (&args)[3])
+{
+  // the next session recorded into the same file
+  if (!Done() && log_[pos_] == (SYSCALL_LOG_MAGIC & 0xff) && !Header()) return false;
+  if (Done() || log_[pos_] != SYSCALL_LOG_CALL) return false;
+  ++pos_;
+  cmd = static_cast<std::int32_t>(Svarint());
+  for (auto& arg : args) arg = static_cast<std::int32_t>(Svarint());
+  return true;
+}
+
+std::intptr_t ReplayEngine::CL_CgameSystemCalls(std::intptr_t cmd, std::intptr_t* args)
+{
+  // the recorder's own lookup happens before recording starts
+  if (cmd == CG_CVAR_VARIABLESTRINGBUFFER && !Q_stricmp(reinterpret_cast<char const*>(args[0]), SYSCALL_LOG_CVAR))
+  {
+    if (args[2] > 0) reinterpret_cast<char*>(args[1])[0] = '\0';
+    return 0;
+  }
+
+  if (Done() || log_[pos_] != cmd) Diverged(cmd);
+  ++pos_;
+  auto const ret = static_cast<std::intptr_t>(Svarint());
+
+  syscallOutput_t outputs[MAX_SYSCALL_OUTPUTS];
+  auto const      n = syscall_outputs(cmd, args, ret, outputs);
+  if (U8() != n) Diverged(cmd);
+  for (std::int32_t i = 0; i < n; ++i)
+  {
+    // a log that doesn't fit the buffers the qvm passed this time must not overflow them
+    auto const len = Varint();
+    if (outputs[i].size < 0 || len > static_cast<std::uint64_t>(outputs[i].size) || len > log_.size() - pos_)
+    {
+      Diverged(cmd);
+    }
+    std::memcpy(outputs[i].data, log_.data() + pos_, static_cast<std::size_t>(len));
+    pos_ += static_cast<std::size_t>(len);
+  }
+
+  if (cmd == CG_PRINT && verbose) std::fputs(reinterpret_cast<char const*>(args[0]), stdout);
+  if (cmd == CG_ERROR)
+  {
+    std::fprintf(stderr, "CG_ERROR: %s", reinterpret_cast<char const*>(args[0]));
+    std::exit(EXIT_FAILURE);
+  }
+  return ret;
+}
+
+void ReplayEngine::Diverged(std::intptr_t cmd) const
+{
+  std::fprintf(stderr, "Harness: replay diverged at offset %zu, syscall %d\n", pos_, static_cast<int>(cmd));
+  std::exit(EXIT_FAILURE);
+}
+
+std::uint8_t ReplayEngine::U8()
+{
+  return pos_ < log_.size() ? log_[pos_++] : 0;
+}
+
+std::uint32_t ReplayEngine::U32()
+{
+  std::uint32_t x = 0;
+  for (std::int32_t i = 0; i < 4; ++i) x |= static_cast<std::uint32_t>(U8()) << (8 * i);
+  return x;
+}
+
+std::uint64_t ReplayEngine::Varint()
+{
+  std::uint64_t x = 0;
+  for (std::int32_t shift = 0; shift < 64; shift += 7)
+  {
+    auto const b = U8();
+    x |= static_cast<std::uint64_t>(b & 0x7f) << shift;
+    if (!(b & 0x80)) break;
+  }
+  return x;
+}
+
+std::int64_t ReplayEngine::Svarint()
+{
+  auto const x = Varint();
+  return static_cast<std::int64_t>(x >> 1) ^ -static_cast<std::int64_t>(x & 1);
+}
@@ -0,0 +1,48 @@
+#ifndef HARNESS_REPLAY_HPP
+#define HARNESS_REPLAY_HPP
+
+#include "syscalls.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Answers the syscalls of a session recorded with mdd_record from the log, and yields the vmMain calls to re-run it.
+// The log holds everything the session read (including the qvm), so no basepath is needed.
+class ReplayEngine : public Engine
+{
+public:
+  explicit ReplayEngine(char const* path);
+
+  // Replays a log already in memory.
+  explicit ReplayEngine(std::vector<std::uint8_t> log);
+
+  std::intptr_t CL_CgameSystemCalls(std::intptr_t cmd, std::intptr_t* args) override;
+
+  bool Valid() const;
+
+  // Next vmMain call of the session, false at the end of the log or when the replay diverged.
+  bool NextCall(std::int32_t& cmd, std::int32_t (&args)[3]);
+
+  // Whether the whole log has been replayed.
+  bool Done() const;
+
+  bool verbose = false;
+
+private:
+  [[noreturn]] void Diverged(std::intptr_t cmd) const;
+
+  // Reads the header a session starts with, false if it isn't one.
+  bool Header();
+
+  std::uint8_t  U8();
+  std::uint32_t U32();
+  std::uint64_t Varint();
+  std::int64_t  Svarint();
+
+  std::vector<std::uint8_t> log_;
+  std::size_t               pos_   = 0;
+  bool                      valid_ = false;
+};
+
+#endif // HARNESS_REPLAY_HPP
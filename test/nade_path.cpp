@@ -0,0 +1,236 @@
+#include "syscalls_mock.hpp"
+
+extern "C"
+{
+#include <bg_public.h>
+#include <cg_local.h>
+#include <nade_path.h>
+}
+
+#include <array>
+#include <cmath>
+#include <vector>
+
+namespace
+{
+#define SURFACE_CLIP_EPSILON .125f
+
+// Convex room of half-spaces, empty where DotProduct(normal, p) >= dist.
+class RoomFake
+{
+public:
+  RoomFake()
+  {
+    addPlane(0, 0, 1, 0);      // floor
+    addPlane(0, 0, -1, -512);  // ceiling
+    addPlane(1, 0, 0, -1024);  // walls
+    addPlane(-1, 0, 0, -1024); //
+    addPlane(0, 1, 0, -1024);  //
+    addPlane(0, -1, 0, -1024); //
+    addPlane(-1 / sqrtf(2), 0, 1 / sqrtf(2), -800 / sqrtf(2)); // ramp
+  }
+
+  void setDefaultActions(SyscallsMock& mock)
+  {
+    ON_CALL(mock, CM_BoxTrace).WillByDefault(testing::Invoke(this, &RoomFake::CM_BoxTrace));
+  }
+
+  void CM_BoxTrace(
+    trace_t*     results,
+    float const* start,
+    float const* end,
+    float const* mins,
+    float const* maxs,
+    clipHandle_t /*model*/,
+    std::int32_t /*brushmask*/)
+  {
+    ++traces_;
+    vec3_t const zero = { 0, 0, 0 };
+    if (!mins) mins = zero;
+    if (!maxs) maxs = zero;
+
+    *results          = {};
+    results->fraction = 1;
+    for (auto const& plane : planes_)
+    {
+      // distance of the corner of the box closest to the plane
+      float offset = 0;
+      for (std::uint8_t i = 0; i < 3; ++i) offset += plane.normal[i] * (plane.normal[i] > 0 ? mins[i] : maxs[i]);
+      float const d1 = DotProduct(plane.normal, start) + offset - plane.dist;
+      float const d2 = DotProduct(plane.normal, end) + offset - plane.dist;
+      if (d1 < 0)
+      {
+        results->startsolid = qtrue;
+        results->fraction   = 0;
+        results->plane      = plane;
+        continue;
+      }
+      if (d2 >= SURFACE_CLIP_EPSILON || d2 >= d1) continue;
+      float const fraction = std::fmax((d1 - SURFACE_CLIP_EPSILON) / (d1 - d2), 0.f);
+      if (fraction < results->fraction)
+      {
+        results->fraction = fraction;
+        results->plane    = plane;
+      }
+    }
+    for (std::uint8_t i = 0; i < 3; ++i) results->endpos[i] = start[i] + results->fraction * (end[i] - start[i]);
+  }
+
+  std::int32_t traces_ = 0;
+
+private:
+  void addPlane(float x, float y, float z, float dist)
+  {
+    cplane_t plane = {};
+    VectorSet(plane.normal, x, y, z);
+    plane.dist = dist;
+    planes_.push_back(plane);
+  }
+
+  std::vector<cplane_t> planes_;
+};
+
+struct NadePath
+{
+  std::vector<std::int32_t>          sampleTimes;
+  std::vector<std::array<float, 3>> sampleOrigins;
+  std::vector<trajectory_t>          bounces;
+
+  static void sample(void* data, std::int32_t time, vec3_t const origin)
+  {
+    auto* const path = static_cast<NadePath*>(data);
+    path->sampleTimes.push_back(time);
+    path->sampleOrigins.push_back({ origin[0], origin[1], origin[2] });
+  }
+
+  static void bounce(void* data, trajectory_t const* pos)
+  {
+    static_cast<NadePath*>(data)->bounces.push_back(*pos);
+  }
+};
+
+// The fixed step integration of draw_nade_path before it took adaptive steps.
+NadePath fixedStepPath(trajectory_t const& pos, std::int32_t end_time, std::int32_t step, std::int32_t sample)
+{
+  NadePath path;
+  trace_t  trace;
+  int      sample_timer = 0;
+  vec3_t   currentOrigin, origin;
+
+  VectorCopy(pos.trBase, currentOrigin);
+
+  trajectory_t local_pos = pos;
+  for (int leveltime = local_pos.trTime + step; leveltime < end_time; leveltime += step)
+  {
+    BG_EvaluateTrajectory(&local_pos, leveltime, origin);
+    trap_CM_BoxTrace(&trace, currentOrigin, origin, nullptr, nullptr, 0, MASK_SHOT);
+    VectorCopy(trace.endpos, currentOrigin);
+
+    sample_timer -= step;
+    if (sample_timer <= 0)
+    {
+      sample_timer = sample;
+      NadePath::sample(&path, leveltime, origin);
+    }
+
+    if (trace.fraction != 1)
+    {
+      vec3_t velocity;
+      int    hitTime = (leveltime - step) + static_cast<int>(step * trace.fraction);
+      BG_EvaluateTrajectoryDelta(&local_pos, hitTime, velocity);
+      float const dot = DotProduct(velocity, trace.plane.normal);
+      VectorMA(velocity, -2 * dot, trace.plane.normal, local_pos.trDelta);
+
+      VectorScale(local_pos.trDelta, .65f, local_pos.trDelta);
+
+      VectorAdd(currentOrigin, trace.plane.normal, currentOrigin);
+      VectorCopy(currentOrigin, local_pos.trBase);
+      local_pos.trTime = leveltime;
+
+      sample_timer = 0;
+      NadePath::bounce(&path, &local_pos);
+    }
+  }
+  return path;
+}
+
+NadePath adaptivePath(trajectory_t const& pos, std::int32_t end_time, std::int32_t step, std::int32_t sample)
+{
+  NadePath                path;
+  nadePathVisitor_t const visitor = { NadePath::sample, NadePath::bounce, &path };
+  trace_nade_path(&pos, end_time, step, sample, &visitor);
+  return path;
+}
+
+trajectory_t grenade(float x, float y, float z, float dx, float dy, float dz)
+{
+  trajectory_t pos = {};
+  pos.trType       = TR_GRAVITY;
+  pos.trTime       = 1000;
+  VectorSet(pos.trBase, x, y, z);
+  VectorSet(pos.trDelta, dx, dy, dz);
+  return pos;
+}
+
+void expectSamePath(NadePath const& expected, NadePath const& actual)
+{
+  ASSERT_EQ(expected.bounces.size(), actual.bounces.size());
+  for (std::size_t i = 0; i < expected.bounces.size(); ++i)
+  {
+    EXPECT_EQ(expected.bounces[i].trTime, actual.bounces[i].trTime);
+    for (std::uint8_t j = 0; j < 3; ++j)
+    {
+      EXPECT_NEAR(expected.bounces[i].trBase[j], actual.bounces[i].trBase[j], .01f);
+      EXPECT_NEAR(expected.bounces[i].trDelta[j], actual.bounces[i].trDelta[j], .01f);
+    }
+  }
+  ASSERT_EQ(expected.sampleTimes, actual.sampleTimes);
+  for (std::size_t i = 0; i < expected.sampleOrigins.size(); ++i)
+  {
+    for (std::uint8_t j = 0; j < 3; ++j) EXPECT_NEAR(expected.sampleOrigins[i][j], actual.sampleOrigins[i][j], .01f);
+  }
+}
+} // namespace
+
+TEST(NadePath, SameBouncesAsFixedStep)
+{
+  testing::NiceMock<SyscallsMock> mock;
+  RoomFake                        room;
+  room.setDefaultActions(mock);
+
+  trajectory_t const grenades[] = {
+    grenade(0, 0, 64, 700, 0, 200),          // ramp
+    grenade(0, 0, 64, -500, 400, 300),       // walls
+    grenade(0, 0, 64, 100, 50, 900),         // ceiling
+    grenade(0, 0, 16, 300, 0, -100),         // skimming the floor
+    grenade(500, 0, 400, 0, 0, 0),           // dropped
+    grenade(-900, -900, 32, -700, -700, 50), // corner
+  };
+  for (auto const& pos : grenades)
+  {
+    for (std::int32_t step : { 8, 16, 32 })
+    {
+      SCOPED_TRACE(step);
+      std::int32_t const end_time = pos.trTime + 2500;
+      NadePath const     expected = fixedStepPath(pos, end_time, step, 4 * step);
+      EXPECT_FALSE(expected.bounces.empty());
+      expectSamePath(expected, adaptivePath(pos, end_time, step, 4 * step));
+    }
+  }
+}
+
+TEST(NadePath, FewerTracesInOpenAir)
+{
+  testing::NiceMock<SyscallsMock> mock;
+  RoomFake                        room;
+  room.setDefaultActions(mock);
+
+  trajectory_t const pos      = grenade(-900, 0, 32, 500, 0, 600);
+  std::int32_t const end_time = pos.trTime + 1500;
+
+  fixedStepPath(pos, end_time, 8, 32);
+  std::int32_t const fixedTraces = room.traces_;
+  room.traces_                   = 0;
+  adaptivePath(pos, end_time, 8, 32);
+  EXPECT_LT(room.traces_ * 4, fixedTraces);
+}
@@ -0,0 +1,98 @@
+#include "syscalls_cvar_fake.hpp"
+#include "syscalls_mock.hpp"
+
+extern "C"
+{
+#include <cg_local.h>
+#include <help.h>
+#include <quality.h>
+}
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace
+{
+class Quality : public testing::Test
+{
+protected:
+  using Changes = std::vector<std::pair<std::int32_t, std::int32_t>>;
+
+  void SetUp() override
+  {
+    mock_.delegateTo(cvarFake_);
+    init_quality();
+    trap_Cvar_Set("mdd_quality_budget", "2");
+  }
+
+  void TearDown() override
+  {
+    del_help();
+  }
+
+  // Runs frames frames costing ms each, returns the (frame, level) pairs where the level changed, counting the frames
+  // from 1.
+  Changes run(std::int32_t frames, float ms)
+  {
+    Changes changes;
+    for (std::int32_t frame = 1; frame <= frames; ++frame)
+    {
+      auto const before = level();
+      quality_measure(static_cast<std::uint64_t>(ms * 1e6f));
+      update_quality();
+      if (level() != before) changes.emplace_back(frame, level());
+    }
+    return changes;
+  }
+
+  static std::int32_t level()
+  {
+    return static_cast<std::int32_t>(quality() - quality_level(0));
+  }
+
+  testing::NiceMock<SyscallsMock> mock_;
+  SyscallsCvarFake                cvarFake_;
+};
+} // namespace
+
+TEST_F(Quality, WithoutBudget)
+{
+  trap_Cvar_Set("mdd_quality_budget", "0");
+  EXPECT_EQ(run(1000, 100), Changes{});
+}
+
+TEST_F(Quality, LowersAfterTheDecreaseHold)
+{
+  // the average of 4 ms frames exceeds the 2 ms budget at the 7th frame, a level lasts at least 15 frames
+  EXPECT_EQ(run(200, 4), (Changes{ { 15, 1 }, { 30, 2 }, { 45, 3 } }));
+}
+
+TEST_F(Quality, RaisesAfterTheIncreaseHold)
+{
+  run(200, 4);
+  // the average drops below half the budget at the 14th free frame, a higher level lasts at least 120 frames
+  EXPECT_EQ(run(500, 0), (Changes{ { 14, 2 }, { 134, 1 }, { 254, 0 } }));
+}
+
+TEST_F(Quality, HoldsBetweenTheThresholds)
+{
+  EXPECT_EQ(run(500, 1.5f), Changes{});
+
+  run(200, 4);
+  EXPECT_EQ(run(500, 1.5f), Changes{});
+}
+
+TEST_F(Quality, ClampsToTheMax)
+{
+  trap_Cvar_Set("mdd_quality_max", "1");
+  EXPECT_EQ(run(200, 4), (Changes{ { 15, 1 } }));
+
+  trap_Cvar_Set("mdd_quality_max", "10");
+  EXPECT_EQ(run(200, 4), (Changes{ { 1, 2 }, { 16, 3 } }));
+
+  trap_Cvar_Set("mdd_quality_max", "-1");
+  EXPECT_EQ(run(1, 4), (Changes{ { 1, 0 } }));
+}
@@ -0,0 +1,194 @@
+#include "harness_replay.hpp"
+#include "syscalls_mock.hpp"
+
+extern "C"
+{
+#include <cg_local.h>
+#include <cg_main.h>
+#include <cg_syscall.h>
+#include <syscall_log.h>
+}
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+using ::testing::_;
+using ::testing::NiceMock;
+using ::testing::StrEq;
+
+namespace
+{
+// What the engine answers while recording.
+struct Answers
+{
+  Answers()
+  {
+    snapshot->ping                  = 7;
+    snapshot->serverTime            = 1000;
+    snapshot->ps.clientNum          = 2;
+    snapshot->numEntities           = 3;
+    snapshot->numServerCommands     = 1;
+    snapshot->serverCommandSequence = 5;
+    for (std::int32_t i = 0; i < snapshot->numEntities; ++i) snapshot->entities[i].number = 64 + i;
+
+    fragments[0] = { 0, 3 };
+    fragments[1] = { 3, 2 };
+    for (std::int32_t i = 0; i < 5; ++i) points[i][0] = points[i][1] = points[i][2] = static_cast<float>(i) / 3;
+  }
+
+  std::unique_ptr<snapshot_t> snapshot = std::make_unique<snapshot_t>();
+  markFragment_t              fragments[2];
+  vec3_t                      points[5];
+};
+
+// An engine whose file system keeps the single file opened (for appending) in memory.
+class RecordingEngine : public NiceMock<SyscallsMock>
+{
+public:
+  explicit RecordingEngine(std::vector<std::uint8_t>& file, Answers const& answers)
+  {
+    ON_CALL(*this, Cvar_VariableStringBufferSafe(StrEq(SYSCALL_LOG_CVAR), _, _, _))
+      .WillByDefault([](char const*, char* buffer, std::int32_t bufsize, std::int32_t) {
+        std::strncpy(buffer, "rec.mddrec", static_cast<std::size_t>(bufsize));
+      });
+    ON_CALL(*this, CL_GetSnapshot(7, _)).WillByDefault([&answers](std::int32_t, snapshot_t* snapshot) {
+      std::memcpy(snapshot, answers.snapshot.get(), sizeof(*snapshot));
+      return qtrue;
+    });
+    ON_CALL(*this, CL_OtherSystemCalls(_, _))
+      .WillByDefault([&file, &answers](std::intptr_t cmd, std::intptr_t* args) -> std::intptr_t {
+        switch (cmd)
+        {
+        case CG_FS_FOPENFILE: *reinterpret_cast<fileHandle_t*>(args[1]) = 1; return 0;
+        case CG_FS_WRITE:
+        {
+          auto const* const data = reinterpret_cast<std::uint8_t const*>(args[0]);
+          file.insert(file.end(), data, data + args[1]);
+          return 0;
+        }
+        case CG_MILLISECONDS: return 1234;
+        case CG_CM_MARKFRAGMENTS:
+          // 2 fragments using 5 points, fewer than there is room for
+          std::memcpy(reinterpret_cast<void*>(args[4]), answers.points, sizeof(answers.points));
+          std::memcpy(reinterpret_cast<void*>(args[6]), answers.fragments, sizeof(answers.fragments));
+          return 2;
+        default: return 0;
+        }
+      });
+  }
+};
+
+// The syscalls of a session, whose results are compared between recording and replaying.
+struct Session
+{
+  void run()
+  {
+    std::memset(snapshot.get(), 0xcd, sizeof(*snapshot));
+    std::memset(fragments, 0xcd, sizeof(fragments));
+    std::memset(pointBuffer, 0xcd, sizeof(pointBuffer));
+
+    milliseconds = trap_Milliseconds();
+    gotSnapshot  = trap_GetSnapshot(7, snapshot.get());
+
+    vec3_t const points[3]  = { { 0, 0, 0 }, { 1, 0, 0 }, { 0, 1, 0 } };
+    vec3_t const projection = { 0, 0, -1 };
+    numFragments            = trap_CM_MarkFragments(3, points, projection, 16, pointBuffer[0], 8, fragments);
+  }
+
+  std::int32_t                milliseconds = 0;
+  qboolean                    gotSnapshot  = qfalse;
+  std::unique_ptr<snapshot_t> snapshot     = std::make_unique<snapshot_t>();
+  std::int32_t                numFragments = 0;
+  markFragment_t              fragments[8];
+  vec3_t                      pointBuffer[16];
+};
+
+// The bytes of the snapshot the engine writes: all but the entities past numEntities.
+void expectSameSnapshot(snapshot_t const& a, snapshot_t const& b)
+{
+  auto const* const pa       = reinterpret_cast<std::uint8_t const*>(&a);
+  auto const* const pb       = reinterpret_cast<std::uint8_t const*>(&b);
+  auto const        entities = offsetof(snapshot_t, entities) + a.numEntities * sizeof(entityState_t);
+  EXPECT_EQ(std::memcmp(pa, pb, entities), 0);
+  auto const commands = offsetof(snapshot_t, numServerCommands);
+  EXPECT_EQ(std::memcmp(pa + commands, pb + commands, sizeof(snapshot_t) - commands), 0);
+}
+
+std::vector<std::uint8_t> header()
+{
+  std::vector<std::uint8_t> log;
+  for (auto const x : { SYSCALL_LOG_MAGIC, SYSCALL_LOG_VERSION })
+  {
+    for (std::int32_t i = 0; i < 4; ++i) log.push_back(static_cast<std::uint8_t>(x >> (8 * i)));
+  }
+  return log;
+}
+} // namespace
+
+TEST(SyscallLog, RecordAndReplay)
+{
+  std::vector<std::uint8_t> file;
+  Answers const             answers;
+  Session                   recorded[2];
+  {
+    RecordingEngine engine(file, answers);
+
+    // two sessions appended to the same file
+    for (auto& session : recorded)
+    {
+      start_syscall_recording();
+      syscall_log_call(CG_DRAW_ACTIVE_FRAME, 1000, 0, 0);
+      session.run();
+      stop_syscall_recording();
+    }
+  }
+  ASSERT_EQ(recorded[0].milliseconds, 1234);
+  ASSERT_EQ(recorded[0].gotSnapshot, qtrue);
+  ASSERT_EQ(recorded[0].numFragments, 2);
+
+  ReplayEngine engine(file);
+  ASSERT_TRUE(engine.Valid());
+  for (auto const& session : recorded)
+  {
+    std::int32_t cmd;
+    std::int32_t args[3];
+    ASSERT_TRUE(engine.NextCall(cmd, args));
+    EXPECT_EQ(cmd, CG_DRAW_ACTIVE_FRAME);
+    EXPECT_EQ(args[0], 1000);
+
+    Session replayed;
+    replayed.run();
+    EXPECT_EQ(replayed.milliseconds, session.milliseconds);
+    EXPECT_EQ(replayed.gotSnapshot, session.gotSnapshot);
+    expectSameSnapshot(*replayed.snapshot, *session.snapshot);
+    EXPECT_EQ(replayed.numFragments, session.numFragments);
+    EXPECT_EQ(std::memcmp(replayed.fragments, session.fragments, 2 * sizeof(markFragment_t)), 0);
+    EXPECT_EQ(std::memcmp(replayed.pointBuffer, session.pointBuffer, 5 * sizeof(vec3_t)), 0);
+  }
+  EXPECT_TRUE(engine.Done());
+}
+
+TEST(SyscallLogDeathTest, OversizedOutputDiverges)
+{
+  // trap_GetCurrentSnapshotNumber's first output is an int, the log claims 8 bytes
+  auto log = header();
+  log.insert(log.end(), { static_cast<std::uint8_t>(CG_GETCURRENTSNAPSHOTNUMBER), 0, 2, 8 });
+  log.insert(log.end(), 8, 0);
+  log.push_back(4);
+  log.insert(log.end(), 4, 0);
+
+  EXPECT_EXIT(
+    {
+      ReplayEngine engine(log);
+      std::int32_t snapshotNumber;
+      std::int32_t serverTime;
+      trap_GetCurrentSnapshotNumber(&snapshotNumber, &serverTime);
+    },
+    testing::ExitedWithCode(EXIT_FAILURE),
+    "replay diverged");
+}
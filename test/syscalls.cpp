@@ -20,22 +20,39 @@ T* ptr(std::intptr_t x)
 {
   return reinterpret_cast<T*>(x);
 }
+
+float flt(std::intptr_t x)
+{
+  auto const i = static_cast<std::int32_t>(x);
+  float      f;
+  std::memcpy(&f, &i, sizeof(f));
+  return f;
+}
 } // namespace
 
-Syscalls::Syscalls()
+Engine::Engine()
 {
-  assert(!syscalls_);
-  syscalls_ = this;
+  assert(!engine_);
+  engine_ = this;
   dllEntry(&VM_DllSyscall);
 }
 
-Syscalls::~Syscalls()
+Engine::~Engine()
 {
-  assert(syscalls_ == this);
-  syscalls_ = nullptr;
+  assert(engine_ == this);
+  engine_ = nullptr;
   dllEntry(nullptr);
 }
 
+std::map<std::intptr_t, std::uint64_t>& Engine::callCounts()
+{
+  return callCounts_;
+}
+
+Syscalls::Syscalls() = default;
+
+Syscalls::~Syscalls() = default;
+
 /*
 ============
 VM_DllSyscall
@@ -74,9 +91,9 @@ Dlls will call this directly
 
 ============
 */
-std::intptr_t QDECL Syscalls::VM_DllSyscall(std::intptr_t arg, ...)
+std::intptr_t QDECL Engine::VM_DllSyscall(std::intptr_t arg, ...)
 {
-  assert(syscalls_);
+  assert(engine_);
 
   // rcg010206 - see commentary above
   std::intptr_t args[MAX_VMSYSCALL_ARGS];
@@ -87,7 +104,8 @@ std::intptr_t QDECL Syscalls::VM_DllSyscall(std::intptr_t arg, ...)
   for (std::uint8_t i = 1; i < ARRAY_LEN(args); i++) args[i] = va_arg(ap, std::intptr_t);
   va_end(ap);
 
-  return syscalls_->CL_CgameSystemCalls(args[0], args + 1);
+  ++engine_->callCounts_[args[0]];
+  return engine_->CL_CgameSystemCalls(args[0], args + 1);
 }
 
 /*
@@ -120,7 +138,31 @@ std::intptr_t Syscalls::CL_CgameSystemCalls(std::intptr_t cmd, std::intptr_t* ar
     return 0;
   case CG_GETSNAPSHOT:
     return CL_GetSnapshot(static_cast<std::int32_t>(args[0]), ptr<snapshot_t>(args[1]));
+  case CG_CM_BOXTRACE:
+    CM_BoxTrace(
+      ptr<trace_t>(args[0]),
+      ptr<float const>(args[1]),
+      ptr<float const>(args[2]),
+      ptr<float const>(args[3]),
+      ptr<float const>(args[4]),
+      static_cast<clipHandle_t>(args[5]),
+      static_cast<std::int32_t>(args[6]));
+    return 0;
+  case CG_R_SETCOLOR:
+    R_SetColor(ptr<float const>(args[0]));
+    return 0;
+  case CG_R_DRAWSTRETCHPIC:
+    R_DrawStretchPic(
+      flt(args[0]),
+      flt(args[1]),
+      flt(args[2]),
+      flt(args[3]),
+      flt(args[4]),
+      flt(args[5]),
+      flt(args[6]),
+      flt(args[7]),
+      static_cast<qhandle_t>(args[8]));
+    return 0;
   }
-  assert(false);
-  return 0;
+  return CL_OtherSystemCalls(cmd, args);
 }
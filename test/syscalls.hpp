@@ -7,8 +7,33 @@ extern "C"
 }
 
 #include <cstdint>
+#include <map>
 
-class Syscalls
+// The client side of the cgame syscall interface, as seen by the proxymod's dllEntry. Only one engine exists at a
+// time, it receives the syscalls while it lives.
+class Engine
+{
+public:
+  virtual std::intptr_t CL_CgameSystemCalls(std::intptr_t cmd, std::intptr_t* args) = 0;
+
+  // Number of calls of each syscall so far.
+  std::map<std::intptr_t, std::uint64_t>& callCounts();
+
+  Engine();
+
+  virtual ~Engine();
+
+private:
+  static std::intptr_t QDECL VM_DllSyscall(std::intptr_t arg, ...);
+
+  std::map<std::intptr_t, std::uint64_t> callCounts_;
+
+  inline static Engine* engine_ = nullptr;
+};
+
+// Engine split into the syscalls the proxymod's own code makes, the rest (files, rendering, sound, the qvm's
+// gamestate, ...) only matters when a real qvm is run.
+class Syscalls : public Engine
 {
 public:
   virtual void Cvar_Register(vmCvar_t* vmCvar, char const* varName, char const* defaultValue, std::int32_t flags) = 0;
@@ -27,17 +52,27 @@ public:
 
   virtual qboolean CL_GetSnapshot(std::int32_t snapshotNumber, snapshot_t* snapshot) = 0;
 
-  Syscalls();
+  virtual void CM_BoxTrace(
+    trace_t*     results,
+    float const* start,
+    float const* end,
+    float const* mins,
+    float const* maxs,
+    clipHandle_t model,
+    std::int32_t brushmask) = 0;
 
-  virtual ~Syscalls();
+  virtual void R_SetColor(float const* rgba) = 0;
 
-private:
-  static std::intptr_t QDECL VM_DllSyscall(std::intptr_t arg, ...);
+  virtual void
+    R_DrawStretchPic(float x, float y, float w, float h, float s1, float t1, float s2, float t2, qhandle_t hShader) = 0;
 
-  std::intptr_t CL_CgameSystemCalls(std::intptr_t cmd, std::intptr_t* args);
+  virtual std::intptr_t CL_OtherSystemCalls(std::intptr_t cmd, std::intptr_t* args) = 0;
 
-private:
-  inline static Syscalls* syscalls_ = nullptr;
+  std::intptr_t CL_CgameSystemCalls(std::intptr_t cmd, std::intptr_t* args) final;
+
+  Syscalls();
+
+  ~Syscalls() override;
 };
 
 #endif // SYSCALLS_HPP
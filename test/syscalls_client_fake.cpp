@@ -7,67 +7,67 @@ extern "C"
 #include <cg_vm.h>
 }
 
+#include <cassert>
 #include <cstring>
-#include <vector>
 
 #define PACKET_BACKUP                                                                                                  \
   32 // number of old messages that must be kept on client and
      // server for delta comrpession and ping estimation
 #define PACKET_MASK (PACKET_BACKUP - 1)
 
-class SyscallsClientFake::Impl
+SyscallsClientFake::Impl::Impl(bool fakePredictedPlayerState)
+  : snapshots_(PACKET_BACKUP), fakePredictedPlayerState_(fakePredictedPlayerState)
 {
-public:
-  Impl() : snapshots_(PACKET_BACKUP)
-  {
-    // Fake predicted player state, VM_ArgPtr(defrag()->pps_offset)
-    std::memset(&g_VM, 0, sizeof(g_VM));
-    g_VM.dataSegment = reinterpret_cast<byte*>(&pps_);
-  }
-
-  ~Impl()
-  {
-    assert(g_VM.dataSegment == reinterpret_cast<byte*>(&pps_));
-    g_VM.dataSegment = nullptr;
-  }
-
-  void CL_GetCurrentSnapshotNumber(std::int32_t* snapshotNumber, std::int32_t* serverTime) const
-  {
-    assert(snapshotNumber);
-    assert(serverTime);
-    *snapshotNumber = snapshotNumber_;
-    *serverTime     = getSnapshot(snapshotNumber_).serverTime;
-  }
-
-  qboolean CL_GetSnapshot(std::int32_t snapshotNumber, snapshot_t* snapshot) const
-  {
-    assert(snapshot);
-    std::memcpy(snapshot, &getSnapshot(snapshotNumber), sizeof(snapshot_t));
-    return qtrue;
-  }
-
-  const snapshot_t& getSnapshot(std::int32_t snapshotNumber) const
-  {
-    return snapshots_[snapshotNumber & PACKET_MASK];
-  }
-
-  snapshot_t& getSnapshot(std::int32_t snapshotNumber)
-  {
-    return snapshots_[snapshotNumber & PACKET_MASK];
-  }
-
-public:
-  std::int32_t            snapshotNumber_ = 0;
-  std::vector<snapshot_t> snapshots_;
-
-  playerState_t pps_ = {};
-};
+  if (!fakePredictedPlayerState_) return;
+  // Fake predicted player state, VM_ArgPtr(defrag()->pps_offset)
+  std::memset(&g_VM, 0, sizeof(g_VM));
+  g_VM.dataSegment = reinterpret_cast<byte*>(&pps_);
+}
+
+SyscallsClientFake::Impl::~Impl()
+{
+  if (!fakePredictedPlayerState_) return;
+  assert(g_VM.dataSegment == reinterpret_cast<byte*>(&pps_));
+  g_VM.dataSegment = nullptr;
+}
+
+void SyscallsClientFake::Impl::CL_GetCurrentSnapshotNumber(std::int32_t* snapshotNumber, std::int32_t* serverTime) const
+{
+  assert(snapshotNumber);
+  assert(serverTime);
+  *snapshotNumber = snapshotNumber_;
+  *serverTime     = getSnapshot(snapshotNumber_).serverTime;
+}
+
+qboolean SyscallsClientFake::Impl::CL_GetSnapshot(std::int32_t snapshotNumber, snapshot_t* snapshot) const
+{
+  assert(snapshot);
+  std::memcpy(snapshot, &getSnapshot(snapshotNumber), sizeof(snapshot_t));
+  return qtrue;
+}
+
+snapshot_t const& SyscallsClientFake::Impl::getSnapshot(std::int32_t snapshotNumber) const
+{
+  return snapshots_[snapshotNumber & PACKET_MASK];
+}
+
+snapshot_t& SyscallsClientFake::Impl::getSnapshot(std::int32_t snapshotNumber)
+{
+  return snapshots_[snapshotNumber & PACKET_MASK];
+}
 
 snapshot_t& SyscallsClientFake::getSnapshot()
 {
   return impl_->getSnapshot(impl_->snapshotNumber_);
 }
 
+snapshot_t& SyscallsClientFake::nextSnapshot()
+{
+  auto& snapshot = impl_->getSnapshot(++impl_->snapshotNumber_);
+  snapshot       = {};
+  return snapshot;
+}
+
 playerState_t& SyscallsClientFake::getPlayerState()
 {
   return impl_->pps_;
@@ -80,7 +80,8 @@ void SyscallsClientFake::setDefaultActions(SyscallsMock& mock)
   ON_CALL(mock, CL_GetSnapshot).WillByDefault(testing::Invoke(impl_.get(), &Impl::CL_GetSnapshot));
 }
 
-SyscallsClientFake::SyscallsClientFake() : impl_(std::make_unique<Impl>())
+SyscallsClientFake::SyscallsClientFake(bool fakePredictedPlayerState)
+  : impl_(std::make_unique<Impl>(fakePredictedPlayerState))
 {
 }
 
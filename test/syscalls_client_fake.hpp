@@ -8,18 +8,24 @@ extern "C"
 #include <cg_public.h>
 }
 
+#include <cstdint>
 #include <memory>
+#include <vector>
 
 class SyscallsClientFake : public SyscallsFake
 {
 public:
   snapshot_t& getSnapshot();
 
+  // Makes the next snapshot the current one and returns it cleared.
+  snapshot_t& nextSnapshot();
+
   playerState_t& getPlayerState();
 
   void setDefaultActions(SyscallsMock& mock) final;
 
-  SyscallsClientFake();
+  // g_VM is set up to read the predicted player state from getPlayerState unless a real qvm is run.
+  explicit SyscallsClientFake(bool fakePredictedPlayerState = true);
 
   ~SyscallsClientFake();
 
@@ -29,4 +35,28 @@ private:
   std::unique_ptr<Impl> impl_;
 };
 
+// The snapshots the client keeps, the last PACKET_BACKUP of them.
+class SyscallsClientFake::Impl
+{
+public:
+  explicit Impl(bool fakePredictedPlayerState = true);
+
+  ~Impl();
+
+  void CL_GetCurrentSnapshotNumber(std::int32_t* snapshotNumber, std::int32_t* serverTime) const;
+
+  qboolean CL_GetSnapshot(std::int32_t snapshotNumber, snapshot_t* snapshot) const;
+
+  snapshot_t const& getSnapshot(std::int32_t snapshotNumber) const;
+
+  snapshot_t& getSnapshot(std::int32_t snapshotNumber);
+
+public:
+  std::int32_t            snapshotNumber_ = 0;
+  std::vector<snapshot_t> snapshots_;
+
+  bool          fakePredictedPlayerState_;
+  playerState_t pps_ = {};
+};
+
 #endif // SYSCALLS_CLIENT_FAKE_HPP
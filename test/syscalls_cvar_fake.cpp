@@ -3,120 +3,118 @@
 #include "syscalls_mock.hpp"
 
 #include <cassert>
+#include <cstdlib>
 #include <cstring>
-#include <map>
 
-namespace
+SyscallsCvarFake::Impl::Cvar::Cvar(char const* string, std::int32_t flags) : flags_(flags)
 {
-class Cvar
+  assert(string);
+  set(string);
+}
+
+void SyscallsCvarFake::Impl::Cvar::set(char const* string)
 {
-public:
-  Cvar(char const* string, std::int32_t flags) : flags_(flags)
-  {
-    assert(string);
-    set(string);
-  }
+  assert(string);
+  string_  = string;
+  value_   = static_cast<float>(std::atof(string));
+  integer_ = std::atoi(string);
+  ++modificationCount_;
+}
+
+void SyscallsCvarFake::Impl::Cvar_Register(
+  vmCvar_t*    vmCvar,
+  char const*  varName,
+  char const*  defaultValue,
+  std::int32_t flags)
+{
+  assert(varName);
+  assert(defaultValue);
 
-  void set(char const* string)
+  auto const nameToHandleIt = nameToHandles_.find(varName);
+  auto const handle         = nameToHandleIt != nameToHandles_.cend() ? nameToHandleIt->second : nextCvarHandle_++;
+  if (handle == cvars_.size())
   {
-    assert(string);
-    string_  = string;
-    value_   = static_cast<float>(std::atof(string));
-    integer_ = std::atoi(string);
+    nameToHandles_.emplace(varName, handle);
+    cvars_.emplace_back(defaultValue, flags);
   }
 
-  std::string  string_;
-  std::int32_t flags_   = 0;
-  float        value_   = 0; // std::atof(string)
-  std::int32_t integer_ = 0; // std::atoi(string)
-};
-} // namespace
+  // the engine also creates cvars without a vmCvar_t
+  if (!vmCvar) return;
+  vmCvar->handle = handle;
+  Cvar_Update(vmCvar);
+}
 
-class SyscallsCvarFake::Impl
+void SyscallsCvarFake::Impl::Cvar_Update(vmCvar_t* vmCvar) const
 {
-public:
-  void Cvar_Register(vmCvar_t* vmCvar, char const* varName, char const* defaultValue, std::int32_t flags)
-  {
-    assert(vmCvar);
-    assert(varName);
-    assert(defaultValue);
-
-    assert(!nameToHandles_.count(varName));
-    nameToHandles_.emplace(varName, nextCvarHandle_);
-    cvars_.emplace_back(defaultValue, flags);
+  assert(vmCvar);
 
-    vmCvar->handle = nextCvarHandle_++;
-    Cvar_Update(vmCvar);
-  }
-
-  void Cvar_Update(vmCvar_t* vmCvar) const
-  {
-    assert(vmCvar);
+  assert(vmCvar->handle < cvars_.size());
+  auto const& cvar = cvars_[vmCvar->handle];
 
-    assert(vmCvar->handle < cvars_.size());
-    auto const& cvar = cvars_[vmCvar->handle];
+  assert(cvar.string_.size() + 1 <= sizeof(vmCvar->string));
+  std::strncpy(vmCvar->string, cvar.string_.c_str(), sizeof(vmCvar->string) - 1);
+  vmCvar->string[sizeof(vmCvar->string) - 1] = '\0';
 
-    assert(cvar.string_.size() + 1 <= sizeof(vmCvar->string));
-    std::strncpy(vmCvar->string, cvar.string_.c_str(), sizeof(vmCvar->string) - 1);
-    vmCvar->string[sizeof(vmCvar->string) - 1] = '\0';
+  vmCvar->modificationCount = cvar.modificationCount_;
+  vmCvar->value             = cvar.value_;
+  vmCvar->integer           = cvar.integer_;
+}
 
-    vmCvar->value   = cvar.value_;
-    vmCvar->integer = cvar.integer_;
-  }
+void SyscallsCvarFake::Impl::Cvar_SetSafe(const char* var_name, const char* value)
+{
+  assert(var_name);
+  assert(value);
 
-  void Cvar_SetSafe(const char* var_name, const char* value)
+  auto* const cvar = find(var_name);
+  if (!cvar)
   {
-    assert(var_name);
-    assert(value);
-
-    auto* const cvar = find(var_name);
-    assert(cvar);
-    assert(!(cvar->flags_ & (CVAR_PROTECTED | CVAR_PRIVATE)));
-    cvar->set(value);
+    Cvar_Register(nullptr, var_name, value, 0);
+    return;
   }
+  assert(!(cvar->flags_ & (CVAR_PROTECTED | CVAR_PRIVATE)));
+  cvar->set(value);
+}
+
+void SyscallsCvarFake::Impl::Cvar_VariableStringBufferSafe(
+  char const*  var_name,
+  char*        buffer,
+  std::int32_t bufsize,
+  std::int32_t flag) const
+{
+  assert(var_name);
+  assert(buffer);
+  assert(bufsize > 0);
 
-  void Cvar_VariableStringBufferSafe(char const* var_name, char* buffer, std::int32_t bufsize, std::int32_t flag) const
+  auto const* const cvar = find(var_name);
+  if (!cvar || cvar->flags_ & flag)
   {
-    assert(var_name);
-    assert(buffer);
-    assert(bufsize > 0);
-
-    auto const* const cvar = find(var_name);
-    if (!cvar || cvar->flags_ & flag)
-    {
-      *buffer = '\0';
-    }
-    else
-    {
-      std::strncpy(buffer, cvar->string_.c_str(), static_cast<std::size_t>(bufsize - 1));
-      buffer[bufsize - 1] = '\0';
-    }
+    *buffer = '\0';
   }
-
-  Cvar const* find(char const* var_name) const
+  else
   {
-    assert(var_name);
-
-    auto const nameToHandleIt = nameToHandles_.find(var_name);
-    if (nameToHandleIt != nameToHandles_.cend())
-    {
-      auto const handle = nameToHandleIt->second;
-      assert(handle < cvars_.size());
-      return &cvars_[handle];
-    }
-    return nullptr;
+    std::strncpy(buffer, cvar->string_.c_str(), static_cast<std::size_t>(bufsize - 1));
+    buffer[bufsize - 1] = '\0';
   }
+}
 
-  Cvar* find(char const* var_name)
+SyscallsCvarFake::Impl::Cvar const* SyscallsCvarFake::Impl::find(char const* var_name) const
+{
+  assert(var_name);
+
+  auto const nameToHandleIt = nameToHandles_.find(var_name);
+  if (nameToHandleIt != nameToHandles_.cend())
   {
-    return const_cast<Cvar*>(static_cast<Impl const&>(*this).find(var_name));
+    auto const handle = nameToHandleIt->second;
+    assert(handle < cvars_.size());
+    return &cvars_[handle];
   }
+  return nullptr;
+}
 
-public:
-  cvarHandle_t                        nextCvarHandle_ = 0;
-  std::vector<Cvar>                   cvars_;
-  std::map<std::string, cvarHandle_t> nameToHandles_;
-};
+SyscallsCvarFake::Impl::Cvar* SyscallsCvarFake::Impl::find(char const* var_name)
+{
+  return const_cast<Cvar*>(static_cast<Impl const&>(*this).find(var_name));
+}
 
 void SyscallsCvarFake::setDefaultActions(SyscallsMock& mock)
 {
@@ -149,6 +147,20 @@ TEST(SyscallsCvarFake, Register)
   EXPECT_STREQ(vmCvar2.string, "42");
 }
 
+TEST(SyscallsCvarFake, RegisterTwice)
+{
+  SyscallsCvarFake::Impl fake;
+  vmCvar_t               vmCvar1 = {};
+  vmCvar_t               vmCvar2 = {};
+
+  fake.Cvar_Register(&vmCvar1, "varName", "3.14", CVAR_ARCHIVE_ND);
+  fake.Cvar_SetSafe("varName", "42");
+  fake.Cvar_Register(&vmCvar2, "varName", "3.14", CVAR_ARCHIVE_ND);
+  EXPECT_EQ(vmCvar2.handle, vmCvar1.handle);
+  EXPECT_EQ(vmCvar2.integer, 42);
+  EXPECT_STREQ(vmCvar2.string, "42");
+}
+
 TEST(SyscallsCvarFake, Update)
 {
   SyscallsCvarFake::Impl fake;
@@ -160,6 +172,17 @@ TEST(SyscallsCvarFake, Update)
   EXPECT_EQ(vmCvar.value, 42.f);
   EXPECT_EQ(vmCvar.integer, 42);
   EXPECT_STREQ(vmCvar.string, "42");
+  EXPECT_EQ(vmCvar.modificationCount, 2);
+}
+
+TEST(SyscallsCvarFake, SetSafeUnknownCvar)
+{
+  SyscallsCvarFake::Impl fake;
+  char                   buffer[5] = {};
+
+  fake.Cvar_SetSafe("varName", "42");
+  fake.Cvar_VariableStringBufferSafe("varName", buffer, sizeof(buffer), CVAR_PRIVATE);
+  EXPECT_STREQ(buffer, "42");
 }
 
 TEST(SyscallsCvarFake, SetSafe)
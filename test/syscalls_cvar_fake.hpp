@@ -3,7 +3,16 @@
 
 #include "syscalls_fake.hpp"
 
+extern "C"
+{
+#include <q_shared.h>
+}
+
+#include <cstdint>
+#include <map>
 #include <memory>
+#include <string>
+#include <vector>
 
 class SyscallsCvarFake : public SyscallsFake
 {
@@ -20,4 +29,40 @@ private:
   std::unique_ptr<Impl> impl_;
 };
 
+// The cvar store, like the engine's: registering a cvar again keeps its value and setting an unknown one creates it.
+class SyscallsCvarFake::Impl
+{
+public:
+  class Cvar
+  {
+  public:
+    Cvar(char const* string, std::int32_t flags);
+
+    void set(char const* string);
+
+    std::string  string_;
+    std::int32_t flags_             = 0;
+    float        value_             = 0; // std::atof(string)
+    std::int32_t integer_           = 0; // std::atoi(string)
+    std::int32_t modificationCount_ = 0; // incremented each time the cvar is set
+  };
+
+  void Cvar_Register(vmCvar_t* vmCvar, char const* varName, char const* defaultValue, std::int32_t flags);
+
+  void Cvar_Update(vmCvar_t* vmCvar) const;
+
+  void Cvar_SetSafe(char const* var_name, char const* value);
+
+  void Cvar_VariableStringBufferSafe(char const* var_name, char* buffer, std::int32_t bufsize, std::int32_t flag) const;
+
+  Cvar const* find(char const* var_name) const;
+
+  Cvar* find(char const* var_name);
+
+public:
+  cvarHandle_t                        nextCvarHandle_ = 0;
+  std::vector<Cvar>                   cvars_;
+  std::map<std::string, cvarHandle_t> nameToHandles_;
+};
+
 #endif // SYSCALLS_CVAR_FAKE_HPP
@@ -30,6 +30,28 @@ public:
 
   MOCK_METHOD(qboolean, CL_GetSnapshot, (std::int32_t snapshotNumber, snapshot_t* snapshot), (final));
 
+  MOCK_METHOD(
+    void,
+    CM_BoxTrace,
+    (trace_t * results,
+     float const* start,
+     float const* end,
+     float const* mins,
+     float const* maxs,
+     clipHandle_t model,
+     std::int32_t brushmask),
+    (final));
+
+  MOCK_METHOD(void, R_SetColor, (float const* rgba), (final));
+
+  MOCK_METHOD(
+    void,
+    R_DrawStretchPic,
+    (float x, float y, float w, float h, float s1, float t1, float s2, float t2, qhandle_t hShader),
+    (final));
+
+  MOCK_METHOD(std::intptr_t, CL_OtherSystemCalls, (std::intptr_t cmd, std::intptr_t* args), (final));
+
   void delegateTo(SyscallsFake& fake);
 
   SyscallsMock();
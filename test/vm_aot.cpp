@@ -0,0 +1,81 @@
+#include "vm_program.hpp"
+
+#include <gtest/gtest.h>
+
+extern "C"
+{
+#include <vm_aot.h>
+#include <vm_hook.h>
+
+extern vmAot_t const vm_aot_test; // translated from vm_program.hpp by qvmtool, see CMakeLists.txt
+}
+
+namespace
+{
+class VmAot : public testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    load(vm_);
+    vm_.aot = &vm_aot_test;
+  }
+
+  void TearDown() override
+  {
+    unload(vm_);
+  }
+
+  std::intptr_t run()
+  {
+    return ::run(vm_);
+  }
+
+  vm_t vm_ = {};
+};
+
+std::vector<std::int32_t> seen;
+
+void pre(vmHookContext_t* ctx)
+{
+  seen.push_back(ctx->args[0]);
+}
+
+void post(vmHookContext_t* ctx)
+{
+  seen.push_back(ctx->args[0]);
+  seen.push_back(*ctx->ret);
+  *ctx->ret += 1;
+}
+} // namespace
+
+TEST_F(VmAot, RunsTheTranslation)
+{
+  auto* const opStack = vm_.opStack;
+  auto const  opBase  = vm_.opBase;
+  EXPECT_EQ(run(), 15);
+  EXPECT_EQ(vm_.instructionsExecuted, 0u);
+  EXPECT_EQ(vm_.opStack, opStack);
+  EXPECT_EQ(vm_.opBase, opBase);
+}
+
+TEST_F(VmAot, SameAsTheInterpreter)
+{
+  EXPECT_EQ(run(), 15);
+  vm_.aot = nullptr;
+  EXPECT_EQ(run(), 15);
+  EXPECT_GT(vm_.instructionsExecuted, 0u);
+}
+
+TEST_F(VmAot, FunctionHooks)
+{
+  seen.clear();
+  ASSERT_TRUE(add_vm_function_hooks(&vm_, f, pre, post));
+  EXPECT_EQ(run(), 16);
+  EXPECT_EQ(seen, (std::vector<std::int32_t>{ 7, 7, 14 }));
+}
+
+TEST_F(VmAot, NoTranslationForUnknownQvms)
+{
+  EXPECT_EQ(find_vm_aot(0), nullptr);
+}
@@ -0,0 +1,197 @@
+#include "vm_program.hpp"
+
+#include <gtest/gtest.h>
+
+extern "C"
+{
+#include <cg_public.h>
+#include <vm_hook.h>
+}
+
+#include <cstdarg>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+namespace
+{
+// vmMain returns what trap_Argv(7, buffer, 4) wrote into its buffer.
+std::vector<std::int32_t> const argv = {
+  OP_ENTER, 24,
+  OP_CONST, 7,
+  OP_ARG,   8,
+  OP_CONST, 100,
+  OP_ARG,   12,
+  OP_CONST, 4,
+  OP_ARG,   16,
+  OP_CONST, -1 - CG_ARGV,
+  OP_CALL,  0,
+  OP_POP,   0,
+  OP_CONST, 100,
+  OP_LOAD4, 0,
+  OP_LEAVE, 24,
+};
+
+thread_local std::int32_t threadIndex;
+thread_local std::int32_t threadCalls;
+
+// The engine of the vms run on threads: trap_Argv writes the argument number plus the index of the calling thread.
+std::intptr_t QDECL threadEngine(std::intptr_t cmd, ...)
+{
+  ++threadCalls;
+  if (cmd != CG_ARGV) return 0;
+
+  std::va_list ap;
+  va_start(ap, cmd);
+  auto const  n      = va_arg(ap, std::int32_t);
+  auto* const buffer = va_arg(ap, void*);
+  va_end(ap);
+
+  auto const value = n + threadIndex;
+  std::memcpy(buffer, &value, sizeof(value));
+  return 0;
+}
+
+class VmHook : public testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    load(vm_);
+  }
+
+  void TearDown() override
+  {
+    unload(vm_);
+  }
+
+  std::intptr_t run()
+  {
+    return ::run(vm_);
+  }
+
+  vm_t vm_ = {};
+};
+
+std::vector<std::int32_t> seen;
+
+void pre(vmHookContext_t* ctx)
+{
+  EXPECT_EQ(ctx->ret, nullptr);
+  seen.push_back(ctx->args[0]);
+}
+
+void post(vmHookContext_t* ctx)
+{
+  seen.push_back(ctx->args[0]);
+  seen.push_back(*ctx->ret);
+  *ctx->ret += 1;
+}
+
+void instruction(vmHookContext_t* ctx)
+{
+  EXPECT_EQ(ctx->args, nullptr);
+  seen.push_back(-ctx->address);
+}
+} // namespace
+
+TEST_F(VmHook, Unhooked)
+{
+  EXPECT_EQ(run(), 15);
+}
+
+TEST_F(VmHook, WithoutHookFlags)
+{
+  free_vm_hooks(&vm_);
+  EXPECT_EQ(run(), 15);
+  vm_.cacheTos = qtrue;
+  EXPECT_EQ(run(), 15);
+}
+
+TEST_F(VmHook, FunctionHooksSeeArgumentsAndReturnValue)
+{
+  seen.clear();
+  ASSERT_TRUE(add_vm_function_hooks(&vm_, f, pre, post));
+  EXPECT_EQ(run(), 16);
+  EXPECT_EQ(seen, (std::vector<std::int32_t>{ 7, 7, 14 }));
+}
+
+TEST_F(VmHook, InstructionHooks)
+{
+  seen.clear();
+  ASSERT_TRUE(add_vm_hook(&vm_, 5, instruction));
+  ASSERT_TRUE(add_vm_hook(&vm_, 5, instruction));
+  EXPECT_EQ(run(), 15);
+  EXPECT_EQ(seen, (std::vector<std::int32_t>{ -5, -5 }));
+}
+
+TEST_F(VmHook, OnlyOnFunctions)
+{
+  EXPECT_FALSE(add_vm_function_hooks(&vm_, 1, pre, post));
+  EXPECT_FALSE(add_vm_hook(&vm_, vm_.codeSegmentLen, instruction));
+}
+
+TEST_F(VmHook, OnlyOnTheirVm)
+{
+  vm_t other;
+  load(other);
+  seen.clear();
+  ASSERT_TRUE(add_vm_function_hooks(&other, f, pre, post));
+  EXPECT_EQ(run(), 15);
+  EXPECT_TRUE(seen.empty());
+  EXPECT_EQ(::run(other), 16);
+  unload(other);
+}
+
+TEST(VmHookThreads, VmsRunConcurrently)
+{
+  std::vector<vm_t> vms(4);
+  for (auto& vm : vms) load(vm);
+
+  std::vector<std::thread> threads;
+  std::vector<int>         wrong(vms.size());
+  for (std::size_t i = 0; i < vms.size(); ++i)
+  {
+    threads.emplace_back([&, i] {
+      for (int n = 0; n < 10000; ++n) wrong[i] += ::run(vms[i]) != 15;
+    });
+  }
+  for (auto& thread : threads) thread.join();
+
+  for (std::size_t i = 0; i < vms.size(); ++i)
+  {
+    EXPECT_EQ(wrong[i], 0);
+    EXPECT_EQ(vms[i].instructionsExecuted, 10000u * 14);
+    unload(vms[i]);
+  }
+}
+
+TEST(VmHookThreads, VmsCallTheirEngineConcurrently)
+{
+  std::vector<vm_t> vms(4);
+  for (auto& vm : vms)
+  {
+    load(vm, argv);
+    vm.engine = threadEngine;
+  }
+
+  std::vector<std::thread> threads;
+  std::vector<int>         wrong(vms.size());
+  std::vector<int>         calls(vms.size());
+  for (std::size_t i = 0; i < vms.size(); ++i)
+  {
+    threads.emplace_back([&, i] {
+      threadIndex = static_cast<std::int32_t>(i);
+      for (int n = 0; n < 10000; ++n) wrong[i] += ::run(vms[i]) != 7 + threadIndex;
+      calls[i] = threadCalls;
+    });
+  }
+  for (auto& thread : threads) thread.join();
+
+  for (std::size_t i = 0; i < vms.size(); ++i)
+  {
+    EXPECT_EQ(wrong[i], 0);
+    EXPECT_EQ(calls[i], 10000);
+    unload(vms[i]);
+  }
+}
@@ -0,0 +1,279 @@
+#include "syscalls_mock.hpp"
+
+extern "C"
+{
+#include <cg_vm.h>
+}
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+using ::testing::_;
+
+namespace
+{
+std::int32_t swap(std::int32_t i)
+{
+  auto const u = static_cast<std::uint32_t>(i);
+  return static_cast<std::int32_t>((u >> 24) | ((u >> 8) & 0xFF00) | ((u << 8) & 0xFF0000) | (u << 24));
+}
+
+// A qvm image and what VM_Load should make of it.
+class Image
+{
+public:
+  Image(std::int32_t magic, bool swapped) : magic_(magic), swapped_(swapped)
+  {
+    // more than two 64 KB chunks of code, with a constant split by the first chunk boundary
+    while (code_.size() < 3 * 65536)
+    {
+      if (code_.size() == 65536 - 2) add(OP_CONST, 0x12345678);
+      else if (code_.size() > 65536 - 2 - 5 && code_.size() < 65536 - 2) add(OP_ADD, 0);
+      else if (instructions_.size() % 3 == 0) add(OP_CONST, static_cast<std::int32_t>(instructions_.size()) * 7919);
+      else if (instructions_.size() % 3 == 1) add(OP_ARG, static_cast<std::int32_t>(instructions_.size() & 0xFF));
+      else add(OP_SUB, 0);
+    }
+    for (std::int32_t i = 0; i < 100; ++i) data_.push_back(i * 0x01010101);
+    for (std::int32_t i = 0; i < 42; ++i) lit_.push_back(static_cast<byte>('a' + i % 26));
+    if (magic_ == VM_MAGIC_VER2) jumpTargets_ = { 3, 1000, 20000 };
+
+    vmHeader_t header       = {};
+    header.vmMagic          = magic_;
+    header.instructionCount = static_cast<std::int32_t>(instructions_.size() / 2);
+    header.codeOffset       = magic_ == VM_MAGIC_VER2 ? static_cast<std::int32_t>(sizeof(header)) : VM_HEADER_SIZE_VER1;
+    header.codeLength       = static_cast<std::int32_t>(code_.size());
+    header.dataOffset       = header.codeOffset + header.codeLength;
+    header.dataLength       = static_cast<std::int32_t>(data_.size() * sizeof(std::int32_t));
+    header.litLength        = static_cast<std::int32_t>(lit_.size());
+    header.bssLength        = 4096;
+    header.jtrgLength       = static_cast<std::int32_t>(jumpTargets_.size() * sizeof(std::int32_t));
+    bssLength_              = header.bssLength;
+
+    auto* const fields = reinterpret_cast<std::int32_t*>(&header);
+    for (std::size_t i = 0; i < static_cast<std::size_t>(header.codeOffset) / sizeof(std::int32_t); ++i)
+      append(fields[i]);
+    file_.insert(file_.end(), code_.cbegin(), code_.cend());
+    for (auto const i : data_) append(i);
+    file_.insert(file_.end(), lit_.cbegin(), lit_.cend());
+    for (auto const i : jumpTargets_) append(i);
+  }
+
+  std::int32_t              magic_;
+  bool                      swapped_;
+  std::vector<byte>         file_;
+  std::vector<byte>         code_;         // as in the file
+  std::vector<std::int32_t> instructions_; // decoded, 2 ints each
+  std::vector<std::int32_t> data_;
+  std::vector<byte>         lit_;
+  std::int32_t              bssLength_ = 0;
+  std::vector<std::int32_t> jumpTargets_;
+
+private:
+  void add(vmOps_t op, std::int32_t param)
+  {
+    instructions_.push_back(op);
+    instructions_.push_back(param);
+    code_.push_back(static_cast<byte>(op));
+    if (VM_ParamSize(op) == 4)
+    {
+      auto const bytes = swapped_ ? swap(param) : param;
+      code_.insert(code_.end(), reinterpret_cast<byte const*>(&bytes), reinterpret_cast<byte const*>(&bytes + 1));
+    }
+    else if (VM_ParamSize(op) == 1)
+    {
+      code_.push_back(static_cast<byte>(param));
+    }
+  }
+
+  void append(std::int32_t i)
+  {
+    auto const bytes = swapped_ ? swap(i) : i;
+    file_.insert(file_.end(), reinterpret_cast<byte const*>(&bytes), reinterpret_cast<byte const*>(&bytes + 1));
+  }
+};
+
+// The file system of the engine, serving a single file.
+class VmLoad : public testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    EXPECT_CALL(mock_, CL_OtherSystemCalls(_, _)).WillRepeatedly([this](std::intptr_t cmd, std::intptr_t* args) {
+      switch (cmd)
+      {
+      case CG_FS_FOPENFILE:
+        offset_                                   = 0;
+        *reinterpret_cast<fileHandle_t*>(args[1]) = 1;
+        return static_cast<std::intptr_t>(file_->size());
+      case CG_FS_READ:
+      {
+        auto const len = static_cast<std::size_t>(args[1]);
+        EXPECT_LE(offset_ + len, file_->size());
+        std::memcpy(reinterpret_cast<void*>(args[0]), file_->data() + offset_, len);
+        offset_ += len;
+        return std::intptr_t{ 0 };
+      }
+      default: return std::intptr_t{ 0 };
+      }
+    });
+  }
+
+  void TearDown() override
+  {
+    VM_Destroy(&vm_);
+  }
+
+  void load(Image const& image)
+  {
+    file_ = &image.file_;
+    uint32_t crc32sum;
+    ASSERT_TRUE(VM_Load(&vm_, "vm/cgame.qvm", nullptr, &crc32sum));
+    EXPECT_EQ(offset_, image.file_.size());
+    EXPECT_EQ(crc32sum, crc32_reflect(image.file_.data(), static_cast<std::int32_t>(image.file_.size())));
+  }
+
+  SyscallsMock             mock_;
+  std::vector<byte> const* file_   = nullptr;
+  std::size_t              offset_ = 0;
+  vm_t                     vm_     = {};
+};
+} // namespace
+
+TEST_F(VmLoad, StreamsTheImage)
+{
+  for (auto const magic : { VM_MAGIC, VM_MAGIC_VER2 })
+  {
+    for (auto const swapped : { false, true })
+    {
+      Image const image(magic, swapped);
+      load(image);
+
+      // the code is decoded like VM_LoadInstructions does from the whole file
+      std::vector<std::int32_t> file((image.file_.size() + 3) / 4);
+      std::memcpy(file.data(), image.file_.data(), image.file_.size());
+      auto*    header    = reinterpret_cast<vmHeader_t*>(file.data());
+      qboolean isSwapped = qfalse;
+      ASSERT_EQ(VM_ValidateHeader(header, static_cast<std::int32_t>(image.file_.size()), &isSwapped), nullptr);
+      EXPECT_EQ(isSwapped, swapped ? qtrue : qfalse);
+      std::vector<std::int32_t> codeSegment(image.instructions_.size());
+      ASSERT_TRUE(VM_LoadInstructions(codeSegment.data(), header, isSwapped));
+      EXPECT_EQ(codeSegment, image.instructions_);
+      ASSERT_EQ(vm_.codeSegmentLen * 2, static_cast<std::int32_t>(image.instructions_.size()));
+      EXPECT_TRUE(std::equal(codeSegment.cbegin(), codeSegment.cend(), vm_.codeSegment)) << magic << swapped;
+
+      // data as in the file, lit as in the file, then zeros
+      auto const* const data = reinterpret_cast<std::int32_t const*>(vm_.dataSegment);
+      EXPECT_TRUE(std::equal(image.data_.cbegin(), image.data_.cend(), data)) << magic << swapped;
+      auto const* const lit = vm_.dataSegment + image.data_.size() * sizeof(std::int32_t);
+      EXPECT_TRUE(std::equal(image.lit_.cbegin(), image.lit_.cend(), lit)) << magic << swapped;
+      auto const* const bss = lit + image.lit_.size();
+      EXPECT_TRUE(std::all_of(bss, bss + image.bssLength_, [](byte b) { return b == 0; })) << magic << swapped;
+
+      EXPECT_EQ(std::vector<std::int32_t>(vm_.jumpTargets, vm_.jumpTargets + vm_.numJumpTargets), image.jumpTargets_);
+
+      VM_Destroy(&vm_);
+    }
+  }
+}
+
+namespace
+{
+// A valid VM_MAGIC_VER2 header of a file with 1 instruction, 4 bytes of data and lit and a jump table of 2 entries.
+vmHeader_t ver2()
+{
+  vmHeader_t header       = {};
+  header.vmMagic          = VM_MAGIC_VER2;
+  header.instructionCount = 1;
+  header.codeOffset       = sizeof(header);
+  header.codeLength       = 1;
+  header.dataOffset       = header.codeOffset + header.codeLength;
+  header.dataLength       = 4;
+  header.litLength        = 4;
+  header.jtrgLength       = 8;
+  return header;
+}
+
+std::int32_t fileSize(vmHeader_t const& header)
+{
+  return header.dataOffset + header.dataLength + header.litLength + header.jtrgLength;
+}
+
+// The error VM_ValidateHeader reports, empty when there's none.
+std::string validate(vmHeader_t header, std::int32_t size)
+{
+  qboolean          swapped = qfalse;
+  char const* const error   = VM_ValidateHeader(&header, size, &swapped);
+  return error ? error : "";
+}
+} // namespace
+
+TEST(VmValidateHeader, AcceptsVer2)
+{
+  auto const header = ver2();
+  EXPECT_EQ(validate(header, fileSize(header)), "");
+
+  // in the other byte order
+  auto swapped = header;
+  for (auto* i = &swapped.vmMagic; i <= &swapped.jtrgLength; ++i) *i = swap(*i);
+  qboolean isSwapped = qfalse;
+  EXPECT_EQ(VM_ValidateHeader(&swapped, fileSize(header), &isSwapped), nullptr);
+  EXPECT_EQ(isSwapped, qtrue);
+  EXPECT_EQ(swapped.jtrgLength, header.jtrgLength);
+}
+
+TEST(VmValidateHeader, RejectsBadJumpTables)
+{
+  auto       header = ver2();
+  auto const size   = fileSize(header);
+
+  EXPECT_EQ(validate(header, static_cast<std::int32_t>(sizeof(header)) - 1), "truncated image header (35 bytes long)");
+
+  header.jtrgLength = -4;
+  EXPECT_EQ(validate(header, size), "bad jump table length -4");
+  header.jtrgLength = 6;
+  EXPECT_EQ(validate(header, size), "bad jump table length 6");
+  // past the end of the file
+  header.jtrgLength = 8 + size;
+  EXPECT_EQ(validate(header, size), "bad jump table length " + std::to_string(8 + size));
+
+  // the segments don't add up to the file
+  header = ver2();
+  EXPECT_EQ(validate(header, size + 4), "bad lit segment length 4");
+  header.litLength = 0;
+  EXPECT_EQ(validate(header, size), "bad lit segment length 0");
+}
+
+TEST(VmFindBlocks, StartsOfBlocks)
+{
+  std::vector<std::int32_t> const code = {
+    OP_ENTER, 8,   // 0: function
+    OP_CONST, 5,
+    OP_CONST, 0,
+    OP_EQ,    7,   // branch to 7, falls through to 4
+    OP_CONST, 9,   // 4
+    OP_JUMP,  0,   // to the constant before it, 9
+    OP_CALL,  0,   // 6
+    OP_LEAVE, 8,   // 7
+    OP_CONST, 100, // 8: only in the jump table
+    OP_ADD,   0,   // 9
+    OP_NE,    500, // out of range
+    OP_LEAVE, 8,   // 11, the end after it is out of range too
+  };
+  auto const                      count       = static_cast<std::int32_t>(code.size() / 2);
+  std::vector<std::int32_t> const jumpTargets = { 8, 1000, -1 };
+
+  std::vector<std::uint32_t> blocks(2); // the second one must stay clear
+  VM_FindBlocks(blocks.data(), code.data(), count, jumpTargets.data(), static_cast<std::int32_t>(jumpTargets.size()));
+
+  std::vector<std::int32_t> starts;
+  for (std::int32_t i = 0; i < 64; ++i)
+  {
+    if (blocks[i >> 5] & (1u << (i & 31))) starts.push_back(i);
+  }
+  EXPECT_EQ(starts, (std::vector<std::int32_t>{ 0, 4, 6, 7, 8, 9, 11 }));
+}
@@ -0,0 +1,43 @@
+#include "vm_program.hpp"
+
+extern "C"
+{
+#include <vm_hook.h>
+}
+
+#include <cstdlib>
+#include <cstring>
+
+void load(vm_t& vm, std::vector<std::int32_t> const& code)
+{
+  vm                 = {};
+  vm.codeSegmentLen  = static_cast<std::int32_t>(code.size() / 2);
+  vm.dataSegmentLen  = 1024;
+  vm.stackSegmentLen = 1 << 16;
+  vm.dataSegmentMask = 1;
+  while (vm.dataSegmentMask <= vm.dataSegmentLen + vm.stackSegmentLen) vm.dataSegmentMask <<= 1;
+  --vm.dataSegmentMask;
+
+  auto const codeSize = static_cast<std::int32_t>(code.size() * sizeof(std::int32_t));
+  vm.memorySize       = codeSize + vm.dataSegmentLen + vm.stackSegmentLen;
+  vm.memory           = static_cast<byte*>(std::calloc(1, vm.memorySize));
+  vm.codeSegment      = reinterpret_cast<std::int32_t*>(vm.memory);
+  vm.dataSegment      = vm.memory + codeSize;
+  vm.stackSegment     = vm.dataSegment + vm.dataSegmentLen;
+  vm.opStack          = reinterpret_cast<std::int32_t*>(vm.stackSegment + vm.stackSegmentLen);
+  vm.opBase           = vm.dataSegmentLen + vm.stackSegmentLen / 2;
+  std::memcpy(vm.codeSegment, code.data(), codeSize);
+  vm.countInstructions = qtrue;
+  init_vm_hooks(&vm);
+}
+
+void unload(vm_t& vm)
+{
+  free_vm_hooks(&vm);
+  std::free(vm.memory);
+}
+
+std::intptr_t run(vm_t& vm)
+{
+  return VM_Exec(&vm, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0);
+}
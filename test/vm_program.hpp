@@ -0,0 +1,39 @@
+#ifndef VM_PROGRAM_HPP
+#define VM_PROGRAM_HPP
+
+extern "C"
+{
+#include <cg_vm.h>
+}
+
+#include <cstdint>
+#include <vector>
+
+// vmMain returns f(7) + 1, f(x) returns x * 2.
+inline std::vector<std::int32_t> const program = {
+  OP_ENTER, 16, // vmMain
+  OP_CONST, 7,
+  OP_ARG,   8,
+  OP_CONST, 8,
+  OP_CALL,  0,
+  OP_CONST, 1,
+  OP_ADD,   0,
+  OP_LEAVE, 16,
+  OP_ENTER, 8, // f
+  OP_LOCAL, 16,
+  OP_LOAD4, 0,
+  OP_CONST, 2,
+  OP_MULI,  0,
+  OP_LEAVE, 8,
+};
+inline std::int32_t const f = 8;
+
+// Lays code (by default the program above) out in memory like VM_Create does, with hooks but without any attached.
+void load(vm_t& vm, std::vector<std::int32_t> const& code = program);
+
+void unload(vm_t& vm);
+
+// Runs vmMain.
+std::intptr_t run(vm_t& vm);
+
+#endif // VM_PROGRAM_HPP
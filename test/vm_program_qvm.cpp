@@ -0,0 +1,57 @@
+// Writes the program of vm_program.hpp as a qvm, for qvmtool aot to translate at build time.
+//
+// usage: VmProgramQvm <file>
+#include "vm_program.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+int main(int argc, char** argv)
+{
+  if (argc != 2)
+  {
+    std::fprintf(stderr, "usage: VmProgramQvm <file>\n");
+    return EXIT_FAILURE;
+  }
+
+  std::vector<byte> code;
+  for (std::size_t i = 0; i < program.size(); i += 2)
+  {
+    auto const op    = static_cast<vmOps_t>(program[i]);
+    auto const param = program[i + 1];
+    code.push_back(static_cast<byte>(op));
+    if (VM_ParamSize(op) == 4)
+    {
+      byte bytes[4];
+      std::memcpy(bytes, &param, sizeof(bytes));
+      code.insert(code.end(), bytes, bytes + sizeof(bytes));
+    }
+    else if (VM_ParamSize(op) == 1)
+    {
+      code.push_back(static_cast<byte>(param));
+    }
+  }
+
+  // a single int of data, the image needs some after the code
+  std::int32_t const data = 0;
+
+  vmHeader_t header       = {};
+  header.vmMagic          = VM_MAGIC;
+  header.instructionCount = static_cast<std::int32_t>(program.size() / 2);
+  header.codeOffset       = VM_HEADER_SIZE_VER1;
+  header.codeLength       = static_cast<std::int32_t>(code.size());
+  header.dataOffset       = header.codeOffset + header.codeLength;
+  header.dataLength       = sizeof(data);
+
+  auto* const file = std::fopen(argv[1], "wb");
+  if (!file)
+  {
+    std::fprintf(stderr, "could not open %s\n", argv[1]);
+    return EXIT_FAILURE;
+  }
+  std::fwrite(&header, VM_HEADER_SIZE_VER1, 1, file);
+  std::fwrite(code.data(), code.size(), 1, file);
+  std::fwrite(&data, sizeof(data), 1, file);
+  return std::fclose(file) ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,365 @@
+#include "syscalls_mock.hpp"
+#include "vm_program.hpp"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+using ::testing::_;
+
+namespace
+{
+std::int32_t bits(float f)
+{
+  std::int32_t i;
+  std::memcpy(&i, &f, sizeof(i));
+  return i;
+}
+
+// vmMain returns a op b.
+std::vector<std::int32_t> binary(std::int32_t op, std::int32_t a, std::int32_t b)
+{
+  return {
+    OP_ENTER, 8,
+    OP_CONST, a,
+    OP_CONST, b,
+    op,       0,
+    OP_LEAVE, 8,
+  };
+}
+
+// vmMain returns op a.
+std::vector<std::int32_t> unary(std::int32_t op, std::int32_t a)
+{
+  return {
+    OP_ENTER, 8,
+    OP_CONST, a,
+    op,       0,
+    OP_LEAVE, 8,
+  };
+}
+
+// vmMain returns whether the branch op of a and b is taken.
+std::vector<std::int32_t> branch(std::int32_t op, std::int32_t a, std::int32_t b)
+{
+  return {
+    OP_ENTER, 8,
+    OP_CONST, a,
+    OP_CONST, b,
+    op,       6,
+    OP_CONST, 0,
+    OP_LEAVE, 8,
+    OP_CONST, 1, // 6
+    OP_LEAVE, 8,
+  };
+}
+
+// vmMain stores v with each width and returns the sum of the loads.
+std::vector<std::int32_t> loadStore(std::int32_t v)
+{
+  return {
+    OP_ENTER,  8,
+    OP_CONST,  100,
+    OP_CONST,  v,
+    OP_STORE4, 0,
+    OP_CONST,  104,
+    OP_CONST,  v,
+    OP_STORE2, 0,
+    OP_CONST,  106,
+    OP_CONST,  v,
+    OP_STORE1, 0,
+    OP_CONST,  100,
+    OP_LOAD1,  0,
+    OP_CONST,  104,
+    OP_LOAD2,  0,
+    OP_ADD,    0,
+    OP_CONST,  106,
+    OP_LOAD1,  0,
+    OP_ADD,    0,
+    OP_CONST,  100,
+    OP_LOAD4,  0,
+    OP_ADD,    0,
+    OP_LEAVE,  8,
+  };
+}
+
+// vmMain sums 10 down to 1 in locals, looping with a computed jump.
+std::vector<std::int32_t> const loop = {
+  OP_ENTER,  16,
+  OP_LOCAL,  8,
+  OP_CONST,  0,
+  OP_STORE4, 0,
+  OP_LOCAL,  12,
+  OP_CONST,  10,
+  OP_STORE4, 0,
+  OP_LOCAL,  8, // 7
+  OP_LOCAL,  8,
+  OP_LOAD4,  0,
+  OP_LOCAL,  12,
+  OP_LOAD4,  0,
+  OP_ADD,    0,
+  OP_STORE4, 0,
+  OP_LOCAL,  12,
+  OP_LOCAL,  12,
+  OP_LOAD4,  0,
+  OP_CONST,  1,
+  OP_SUB,    0,
+  OP_STORE4, 0,
+  OP_PUSH,   0,
+  OP_POP,    0,
+  OP_LOCAL,  12,
+  OP_LOAD4,  0,
+  OP_CONST,  0,
+  OP_LEI,    28,
+  OP_CONST,  7,
+  OP_JUMP,   0,
+  OP_LOCAL,  8, // 28
+  OP_LOAD4,  0,
+  OP_LEAVE,  16,
+};
+
+// vmMain returns fact(5), fact(n) calls itself.
+std::vector<std::int32_t> const fact = {
+  OP_ENTER, 16,
+  OP_CONST, 5,
+  OP_ARG,   8,
+  OP_CONST, 6,
+  OP_CALL,  0,
+  OP_LEAVE, 16,
+  OP_ENTER, 16, // 6
+  OP_LOCAL, 24,
+  OP_LOAD4, 0,
+  OP_CONST, 1,
+  OP_GTI,   13,
+  OP_CONST, 1,
+  OP_LEAVE, 16,
+  OP_LOCAL, 24, // 13
+  OP_LOAD4, 0,
+  OP_CONST, 1,
+  OP_SUB,   0,
+  OP_ARG,   8,
+  OP_CONST, 6,
+  OP_CALL,  0,
+  OP_LOCAL, 24,
+  OP_LOAD4, 0,
+  OP_MULI,  0,
+  OP_LEAVE, 16,
+};
+
+// vmMain returns 100 + f(7), the 100 stays on the operand stack across the call.
+std::vector<std::int32_t> const acrossCall = {
+  OP_ENTER, 16,
+  OP_CONST, 100,
+  OP_CONST, 7,
+  OP_ARG,   8,
+  OP_CONST, 8,
+  OP_CALL,  0,
+  OP_ADD,   0,
+  OP_LEAVE, 16,
+  OP_ENTER, 8, // 8
+  OP_LOCAL, 16,
+  OP_LOAD4, 0,
+  OP_CONST, 2,
+  OP_MULI,  0,
+  OP_LEAVE, 8,
+};
+
+// vmMain copies n bytes from from to to and returns the int at to.
+std::vector<std::int32_t> blockCopy(std::int32_t to, std::int32_t from, std::int32_t n)
+{
+  return {
+    OP_ENTER,      8,
+    OP_CONST,      to,
+    OP_CONST,      from,
+    OP_BLOCK_COPY, n,
+    OP_CONST,      to,
+    OP_LOAD4,      0,
+    OP_LEAVE,      8,
+  };
+}
+
+// Runs code with VM_Run and with VM_RunTos.
+class VmRun : public testing::Test
+{
+protected:
+  void TearDown() override
+  {
+    unload(vm_);
+  }
+
+  std::intptr_t run(std::vector<std::int32_t> const& code, qboolean cacheTos, std::int32_t from, std::int32_t value)
+  {
+    unload(vm_);
+    load(vm_, code);
+    vm_.cacheTos = cacheTos;
+    if (from >= 0) at(from) = value;
+    return ::run(vm_);
+  }
+
+  std::int32_t& at(std::int32_t address)
+  {
+    return *reinterpret_cast<std::int32_t*>(vm_.dataSegment + address);
+  }
+
+  // Runs code with both interpreters and expects them to return the same, leave the operand stack where it was and
+  // the memory the same. Returns the result.
+  std::intptr_t same(std::vector<std::int32_t> const& code)
+  {
+    auto const result       = run(code, qfalse, -1, 0);
+    auto const opStack      = vm_.opStack - reinterpret_cast<std::int32_t*>(vm_.dataSegment);
+    auto const instructions = vm_.instructionsExecuted;
+    auto const memory       = std::vector<byte>(vm_.dataSegment, vm_.dataSegment + size - operandStack);
+
+    EXPECT_EQ(run(code, qtrue, -1, 0), result);
+    EXPECT_EQ(vm_.opStack - reinterpret_cast<std::int32_t*>(vm_.dataSegment), opStack);
+    EXPECT_EQ(vm_.instructionsExecuted, instructions);
+    EXPECT_TRUE(std::equal(memory.cbegin(), memory.cend(), vm_.dataSegment));
+    return result;
+  }
+
+  static constexpr std::int32_t size = 1024 + (1 << 16); // the data segment and the stack of load
+
+  // Popped values stay in memory with VM_Run only, the operand stacks of the programs here stay within this much at
+  // the end of the stack.
+  static constexpr std::int32_t operandStack = 256;
+
+  vm_t vm_ = {};
+};
+} // namespace
+
+TEST_F(VmRun, BlockCopy)
+{
+  for (auto const cacheTos : { qfalse, qtrue })
+  {
+    EXPECT_EQ(run(blockCopy(16, 0, 8), cacheTos, 0, 1), 1);
+    EXPECT_EQ(run(blockCopy(16, 1020, 8), cacheTos, 1020, 2), 2); // into the stack
+    EXPECT_EQ(run(blockCopy(1020, 0, 8), cacheTos, 0, 3), 3);
+  }
+}
+
+TEST_F(VmRun, BlockCopyOutOfRange)
+{
+  SyscallsMock mock;
+  EXPECT_CALL(mock, CL_OtherSystemCalls(CG_ERROR, _)).Times(8);
+
+  for (auto const cacheTos : { qfalse, qtrue })
+  {
+    EXPECT_EQ(run(blockCopy(16, size - 4, 8), cacheTos, size - 4, 1), 0);
+    EXPECT_EQ(run(blockCopy(16, -4, 8), cacheTos, 0, 1), 0);
+    EXPECT_EQ(run(blockCopy(16, 0, -8), cacheTos, 0, 1), 0);
+    EXPECT_EQ(run(blockCopy(16, 0, 6), cacheTos, 0, 1), 0);
+    // trap_Error returns in the tests, the copy must not have been made either way
+    EXPECT_EQ(at(16), 0);
+  }
+}
+
+TEST_F(VmRun, SameArithmetic)
+{
+  auto const min = std::numeric_limits<std::int32_t>::min();
+  auto const max = std::numeric_limits<std::int32_t>::max();
+
+  for (auto const op : { OP_ADD,
+                         OP_SUB,
+                         OP_DIVI,
+                         OP_DIVU,
+                         OP_MODI,
+                         OP_MODU,
+                         OP_MULI,
+                         OP_MULU,
+                         OP_BAND,
+                         OP_BOR,
+                         OP_BXOR,
+                         OP_LSH,
+                         OP_RSHI,
+                         OP_RSHU })
+  {
+    for (auto const a : { 7, -7, -1, min, max })
+    {
+      for (auto const b : { 1, 3, 31 }) same(binary(op, a, b));
+    }
+  }
+  EXPECT_EQ(same(binary(OP_SUB, 7, 3)), 4);
+  EXPECT_EQ(same(binary(OP_DIVI, -7, 3)), -2);
+  EXPECT_EQ(same(binary(OP_RSHU, -1, 31)), 1);
+
+  for (auto const op : { OP_SEX8, OP_SEX16, OP_NEGI, OP_BCOM, OP_CVIF })
+  {
+    for (auto const a : { 0, 0x7F, 0x80, 0x8000, 0x12345678, -5, min }) same(unary(op, a));
+  }
+  EXPECT_EQ(same(unary(OP_SEX8, 0x80)), -128);
+  EXPECT_EQ(same(unary(OP_CVIF, 3)), bits(3.f));
+}
+
+TEST_F(VmRun, SameFloat)
+{
+  for (auto const op : { OP_ADDF, OP_SUBF, OP_DIVF, OP_MULF })
+  {
+    for (auto const a : { 1.5f, -2.25f, 0.f, 1e30f })
+    {
+      for (auto const b : { 1.5f, -3.f, 1e-30f }) same(binary(op, bits(a), bits(b)));
+    }
+  }
+  EXPECT_EQ(same(binary(OP_SUBF, bits(1.5f), bits(-3.f))), bits(4.5f));
+
+  for (auto const op : { OP_NEGF, OP_CVFI })
+  {
+    for (auto const a : { 1.5f, -2.25f, 0.f, 100.75f }) same(unary(op, bits(a)));
+  }
+  EXPECT_EQ(same(unary(OP_CVFI, bits(-2.25f))), -2);
+}
+
+TEST_F(VmRun, SameBranches)
+{
+  for (auto const op : { OP_EQ, OP_NE, OP_LTI, OP_LEI, OP_GTI, OP_GEI, OP_LTU, OP_LEU, OP_GTU, OP_GEU })
+  {
+    for (auto const a : { -1, 0, 1 })
+    {
+      for (auto const b : { -1, 0, 1 }) same(branch(op, a, b));
+    }
+  }
+  EXPECT_EQ(same(branch(OP_LTI, -1, 0)), 1);
+  EXPECT_EQ(same(branch(OP_LTU, -1, 0)), 0);
+
+  for (auto const op : { OP_EQF, OP_NEF, OP_LTF, OP_LEF, OP_GTF, OP_GEF })
+  {
+    for (auto const a : { -1.5f, 0.f, 1.5f })
+    {
+      for (auto const b : { -1.5f, 0.f, 1.5f }) same(branch(op, bits(a), bits(b)));
+    }
+  }
+  EXPECT_EQ(same(branch(OP_GEF, bits(1.5f), bits(1.5f))), 1);
+}
+
+TEST_F(VmRun, SameMemory)
+{
+  for (auto const v : { 0, 1, 0x7F, 0x80, 0xFFFF, 0x12345678, -1 }) same(loadStore(v));
+  EXPECT_EQ(same(loadStore(0x01020304)), 0x01020304 + 0x04 + 0x0304 + 0x04);
+
+  EXPECT_EQ(same(blockCopy(16, 0, 8)), 0);
+  EXPECT_EQ(same(blockCopy(1020, 100, 64)), 0);
+}
+
+TEST_F(VmRun, SameControlFlow)
+{
+  EXPECT_EQ(same(program), 15);
+  EXPECT_EQ(same(loop), 55);
+  EXPECT_EQ(same(fact), 120);
+  EXPECT_EQ(same(acrossCall), 114);
+}
+
+TEST_F(VmRun, InvalidOpcode)
+{
+  SyscallsMock mock;
+  EXPECT_CALL(mock, CL_OtherSystemCalls(CG_ERROR, _)).Times(4);
+
+  for (auto const cacheTos : { qfalse, qtrue })
+  {
+    // 64 + OP_NEGI is the handler of OP_NEGI in the cached state of VM_RunTos, -1 is below every handler
+    EXPECT_EQ(run({ OP_ENTER, 8, 64 + OP_NEGI, 0, OP_CONST, 5, OP_LEAVE, 8 }, cacheTos, -1, 0), 5);
+    EXPECT_EQ(run({ OP_ENTER, 8, -1, 0, OP_CONST, 5, OP_LEAVE, 8 }, cacheTos, -1, 0), 5);
+  }
+}
@@ -0,0 +1,761 @@
+/*
+  ==============================
+  This file is part of mdd client proxymod.
+
+  mdd client proxymod is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  mdd client proxymod is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with mdd client proxymod.  If not, see <http://www.gnu.org/licenses/>.
+  ==============================
+*/
+#include "cg_syscall.h"
+#include "cg_vm.h"
+#include "defrag.h"
+#include "vm_aot.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+// Static analysis of a cgame.qvm: disassembly, functions, basic blocks, call graph and opcode statistics. It loads
+// the image with the same code as the proxymod and can locate the defrag_t offsets of a new defrag release by matching
+// its code against a supported one.
+
+#define OP_COUNT (OP_CVFI + 1)
+
+// the translations are built from the output of qvmtool, so there are none in qvmtool itself
+vmAot_t const* const vm_aot_table[] = { NULL };
+
+// in the order of vmOps_t
+static char const* const opNames[OP_COUNT] = {
+  "UNDEF",      "NOP",        "BREAK",      "ENTER",      "LEAVE",      "CALL",       "PUSH",       "POP",
+  "CONST",      "LOCAL",      "JUMP",       "EQ",         "NE",         "LTI",        "LEI",        "GTI",
+  "GEI",        "LTU",        "LEU",        "GTU",        "GEU",        "EQF",        "NEF",        "LTF",
+  "LEF",        "GTF",        "GEF",        "LOAD1",      "LOAD2",      "LOAD4",      "STORE1",     "STORE2",
+  "STORE4",     "ARG",        "BLOCK_COPY", "SEX8",       "SEX16",      "NEGI",       "ADD",        "SUB",
+  "DIVI",       "DIVU",       "MODI",       "MODU",       "MULI",       "MULU",       "BAND",       "BOR",
+  "BXOR",       "BCOM",       "LSH",        "RSHI",       "RSHU",       "NEGF",       "ADDF",       "SUBF",
+  "DIVF",       "MULF",       "CVIF",       "CVFI",
+};
+
+enum
+{
+  FUNCTION = 1 << 0, // starts a function (OP_ENTER)
+  BLOCK    = 1 << 1, // starts a basic block
+};
+
+typedef struct
+{
+  int32_t caller; // function start
+  int32_t callee; // function start, or -1 - syscall
+} call_t;
+
+typedef struct
+{
+  vmHeader_t* header;
+  int32_t     size;
+  uint32_t    crc32sum;
+  qboolean    swapped;
+
+  int32_t* code; // 2 ints per instruction, as in vm_t
+  int32_t  count;
+  int32_t* jumpTargets; // the jump table of a VM_MAGIC_VER2 image, else every int of the data section
+  int32_t  numJumpTargets;
+  uint8_t* flags;
+  int32_t* function; // start of the function each instruction belongs to
+
+  call_t* calls; // direct calls, sorted and unique
+  int32_t callCount;
+  int32_t indirectCalls;
+} qvm_t;
+
+static char const* op_name(int32_t op)
+{
+  return op >= 0 && op < OP_COUNT ? opNames[op] : "???";
+}
+
+static qboolean is_branch(int32_t op)
+{
+  return op >= OP_EQ && op <= OP_GEF;
+}
+
+static int compare_calls(void const* a, void const* b)
+{
+  call_t const* x = (call_t const*)a;
+  call_t const* y = (call_t const*)b;
+  if (x->caller != y->caller) return (x->caller > y->caller) - (x->caller < y->caller);
+  return (x->callee > y->callee) - (x->callee < y->callee);
+}
+
+static void analyze(qvm_t* vm)
+{
+  int32_t const* code = vm->code;
+  int32_t const  n    = vm->count;
+
+  vm->flags    = calloc(n, sizeof(*vm->flags));
+  vm->function = calloc(n, sizeof(*vm->function));
+  vm->calls    = calloc(n, sizeof(*vm->calls));
+  if (!vm->flags || !vm->function || !vm->calls)
+  {
+    fprintf(stderr, "out of memory\n");
+    exit(EXIT_FAILURE);
+  }
+
+  uint32_t* const blocks = calloc((n + 31) / 32, sizeof(*blocks));
+  if (!blocks)
+  {
+    fprintf(stderr, "out of memory\n");
+    exit(EXIT_FAILURE);
+  }
+  VM_FindBlocks(blocks, code, n, vm->jumpTargets, vm->numJumpTargets);
+  vm->flags[0] |= FUNCTION;
+  for (int32_t i = 0; i < n; ++i)
+  {
+    if (code[2 * i] == OP_ENTER) vm->flags[i] |= FUNCTION;
+    if (VM_IS_BLOCK(blocks, i)) vm->flags[i] |= BLOCK;
+  }
+  free(blocks);
+
+  int32_t start = 0;
+  for (int32_t i = 0; i < n; ++i)
+  {
+    if (vm->flags[i] & FUNCTION) start = i;
+    vm->function[i] = start;
+
+    if (code[2 * i] != OP_CALL) continue;
+    int32_t const target = i && code[2 * (i - 1)] == OP_CONST ? code[2 * (i - 1) + 1] : INT32_MIN;
+    if (target == INT32_MIN || target >= n)
+    {
+      ++vm->indirectCalls;
+      continue;
+    }
+    vm->calls[vm->callCount].caller   = start;
+    vm->calls[vm->callCount++].callee = target;
+  }
+
+  qsort(vm->calls, vm->callCount, sizeof(*vm->calls), compare_calls);
+  int32_t unique = 0;
+  for (int32_t i = 0; i < vm->callCount; ++i)
+  {
+    if (!unique || compare_calls(&vm->calls[unique - 1], &vm->calls[i])) vm->calls[unique++] = vm->calls[i];
+  }
+  vm->callCount = unique;
+}
+
+static qboolean load(qvm_t* vm, char const* path)
+{
+  memset(vm, 0, sizeof(*vm));
+
+  FILE* f = fopen(path, "rb");
+  if (!f)
+  {
+    fprintf(stderr, "could not open %s\n", path);
+    return qfalse;
+  }
+  fseek(f, 0, SEEK_END);
+  vm->size = (int32_t)ftell(f);
+  fseek(f, 0, SEEK_SET);
+  vm->header = malloc(vm->size > 0 ? vm->size : 1);
+  if (!vm->header || fread(vm->header, 1, vm->size, f) != (size_t)vm->size)
+  {
+    fprintf(stderr, "could not read %s\n", path);
+    fclose(f);
+    return qfalse;
+  }
+  fclose(f);
+
+  char const* errorMsg = VM_ValidateHeader(vm->header, vm->size, &vm->swapped);
+  if (errorMsg)
+  {
+    fprintf(stderr, "%s: %s\n", path, errorMsg);
+    return qfalse;
+  }
+  vm->crc32sum = crc32_reflect((byte const*)vm->header, vm->size);
+
+  vm->count = vm->header->instructionCount;
+  vm->code  = malloc(vm->count * sizeof(int32_t) * 2);
+  if (!vm->code)
+  {
+    fprintf(stderr, "out of memory\n");
+    return qfalse;
+  }
+  if (!VM_LoadInstructions(vm->code, vm->header, vm->swapped))
+  {
+    fprintf(stderr, "%s: truncated code segment\n", path);
+    return qfalse;
+  }
+
+  // the targets computed jumps may have
+  vmHeader_t const* h      = vm->header;
+  qboolean const    v2     = h->vmMagic == VM_MAGIC_VER2;
+  int32_t const     length = v2 ? h->jtrgLength : h->dataLength;
+  vm->numJumpTargets       = length / sizeof(int32_t);
+  vm->jumpTargets          = malloc(length > 0 ? length : 1);
+  if (!vm->jumpTargets)
+  {
+    fprintf(stderr, "out of memory\n");
+    return qfalse;
+  }
+  memcpy(vm->jumpTargets, (byte const*)h + h->dataOffset + (v2 ? h->dataLength + h->litLength : 0), length);
+  for (int32_t i = 0; vm->swapped && i < vm->numJumpTargets; ++i) vm->jumpTargets[i] = LongSwap(vm->jumpTargets[i]);
+  analyze(vm);
+  return qtrue;
+}
+
+// the string a constant points to, when it points into the lit segment
+static char const* lit_string(qvm_t const* vm, int32_t address)
+{
+  static char       str[48];
+  vmHeader_t const* h = vm->header;
+  if (address < h->dataLength || address >= h->dataLength + h->litLength) return NULL;
+
+  char const* src = (char const*)h + h->dataOffset + address;
+  char const* end = (char const*)h + h->dataOffset + h->dataLength + h->litLength;
+  size_t      len = 0;
+  for (; src < end && *src && len < sizeof(str) - 5; ++src)
+  {
+    if (*src == '\n')
+    {
+      str[len++] = '\\';
+      str[len++] = 'n';
+    }
+    else
+    {
+      str[len++] = *src >= ' ' && *src < 127 ? *src : '.';
+    }
+  }
+  if (src < end && *src) len += snprintf(str + len, sizeof(str) - len, "...");
+  str[len] = '\0';
+  return str;
+}
+
+static void info(qvm_t const* vm)
+{
+  vmHeader_t const* h             = vm->header;
+  defrag_t const*   df            = find_defrag(vm->crc32sum);
+  int32_t           functionCount = 0, blockCount = 0;
+  for (int32_t i = 0; i < vm->count; ++i)
+  {
+    functionCount += !!(vm->flags[i] & FUNCTION);
+    blockCount += !!(vm->flags[i] & BLOCK);
+  }
+
+  printf("crc32sum      0x%08X (%s)\n", vm->crc32sum, df ? df->name : "unsupported defrag version");
+  printf("instructions  %i (%i bytes)\n", h->instructionCount, h->codeLength);
+  printf("data          %i bytes\n", h->dataLength);
+  printf("lit           %i bytes\n", h->litLength);
+  printf("bss           %i bytes\n", h->bssLength);
+  if (h->vmMagic == VM_MAGIC_VER2) printf("jump table    %i targets\n", vm->numJumpTargets);
+  printf("functions     %i\n", functionCount);
+  printf("basic blocks  %i%s\n", blockCount, h->vmMagic == VM_MAGIC_VER2 ? "" : " (at most, no jump table)");
+  printf("direct calls  %i distinct, %i indirect call sites\n", vm->callCount, vm->indirectCalls);
+}
+
+static void disasm(qvm_t const* vm)
+{
+  for (int32_t i = 0; i < vm->count; ++i)
+  {
+    int32_t const op    = vm->code[2 * i];
+    int32_t const param = vm->code[2 * i + 1];
+    if (vm->flags[i] & FUNCTION)
+      printf("\nfunction_%08x:\n", i);
+    else if (vm->flags[i] & BLOCK)
+      printf("block_%08x:\n", i);
+
+    printf("  %08x  %-10s", i, op_name(op));
+    switch (op)
+    {
+    case OP_ENTER:
+    case OP_LEAVE:
+    case OP_LOCAL:
+    case OP_ARG:
+    case OP_BLOCK_COPY:
+      printf(" %i", param);
+      break;
+
+    case OP_CONST:
+    {
+      int32_t const next = i + 1 < vm->count ? vm->code[2 * (i + 1)] : OP_UNDEF;
+      char const*   str  = lit_string(vm, param);
+      if (next == OP_CALL && param < 0)
+        printf(" %i ; %s", param, syscall_name(-param - 1));
+      else if (next == OP_CALL || next == OP_JUMP)
+        printf(" 0x%08x", param);
+      else if (str)
+        printf(" 0x%08x ; \"%s\"", param, str);
+      else
+        printf(" 0x%08x ; %i", param, param);
+      break;
+    }
+
+    default:
+      if (is_branch(op)) printf(" 0x%08x", param);
+      break;
+    }
+    printf("\n");
+  }
+}
+
+static void functions(qvm_t const* vm)
+{
+  printf("function    instructions  blocks  frame  calls  callers\n");
+  int32_t first = 0; // calls are sorted by caller
+  for (int32_t start = 0; start < vm->count;)
+  {
+    int32_t end    = start + 1;
+    int32_t blocks = 1;
+    for (; end < vm->count && !(vm->flags[end] & FUNCTION); ++end) blocks += !!(vm->flags[end] & BLOCK);
+
+    int32_t calls = 0, callers = 0;
+    while (first < vm->callCount && vm->calls[first].caller < start) ++first;
+    for (int32_t i = first; i < vm->callCount && vm->calls[i].caller == start; ++i) ++calls;
+    for (int32_t i = 0; i < vm->callCount; ++i) callers += vm->calls[i].callee == start;
+
+    int32_t const frame = vm->code[2 * start] == OP_ENTER ? vm->code[2 * start + 1] : 0;
+    printf("0x%08x  %12i  %6i  %5i  %5i  %7i\n", start, end - start, blocks, frame, calls, callers);
+    start = end;
+  }
+}
+
+static void callgraph(qvm_t const* vm)
+{
+  // graphviz, e.g. qvmtool callgraph cgame.qvm | dot -Tsvg > cgame.svg
+  printf("digraph qvm {\n");
+  for (int32_t i = 0; i < vm->callCount; ++i)
+  {
+    call_t const* c = &vm->calls[i];
+    if (c->callee >= 0)
+      printf("  f%08x -> f%08x;\n", c->caller, c->callee);
+    else
+      printf("  f%08x -> %s;\n", c->caller, syscall_name(-c->callee - 1));
+  }
+  printf("}\n");
+}
+
+typedef struct
+{
+  int32_t  op;
+  uint32_t count;
+} opCount_t;
+
+static int compare_counts(void const* a, void const* b)
+{
+  uint32_t const x = ((opCount_t const*)a)->count;
+  uint32_t const y = ((opCount_t const*)b)->count;
+  return (x < y) - (x > y);
+}
+
+static void stats(qvm_t const* vm)
+{
+  static opCount_t ops[OP_COUNT + 1];
+  static opCount_t pairs[(OP_COUNT + 1) * (OP_COUNT + 1)];
+  for (int32_t op = 0; op <= OP_COUNT; ++op) ops[op].op = op;
+  for (int32_t pair = 0; pair < (OP_COUNT + 1) * (OP_COUNT + 1); ++pair) pairs[pair].op = pair;
+
+  // invalid opcodes all count as OP_COUNT, pairs only within a basic block since only those could be fused
+  int32_t prev = -1;
+  for (int32_t i = 0; i < vm->count; ++i)
+  {
+    int32_t op = vm->code[2 * i];
+    if (op < 0 || op > OP_COUNT) op = OP_COUNT;
+    ++ops[op].count;
+    if (prev >= 0 && !(vm->flags[i] & BLOCK)) ++pairs[prev * (OP_COUNT + 1) + op].count;
+    prev = op;
+  }
+  qsort(ops, OP_COUNT + 1, sizeof(*ops), compare_counts);
+  qsort(pairs, (OP_COUNT + 1) * (OP_COUNT + 1), sizeof(*pairs), compare_counts);
+
+  printf("static opcode frequencies, %i instructions\n", vm->count);
+  for (int32_t i = 0; i <= OP_COUNT && ops[i].count; ++i)
+  {
+    printf("  %-10s %8u  %5.2f%%\n", op_name(ops[i].op), ops[i].count, 100. * ops[i].count / vm->count);
+  }
+
+  printf("\nmost frequent pairs within a basic block\n");
+  for (int32_t i = 0; i < 40 && pairs[i].count; ++i)
+  {
+    int32_t const a = pairs[i].op / (OP_COUNT + 1);
+    int32_t const b = pairs[i].op % (OP_COUNT + 1);
+    printf("  %-10s %-10s %8u  %5.2f%%\n", op_name(a), op_name(b), pairs[i].count, 100. * pairs[i].count / vm->count);
+  }
+}
+
+// Instructions match when their opcodes do and their parameters can't have moved between releases, i.e. they are
+// not code or data addresses.
+static qboolean same_instruction(qvm_t const* a, int32_t i, qvm_t const* b, int32_t j)
+{
+  int32_t const op = a->code[2 * i];
+  if (op != b->code[2 * j]) return qfalse;
+  switch (op)
+  {
+  case OP_ENTER:
+  case OP_LEAVE:
+  case OP_LOCAL:
+  case OP_ARG:
+  case OP_BLOCK_COPY:
+    return a->code[2 * i + 1] == b->code[2 * j + 1];
+  default:
+    return qtrue;
+  }
+}
+
+// The instruction of b at the same place as instruction i of a, found by matching a growing window of code around
+// it. -1 if there's none, -2 if it's still ambiguous.
+static int32_t match(qvm_t const* a, int32_t i, qvm_t const* b)
+{
+  for (int32_t w = 8; w <= 512; w *= 2)
+  {
+    int32_t const before = i < w / 2 ? i : w / 2;
+    int32_t const after  = a->count - i < w / 2 ? a->count - i : w / 2;
+    int32_t       found  = -1;
+    int32_t       n      = 0;
+    for (int32_t j = before; j + after <= b->count; ++j)
+    {
+      int32_t k = -before;
+      while (k < after && same_instruction(a, i + k, b, j + k)) ++k;
+      if (k < after) continue;
+      found = j;
+      if (++n > 1) break;
+    }
+    if (n <= 1) return found;
+  }
+  return -2;
+}
+
+static int32_t locate_code(qvm_t const* ref, int32_t offset, qvm_t const* vm)
+{
+  int32_t const j = match(ref, offset, vm);
+  if (j == -1) fprintf(stderr, "0x%08x: no match\n", offset);
+  if (j == -2) fprintf(stderr, "0x%08x: ambiguous\n", offset);
+  return j;
+}
+
+// data addresses are found through the constants referring to them, the offset most of them agree on wins
+static int32_t locate_data(qvm_t const* ref, int32_t offset, int32_t size, qvm_t const* vm)
+{
+  int32_t* const candidates = malloc(ref->count * sizeof(int32_t));
+  int32_t        n = 0, total = 0;
+  for (int32_t i = 0; candidates && i < ref->count; ++i)
+  {
+    int32_t const field = ref->code[2 * i + 1] - offset;
+    if (ref->code[2 * i] != OP_CONST || field < 0 || field >= size) continue;
+
+    ++total;
+    int32_t const j = match(ref, i, vm);
+    if (j >= 0) candidates[n++] = vm->code[2 * j + 1] - field;
+  }
+
+  int32_t best = -1, votes = 0;
+  for (int32_t i = 0; i < n; ++i)
+  {
+    int32_t count = 0;
+    for (int32_t k = 0; k < n; ++k) count += candidates[k] == candidates[i];
+    if (count > votes)
+    {
+      best  = candidates[i];
+      votes = count;
+    }
+  }
+  free(candidates);
+
+  fprintf(stderr, "0x%08x: %i of %i references agree\n", offset, votes, total);
+  return best;
+}
+
+static void locate(qvm_t const* vm, qvm_t const* ref)
+{
+  defrag_t const* df = find_defrag(ref->crc32sum);
+  if (!df)
+  {
+    fprintf(stderr, "the reference 0x%08X is not a supported defrag version\n", ref->crc32sum);
+    return;
+  }
+
+  int32_t const pps     = locate_data(ref, df->pps_offset, sizeof(playerState_t), vm);
+  int32_t const draw2d  = locate_code(ref, df->cg_draw2d_defrag, vm);
+  int32_t const vanilla = locate_code(ref, df->cg_draw2d_vanilla, vm);
+
+  // in the format of defrag_versions
+  printf("  {\n");
+  printf("    \"?\",        // name\n");
+  printf("    0x%08X, // crc32sum\n", vm->crc32sum);
+  printf("    0x%08X, // pps_offset\n", pps);
+  printf("    0x%08X, // cg_draw2d_defrag (0x%08X)\n", draw2d, draw2d >= 0 ? vm->function[draw2d] : -1);
+  printf("    0x%08X, // cg_draw2d_vanilla (0x%08X)\n", vanilla, vanilla >= 0 ? vm->function[vanilla] : -1);
+  printf("  },\n");
+}
+
+// Translation to C for the build, see vm_aot.h. Each function becomes a C function over the macros of vm_aot.h,
+// branches become gotos and computed jumps (the switch statements of the qvm) a switch over the possible targets: the
+// jump table of a VM_MAGIC_VER2 image, else the ints of the data section, where q3lcc puts its switch tables.
+
+enum
+{
+  TARGET = 1 << 0, // of a branch or constant jump
+  CASE   = 1 << 1, // in a jump table
+};
+
+// marks the targets of the branches and constant jumps of [start, end), fails on the ones leaving it
+static qboolean aot_labels(qvm_t const* vm, int32_t start, int32_t end, uint8_t* label, qboolean* computed)
+{
+  int32_t const* code = vm->code;
+  *computed           = qfalse;
+  for (int32_t i = start; i < end; ++i)
+  {
+    int32_t const op     = code[2 * i];
+    int32_t       target = code[2 * i + 1];
+    if (op == OP_JUMP)
+    {
+      if (i == start || code[2 * (i - 1)] != OP_CONST)
+      {
+        *computed = qtrue;
+        continue;
+      }
+      target = code[2 * (i - 1) + 1];
+    }
+    else if (!is_branch(op))
+    {
+      continue;
+    }
+
+    if (target < start || target >= end)
+    {
+      fprintf(stderr, "0x%08x: %s to 0x%08x leaves the function 0x%08x\n", i, op_name(op), target, start);
+      return qfalse;
+    }
+    label[target] |= TARGET;
+  }
+  return qtrue;
+}
+
+static void aot_instruction(qvm_t const* vm, int32_t i, int32_t start, int32_t end, uint8_t const* label, FILE* f)
+{
+  static char const* const compare[] = { "==", "!=", "<", "<=", ">", ">=" };
+
+  int32_t const  op       = vm->code[2 * i];
+  int32_t const  param    = vm->code[2 * i + 1];
+  qboolean const constant = i > start && vm->code[2 * (i - 1)] == OP_CONST;
+  int32_t const  target   = constant ? vm->code[2 * (i - 1) + 1] : 0;
+  switch (op)
+  {
+  case OP_ENTER: fprintf(f, "  AOT_ENTER(%i);\n", param); break;
+  case OP_LEAVE: fprintf(f, "  AOT_LEAVE(%i);\n", param); break;
+  case OP_CALL:
+    // the return address is the pc VM_Run would save
+    if (constant && target >= 0 && target < vm->count && vm->code[2 * target] == OP_ENTER)
+      fprintf(f, "  AOT_CALL_DIRECT(f_%x, %i);\n", target, 2 * (i + 1));
+    else
+      fprintf(f, "  AOT_CALL(%i);\n", 2 * (i + 1));
+    break;
+  case OP_PUSH: fprintf(f, "  AOT_PUSH();\n"); break;
+  case OP_POP: fprintf(f, "  AOT_POP();\n"); break;
+  case OP_CONST: fprintf(f, "  AOT_CONST(%i);\n", param); break;
+  case OP_LOCAL: fprintf(f, "  AOT_LOCAL(%i);\n", param); break;
+  case OP_JUMP:
+    if (constant)
+    {
+      fprintf(f, "  AOT_JUMP(l_%x);\n", target);
+      break;
+    }
+    fprintf(f, "  switch (*opStack++)\n  {\n");
+    for (int32_t j = start; j < end; ++j)
+    {
+      if (label[j] & CASE) fprintf(f, "  case %i: goto l_%x;\n", j, j);
+    }
+    fprintf(f, "  default: return vm_aot_bad_address(vm, opStack[-1], opStack);\n  }\n");
+    break;
+  case OP_EQ:
+  case OP_NE:
+  case OP_LTI:
+  case OP_LEI:
+  case OP_GTI:
+  case OP_GEI: fprintf(f, "  AOT_SOP(%s, l_%x);\n", compare[op - OP_EQ], param); break;
+  case OP_LTU:
+  case OP_LEU:
+  case OP_GTU:
+  case OP_GEU: fprintf(f, "  AOT_UOP(%s, l_%x);\n", compare[op - OP_LTU + 2], param); break;
+  case OP_EQF:
+  case OP_NEF:
+  case OP_LTF:
+  case OP_LEF:
+  case OP_GTF:
+  case OP_GEF: fprintf(f, "  AOT_FOP(%s, l_%x);\n", compare[op - OP_EQF], param); break;
+  case OP_LOAD1: fprintf(f, "  AOT_LOAD(byte);\n"); break;
+  case OP_LOAD2: fprintf(f, "  AOT_LOAD(uint16_t);\n"); break;
+  case OP_LOAD4: fprintf(f, "  AOT_LOAD(int32_t);\n"); break;
+  case OP_STORE1: fprintf(f, "  AOT_STORE(byte, 0xFF);\n"); break;
+  case OP_STORE2: fprintf(f, "  AOT_STORE(uint16_t, 0xFFFF);\n"); break;
+  case OP_STORE4: fprintf(f, "  AOT_STORE(int32_t, -1);\n"); break;
+  case OP_ARG: fprintf(f, "  AOT_ARG(%i);\n", param); break;
+  case OP_BLOCK_COPY: fprintf(f, "  AOT_BLOCK_COPY(%i);\n", param); break;
+  case OP_SEX8: fprintf(f, "  AOT_SEX8();\n"); break;
+  case OP_SEX16: fprintf(f, "  AOT_SEX16();\n"); break;
+  case OP_NEGI: fprintf(f, "  AOT_NEGI();\n"); break;
+  case OP_ADD: fprintf(f, "  AOT_BINARY(+=);\n"); break;
+  case OP_SUB: fprintf(f, "  AOT_BINARY(-=);\n"); break;
+  case OP_DIVI: fprintf(f, "  AOT_BINARY(/=);\n"); break;
+  case OP_DIVU: fprintf(f, "  AOT_UBINARY(/=);\n"); break;
+  case OP_MODI: fprintf(f, "  AOT_BINARY(%%=);\n"); break;
+  case OP_MODU: fprintf(f, "  AOT_UBINARY(%%=);\n"); break;
+  case OP_MULI: fprintf(f, "  AOT_BINARY(*=);\n"); break;
+  case OP_MULU: fprintf(f, "  AOT_UBINARY(*=);\n"); break;
+  case OP_BAND: fprintf(f, "  AOT_BINARY(&=);\n"); break;
+  case OP_BOR: fprintf(f, "  AOT_BINARY(|=);\n"); break;
+  case OP_BXOR: fprintf(f, "  AOT_BINARY(^=);\n"); break;
+  case OP_BCOM: fprintf(f, "  AOT_BCOM();\n"); break;
+  case OP_LSH: fprintf(f, "  AOT_UBINARY(<<=);\n"); break;
+  case OP_RSHI: fprintf(f, "  AOT_BINARY(>>=);\n"); break;
+  case OP_RSHU: fprintf(f, "  AOT_UBINARY(>>=);\n"); break;
+  case OP_NEGF: fprintf(f, "  AOT_NEGF();\n"); break;
+  case OP_ADDF: fprintf(f, "  AOT_FBINARY(+=);\n"); break;
+  case OP_SUBF: fprintf(f, "  AOT_FBINARY(-=);\n"); break;
+  case OP_DIVF: fprintf(f, "  AOT_FBINARY(/=);\n"); break;
+  case OP_MULF: fprintf(f, "  AOT_FBINARY(*=);\n"); break;
+  case OP_CVIF: fprintf(f, "  AOT_CVIF();\n"); break;
+  case OP_CVFI: fprintf(f, "  AOT_CVFI();\n"); break;
+  // VM_Run doesn't execute these either
+  default: fprintf(f, "  return vm_aot_bad_address(vm, %i, opStack); // %s\n", i, op_name(op)); break;
+  }
+}
+
+static qboolean aot(qvm_t const* vm, char const* name, char const* path)
+{
+  defrag_t const* df = find_defrag(vm->crc32sum);
+  if (!df) fprintf(stderr, "0x%08X is not a supported defrag version, its translation won't be used\n", vm->crc32sum);
+  if (vm->code[0] != OP_ENTER)
+  {
+    fprintf(stderr, "the code doesn't start with a function\n");
+    return qfalse;
+  }
+
+  uint8_t* label = calloc(vm->count, sizeof(*label));
+  if (!label)
+  {
+    fprintf(stderr, "out of memory\n");
+    return qfalse;
+  }
+  for (int32_t i = 0; i < vm->numJumpTargets; ++i)
+  {
+    if (vm->jumpTargets[i] >= 0 && vm->jumpTargets[i] < vm->count) label[vm->jumpTargets[i]] |= CASE;
+  }
+
+  FILE* f = fopen(path, "w");
+  if (!f)
+  {
+    fprintf(stderr, "could not open %s\n", path);
+    free(label);
+    return qfalse;
+  }
+  fprintf(f, "// Generated by qvmtool from a qvm with checksum 0x%08X, see vm_aot.h.\n", vm->crc32sum);
+  fprintf(f, "#include \"vm_aot.h\"\n\n");
+  for (int32_t i = 0; i < vm->count; ++i)
+  {
+    if (vm->flags[i] & FUNCTION) fprintf(f, "static int32_t* f_%x(vm_t* vm, int32_t* opStack);\n", i);
+  }
+
+  qboolean ok = qtrue;
+  for (int32_t start = 0, end; ok && start < vm->count; start = end)
+  {
+    for (end = start + 1; end < vm->count && !(vm->flags[end] & FUNCTION); ++end)
+      ;
+
+    qboolean computed;
+    qboolean masked = qfalse;
+    ok              = aot_labels(vm, start, end, label, &computed);
+    for (int32_t i = start; i < end; ++i) masked |= vm->code[2 * i] >= OP_LOAD1 && vm->code[2 * i] <= OP_ARG;
+
+    fprintf(f, "\nstatic int32_t* f_%x(vm_t* vm, int32_t* opStack)\n{\n", start);
+    fprintf(f, "  byte* const data = vm->dataSegment;\n");
+    if (masked) fprintf(f, "  int32_t const mask = vm->dataSegmentMask;\n");
+    for (int32_t i = start; ok && i < end; ++i)
+    {
+      int32_t const op = vm->code[2 * i];
+      if ((label[i] & TARGET) || (computed && (label[i] & CASE))) fprintf(f, "l_%x:;\n", i);
+      if (op == OP_ENTER || op == OP_LEAVE || (df && (i == df->cg_draw2d_defrag || i == df->cg_draw2d_vanilla)))
+      {
+        fprintf(f, "  AOT_HOOK(%i);\n", i);
+      }
+      aot_instruction(vm, i, start, end, label, f);
+    }
+    // running off the end of the function
+    fprintf(f, "  return vm_aot_bad_address(vm, %i, opStack);\n}\n", end);
+  }
+
+  fprintf(f, "\nstatic int32_t* call(vm_t* vm, int32_t address, int32_t* opStack)\n{\n  switch (address)\n  {\n");
+  for (int32_t i = 0; i < vm->count; ++i)
+  {
+    if (vm->flags[i] & FUNCTION) fprintf(f, "  case %i: return f_%x(vm, opStack);\n", i, i);
+  }
+  fprintf(f, "  default: return vm_aot_bad_address(vm, address, opStack);\n  }\n}\n\n");
+  fprintf(f, "extern vmAot_t const vm_aot_%s;\n", name);
+  fprintf(f, "vmAot_t const vm_aot_%s = { 0x%08X, call };\n", name, vm->crc32sum);
+
+  free(label);
+  if (fclose(f) || !ok)
+  {
+    remove(path);
+    return qfalse;
+  }
+  return qtrue;
+}
+
+static void usage(void)
+{
+  fprintf(
+    stderr,
+    "usage: qvmtool <command> <qvm>\n"
+    "  info                  header, checksum and defrag version\n"
+    "  disasm                instructions, split into functions and basic blocks\n"
+    "  functions             size, basic blocks, frame size, calls and callers per function\n"
+    "  callgraph             static call graph in graphviz format\n"
+    "  stats                 static opcode and opcode pair frequencies\n"
+    "  locate <reference>    defrag_t offsets, matched against a supported version\n"
+    "  aot <name> <file>     translation to C for the build, defines vm_aot_<name>\n");
+}
+
+int main(int argc, char** argv)
+{
+  if (argc < 3)
+  {
+    usage();
+    return EXIT_FAILURE;
+  }
+
+  char const* const cmd = argv[1];
+  qvm_t             vm;
+  if (!load(&vm, argv[2])) return EXIT_FAILURE;
+
+  if (!strcmp(cmd, "info"))
+    info(&vm);
+  else if (!strcmp(cmd, "disasm"))
+    disasm(&vm);
+  else if (!strcmp(cmd, "functions"))
+    functions(&vm);
+  else if (!strcmp(cmd, "callgraph"))
+    callgraph(&vm);
+  else if (!strcmp(cmd, "stats"))
+    stats(&vm);
+  else if (!strcmp(cmd, "locate") && argc > 3)
+  {
+    qvm_t ref;
+    if (!load(&ref, argv[3])) return EXIT_FAILURE;
+    locate(&vm, &ref);
+  }
+  else if (!strcmp(cmd, "aot") && argc > 4)
+  {
+    if (!aot(&vm, argv[3], argv[4])) return EXIT_FAILURE;
+  }
+  else
+  {
+    usage();
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}